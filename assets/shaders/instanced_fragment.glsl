@@ -0,0 +1,12 @@
+#version 450 core
+
+in float v_light;
+
+out vec4 result_color;
+
+uniform vec3 color;
+uniform float alpha;
+
+void main() {
+    result_color = vec4(v_light * color, alpha);
+}
@@ -0,0 +1,18 @@
+#version 450 core
+
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec3 normal;
+layout(location = 2) in vec3 instance_offset;
+layout(location = 3) in vec3 instance_scale;
+
+out float v_light;
+
+uniform mat4 projection_view;
+uniform vec3 light_direction;
+
+void main() {
+    vec3 world_position = instance_offset + instance_scale * position;
+
+    v_light = 0.6 + 0.4 * max(0.0, dot(normal, -light_direction));
+    gl_Position = projection_view * vec4(world_position, 1.0);
+}
@@ -0,0 +1,239 @@
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <concepts>
+#include <ctime>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fmt/printf.h>
+#include <fmt/color.h>
+
+#include "types.hpp"
+#include "loaders.hpp"
+#include "allocations.hpp"
+
+namespace tmine_bench {
+
+using namespace tmine;
+
+/// Makes the compiler believe that `value` is used, so the computation of it
+/// can not be thrown away.
+template <class T>
+inline auto do_not_optimize(T const& value) -> void {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/// Measures wall time passed since construction.
+class Stopwatch {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    inline auto get_seconds(this Stopwatch const& self) -> f64 {
+        return std::chrono::duration<f64>{Clock::now() - self.start}.count();
+    }
+
+    inline auto get_nanoseconds(this Stopwatch const& self) -> f64 {
+        return std::chrono::duration<f64, std::nano>{Clock::now() - self.start}
+            .count();
+    }
+
+private:
+    Clock::time_point start{Clock::now()};
+};
+
+/// Distribution of measured values, empty input gives all zeros.
+struct Percentiles {
+    f64 min{0.0};
+    f64 avg{0.0};
+    f64 p50{0.0};
+    f64 p90{0.0};
+    f64 p99{0.0};
+    f64 max{0.0};
+};
+
+/// Nearest-rank percentiles of `values`.
+inline auto percentiles_of(std::vector<f64> values) -> Percentiles {
+    if (values.empty()) {
+        return Percentiles{};
+    }
+
+    std::ranges::sort(values);
+
+    auto const at = [&values](f64 fraction) {
+        auto const rank = (usize) std::ceil(fraction * (f64) values.size());
+        return values[std::max(rank, usize{1}) - 1];
+    };
+
+    auto sum = 0.0;
+
+    for (auto const value : values) {
+        sum += value;
+    }
+
+    return Percentiles{
+        .min = values.front(),
+        .avg = sum / (f64) values.size(),
+        .p50 = at(0.5),
+        .p90 = at(0.9),
+        .p99 = at(0.99),
+        .max = values.back(),
+    };
+}
+
+/// Lowercase name with underscores for CSV and JSON reports, e.g.
+/// "physics_ticks".
+inline auto key_of(std::string_view name) -> std::string {
+    auto key = std::string{name};
+
+    for (auto& symbol : key) {
+        symbol = ' ' == symbol ? '_' : (char) std::tolower(symbol);
+    }
+
+    return key;
+}
+
+/// Writes a text report, such as CSV or JSON, to `path`.
+inline auto write_report(char const* path, std::string_view contents)
+    -> void {
+    write_to_file(
+        path, std::span{(u8 const*) contents.data(), contents.size()}
+    );
+}
+
+/// Iterations of a bench are timed in up to this many equal batches, the
+/// spread between batches shows how noisy the measurement is.
+inline auto constexpr MAX_N_SAMPLES = usize{10};
+
+struct BenchResult {
+    std::string name;
+    usize n_iterations{0};
+    usize n_items{1};
+
+    /// Median wall time of an iteration across samples.
+    f64 nanoseconds_per_iteration{0.0};
+    f64 min_nanoseconds{0.0};
+    f64 mean_nanoseconds{0.0};
+    f64 stddev_nanoseconds{0.0};
+
+    /// Process CPU time of an iteration, exceeds wall time when the body
+    /// runs on several threads.
+    f64 cpu_nanoseconds_per_iteration{0.0};
+    f64 items_per_second{0.0};
+
+    /// Heap allocations of an iteration, zero without
+    /// `TMINE_TRACK_ALLOCATIONS`.
+    f64 allocations_per_iteration{0.0};
+};
+
+/// Results of all benches run so far, in order.
+inline auto bench_results = std::vector<BenchResult>{};
+
+/// Runs `body` once to warm up caches and then measures `n_iterations` runs
+/// of it split into samples. `n_items` is the number of items processed by a
+/// single run of `body` and is used to report the throughput.
+template <std::invocable F>
+inline auto bench(
+    std::string_view name, usize n_iterations, F&& body, usize n_items = 1
+) -> BenchResult {
+    body();
+
+    auto const n_samples = std::clamp(n_iterations, usize{1}, MAX_N_SAMPLES);
+    auto samples = std::vector<f64>{};
+    samples.reserve(n_samples);
+
+    auto const allocations_start = allocations::REGISTRY.get_n_allocations();
+    auto const cpu_start = std::clock();
+    auto n_done = usize{0};
+
+    for (usize i = 0; i < n_samples; ++i) {
+        // Spreads the remainder over the first samples
+        auto const n_batch = n_iterations / n_samples +
+                             (i < n_iterations % n_samples ? 1 : 0);
+        auto const stopwatch = Stopwatch{};
+
+        for (usize j = 0; j < n_batch; ++j) {
+            body();
+        }
+
+        samples.push_back(
+            stopwatch.get_nanoseconds() / (f64) std::max(n_batch, usize{1})
+        );
+        n_done += n_batch;
+    }
+
+    auto const cpu_elapsed = 1.0e9 * (f64) (std::clock() - cpu_start) /
+                             (f64) CLOCKS_PER_SEC;
+    auto const n_allocations =
+        allocations::REGISTRY.get_n_allocations() - allocations_start;
+
+    auto sum = 0.0;
+
+    for (auto const sample : samples) {
+        sum += sample;
+    }
+
+    auto const mean = sum / (f64) n_samples;
+    auto variance = 0.0;
+
+    for (auto const sample : samples) {
+        variance += (sample - mean) * (sample - mean);
+    }
+
+    variance /= (f64) std::max(n_samples - 1, usize{1});
+
+    std::ranges::sort(samples);
+
+    auto const median =
+        0 == n_samples % 2
+            ? 0.5 * (samples[n_samples / 2 - 1] + samples[n_samples / 2])
+            : samples[n_samples / 2];
+
+    auto result = BenchResult{
+        .name = std::string{name},
+        .n_iterations = n_done,
+        .n_items = n_items,
+        .nanoseconds_per_iteration = median,
+        .min_nanoseconds = samples.front(),
+        .mean_nanoseconds = mean,
+        .stddev_nanoseconds = std::sqrt(variance),
+        .cpu_nanoseconds_per_iteration =
+            cpu_elapsed / (f64) std::max(n_done, usize{1}),
+        .items_per_second = 1.0e9 * (f64) n_items / median,
+        .allocations_per_iteration =
+            (f64) n_allocations / (f64) std::max(n_done, usize{1}),
+    };
+
+    fmt::print(stderr, "bench {:.<56}", name);
+    fmt::print(
+        stderr, fmt::fg(fmt::color::lime_green), " {:>14.1f} ns/iter",
+        result.nanoseconds_per_iteration
+    );
+    fmt::print(
+        stderr, " ±{:>5.1f}% cpu {:>5.2f}x",
+        100.0 * result.stddev_nanoseconds / mean,
+        result.cpu_nanoseconds_per_iteration / mean
+    );
+
+    if (n_items > 1) {
+        fmt::print(stderr, " {:>14.0f} items/s", result.items_per_second);
+    }
+
+    if constexpr (ALLOCATION_TRACKING_IS_ENABLED) {
+        fmt::print(
+            stderr, " {:>10.1f} allocs/iter", result.allocations_per_iteration
+        );
+    }
+
+    fmt::print(stderr, "\n");
+
+    bench_results.push_back(result);
+
+    return result;
+}
+
+}  // namespace tmine_bench
@@ -0,0 +1,217 @@
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+
+#ifdef _OPENMP
+#    include <omp.h>
+#endif
+
+#include "physics.hpp"
+#include "terrain.hpp"
+
+#include "bench.hpp"
+#include "collisions.hpp"
+
+namespace tmine_bench {
+
+auto constexpr RANDOM_SEED = u32{42};
+
+/// Scatters `n_colliders` unit boxes so that their density does not depend
+/// on the amount of them.
+static auto make_solver(usize n_colliders) -> PhysicsSolver {
+    auto constexpr BOXES_PER_UNIT_AREA = 0.05f;
+
+    auto solver = PhysicsSolver{};
+    auto rng = std::mt19937{RANDOM_SEED};
+
+    auto const side = std::sqrt((f32) n_colliders / BOXES_PER_UNIT_AREA);
+    auto horizontal = std::uniform_real_distribution<f32>{0.0f, side};
+    auto vertical = std::uniform_real_distribution<f32>{0.0f, 8.0f};
+    auto speed = std::uniform_real_distribution<f32>{-2.0f, 2.0f};
+
+    for (usize i = 0; i < n_colliders; ++i) {
+        auto const lo =
+            glm::vec3{horizontal(rng), vertical(rng), horizontal(rng)};
+
+        solver.register_collidable<BoxCollider>(
+            Aabb{lo, lo + glm::vec3{1.0f}},
+            glm::vec3{speed(rng), speed(rng), speed(rng)}, glm::vec3{0.0f},
+            ABSOLUTELY_INELASTIC_ELASTICITY
+        );
+    }
+
+    return solver;
+}
+
+auto bench_physics_broadphase() -> void {
+    auto constexpr TIME_STEP = 1.0f / 60.0f;
+
+    for (auto const n_colliders : {10uz, 100uz, 1'000uz, 10'000uz}) {
+        auto solver = make_solver(n_colliders);
+        auto const n_iterations = std::max(1uz, 100'000uz / n_colliders);
+
+        bench(
+            fmt::format("physics_update_{}_boxes", n_colliders), n_iterations,
+            [&] { solver.update(TIME_STEP); }, n_colliders
+        );
+    }
+}
+
+auto bench_terrain_collisions() -> void {
+    auto constexpr N_BOXES = usize{4096};
+    auto constexpr BOX_SIZE = glm::vec3{0.6f, 1.75f, 0.6f};
+
+    auto const chunks = std::make_shared<ChunkArray>(glm::uvec3{8, 4, 8});
+    auto const collider = TerrainCollider{chunks};
+    auto const world_size = glm::vec3{chunks->size() * Chunk::SIZE};
+
+    auto rng = std::mt19937{RANDOM_SEED};
+    auto unit = std::uniform_real_distribution<f32>{0.0f, 1.0f};
+    auto boxes = std::vector<Aabb>(N_BOXES);
+
+    for (auto& box : boxes) {
+        auto const lo = (world_size - BOX_SIZE) *
+                        glm::vec3{unit(rng), unit(rng), unit(rng)};
+        box = Aabb{lo, lo + BOX_SIZE};
+    }
+
+    bench(
+        "terrain_collide_box", 100,
+        [&] {
+            for (auto const box : boxes) {
+                do_not_optimize(collider.collide_box(box));
+            }
+        },
+        N_BOXES
+    );
+}
+
+/// Drops a grid of small boxes onto a flat floor and lets them settle.
+static auto make_resting_solver(usize n_colliders_per_side, bool allow_sleeping)
+    -> PhysicsSolver {
+    auto constexpr FLOOR_HEIGHT = u32{4};
+    auto constexpr N_SETTLE_TICKS = usize{300};
+
+    auto chunks = std::make_shared<ChunkArray>(glm::uvec3{8, 4, 8});
+    auto const world_size = chunks->size() * Chunk::SIZE;
+
+    for (u32 y = 0; y < world_size.y; ++y) {
+        for (u32 z = 0; z < world_size.z; ++z) {
+            for (u32 x = 0; x < world_size.x; ++x) {
+                auto const id = VoxelId{y <= FLOOR_HEIGHT ? u8{1} : u8{0}};
+                chunks->set_voxel({x, y, z}, Voxel{id, 0});
+            }
+        }
+    }
+
+    auto solver = PhysicsSolver{};
+    solver.set_allow_sleeping(allow_sleeping);
+    solver.register_collidable<TerrainCollider>(chunks);
+
+    for (usize z = 0; z < n_colliders_per_side; ++z) {
+        for (usize x = 0; x < n_colliders_per_side; ++x) {
+            auto const lo = glm::vec3{
+                (f32) x + 0.25f, (f32) FLOOR_HEIGHT + 3.0f, (f32) z + 0.25f
+            };
+
+            solver.add(BoxCollider{
+                .box = Aabb{lo, lo + glm::vec3{0.25f}},
+                .acceleration = glm::vec3{0.0f, -30.0f, 0.0f},
+                .elasticity = ABSOLUTELY_INELASTIC_ELASTICITY,
+            });
+        }
+    }
+
+    for (usize i = 0; i < N_SETTLE_TICKS; ++i) {
+        solver.update(1.0f / 60.0f);
+    }
+
+    return solver;
+}
+
+auto bench_physics_sleeping() -> void {
+    auto constexpr TIME_STEP = 1.0f / 60.0f;
+    auto constexpr N_COLLIDERS_PER_SIDE = usize{100};
+    auto constexpr N_COLLIDERS = N_COLLIDERS_PER_SIDE * N_COLLIDERS_PER_SIDE;
+
+    for (auto const allow_sleeping : {false, true}) {
+        auto solver = make_resting_solver(N_COLLIDERS_PER_SIDE, allow_sleeping);
+
+        bench(
+            fmt::format(
+                "physics_update_{}_resting_boxes_{}", N_COLLIDERS,
+                allow_sleeping ? "sleeping" : "awake"
+            ),
+            100, [&] { solver.update(TIME_STEP); }, N_COLLIDERS
+        );
+    }
+}
+
+/// Packs `n_colliders` unit boxes into `n_clusters` dense clumps, so that
+/// they form a few large islands.
+static auto make_clustered_solver(usize n_colliders, usize n_clusters)
+    -> PhysicsSolver {
+    auto constexpr CLUSTER_SPACING = 100.0f;
+
+    auto solver = PhysicsSolver{};
+    auto rng = std::mt19937{RANDOM_SEED};
+
+    auto const cluster_side =
+        std::cbrt((f32) n_colliders / (f32) n_clusters) * 0.8f;
+    auto offset = std::uniform_real_distribution<f32>{0.0f, cluster_side};
+    auto speed = std::uniform_real_distribution<f32>{-2.0f, 2.0f};
+
+    for (usize i = 0; i < n_colliders; ++i) {
+        auto const cluster = (f32) (i % n_clusters);
+        auto const lo = glm::vec3{cluster * CLUSTER_SPACING, 0.0f, 0.0f} +
+                        glm::vec3{offset(rng), offset(rng), offset(rng)};
+
+        solver.register_collidable<BoxCollider>(
+            Aabb{lo, lo + glm::vec3{1.0f}},
+            glm::vec3{speed(rng), speed(rng), speed(rng)}, glm::vec3{0.0f},
+            ABSOLUTELY_INELASTIC_ELASTICITY
+        );
+    }
+
+    return solver;
+}
+
+auto bench_physics_islands() -> void {
+    auto constexpr TIME_STEP = 1.0f / 60.0f;
+    auto constexpr N_COLLIDERS = usize{10'000};
+
+#ifdef _OPENMP
+    auto const prev_n_threads = omp_get_max_threads();
+#endif
+
+    for (auto const n_threads : {1, 2, 4, 8}) {
+#ifdef _OPENMP
+        omp_set_num_threads(n_threads);
+#else
+        if (1 != n_threads) {
+            continue;
+        }
+#endif
+
+        auto scattered = make_solver(N_COLLIDERS);
+
+        bench(
+            fmt::format("physics_islands_scattered_{}_threads", n_threads), 20,
+            [&] { scattered.update(TIME_STEP); }, N_COLLIDERS
+        );
+
+        auto clustered = make_clustered_solver(N_COLLIDERS, 16);
+
+        bench(
+            fmt::format("physics_islands_clustered_{}_threads", n_threads), 20,
+            [&] { clustered.update(TIME_STEP); }, N_COLLIDERS
+        );
+    }
+
+#ifdef _OPENMP
+    omp_set_num_threads(prev_n_threads);
+#endif
+}
+
+}  // namespace tmine_bench
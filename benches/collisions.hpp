@@ -0,0 +1,10 @@
+#pragma once
+
+namespace tmine_bench {
+
+auto bench_terrain_collisions() -> void;
+auto bench_physics_broadphase() -> void;
+auto bench_physics_sleeping() -> void;
+auto bench_physics_islands() -> void;
+
+}  // namespace tmine_bench
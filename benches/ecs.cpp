@@ -0,0 +1,97 @@
+#include <memory>
+#include <random>
+
+#ifdef _OPENMP
+#    include <omp.h>
+#endif
+
+#include "terrain.hpp"
+#include "entities.hpp"
+#include "bench.hpp"
+#include "ecs.hpp"
+
+namespace tmine_bench {
+
+/// Scatters `n_entities` small boxes over generated terrain with random
+/// velocities, so that they keep falling, bouncing and sliding.
+static auto spawn_entities(
+    RefMut<EntityRegistry> registry, glm::uvec3 world_size, usize n_entities
+) -> void {
+    auto rng = std::mt19937{17};
+    auto horizontal = std::uniform_real_distribution<f32>{
+        4.0f, (f32) world_size.x - 4.0f
+    };
+    // Generated terrain never gets this high
+    auto height = std::uniform_real_distribution<f32>{
+        100.0f, (f32) world_size.y - 2.0f
+    };
+    auto speed = std::uniform_real_distribution<f32>{-8.0f, 8.0f};
+
+    for (usize i = 0; i < n_entities; ++i) {
+        auto const entity = registry->spawn();
+
+        registry->add(
+            entity,
+            Transform{.pos = {horizontal(rng), height(rng), horizontal(rng)}}
+        );
+        registry->add(
+            entity, Velocity{
+                        .value = {speed(rng), speed(rng), speed(rng)},
+                        .acceleration = {0.0f, -20.0f, 0.0f},
+                    }
+        );
+        registry->add(
+            entity,
+            EntityCollider{.size = glm::vec3{0.25f}, .elasticity = 0.5f}
+        );
+    }
+}
+
+auto bench_entity_ticks() -> void {
+    auto constexpr TIME_STEP = 1.0f / 60.0f;
+    auto constexpr N_ENTITIES = usize{50'000};
+
+    auto const chunks = std::make_shared<ChunkArray>(glm::uvec3{8, 8, 8});
+    auto const terrain = TerrainCollider{chunks};
+
+#ifdef _OPENMP
+    auto const prev_n_threads = omp_get_max_threads();
+#endif
+
+    for (auto const n_threads : {1, 2, 4, 8}) {
+#ifdef _OPENMP
+        omp_set_num_threads(n_threads);
+#else
+        if (1 != n_threads) {
+            continue;
+        }
+#endif
+
+        auto registry = EntityRegistry{};
+        spawn_entities(&registry, chunks->size() * Chunk::SIZE, N_ENTITIES);
+
+        // One iteration is a second of game time at 60 ticks/s
+        auto const result = bench(
+            fmt::format("entity_ticks_{}_threads", n_threads), 5,
+            [&] {
+                for (usize i = 0; i < 60; ++i) {
+                    move_entities(&registry, terrain, TIME_STEP);
+                }
+
+                do_not_optimize(registry.storage<Transform>().components());
+            },
+            60 * N_ENTITIES
+        );
+
+        fmt::print(
+            stderr, "    {:.2f}x realtime\n",
+            1.0e9 / result.nanoseconds_per_iteration
+        );
+    }
+
+#ifdef _OPENMP
+    omp_set_num_threads(prev_n_threads);
+#endif
+}
+
+}  // namespace tmine_bench
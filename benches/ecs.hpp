@@ -0,0 +1,7 @@
+#pragma once
+
+namespace tmine_bench {
+
+auto bench_entity_ticks() -> void;
+
+}  // namespace tmine_bench
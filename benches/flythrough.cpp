@@ -0,0 +1,707 @@
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <rapidjson/document.h>
+#include <fmt/format.h>
+#include <fmt/color.h>
+
+#include "game.hpp"
+#include "objects.hpp"
+#include "loaders.hpp"
+#include "metrics.hpp"
+#include "allocations.hpp"
+#include "panic.hpp"
+
+#include "bench.hpp"
+
+using namespace tmine_bench;
+
+namespace rj = rapidjson;
+
+#if defined(TMINE_SOURCE_DIR)
+static auto constexpr SOURCE_DIR_NAME = "'" TMINE_SOURCE_DIR "'";
+#else
+static auto constexpr SOURCE_DIR_NAME = "the repository root";
+#endif
+
+/// Player input from `tick` on. Camera angles are interpolated towards the
+/// next keyframe, keys and movement are held until it.
+struct FlyKeyframe {
+    u32 tick{0};
+    u8 pressed{0};
+    PlayerMovement movement{PlayerMovement::Fly};
+    glm::vec2 camera_angles{0.0f};
+};
+
+enum class FlyEditKind : u8 {
+    Dig = 0,
+    Place,
+    Fill,
+};
+
+/// Sets voxels from `lo` to `hi` inclusive right before `tick`.
+struct FlyEdit {
+    u32 tick{0};
+    FlyEditKind kind{FlyEditKind::Dig};
+    glm::uvec3 lo{0};
+    glm::uvec3 hi{0};
+    Voxel voxel{0, 0};
+};
+
+struct FlyScript {
+    glm::uvec3 world_size{8, 4, 8};
+    f32 tick_rate{FixedUpdater::DEFAULT_TICK_RATE};
+    u32 ticks_per_frame{2};
+    u32 n_frames{0};
+    std::vector<FlyKeyframe> keyframes;
+    std::vector<FlyEdit> edits;
+
+    auto input_at(this FlyScript const& self, u32 tick) -> PlayerTickInput {
+        auto const next = std::ranges::upper_bound(
+            self.keyframes, tick, {}, &FlyKeyframe::tick
+        );
+
+        if (next == self.keyframes.begin()) {
+            return PlayerTickInput{};
+        }
+
+        auto const& current = *(next - 1);
+        auto camera_angles = current.camera_angles;
+
+        if (next != self.keyframes.end()) {
+            auto const alpha = (f32) (tick - current.tick) /
+                               (f32) (next->tick - current.tick);
+
+            camera_angles =
+                glm::mix(current.camera_angles, next->camera_angles, alpha);
+        }
+
+        return PlayerTickInput{
+            .pressed = current.pressed,
+            .movement = current.movement,
+            .camera_angles = camera_angles,
+        };
+    }
+};
+
+static auto get_u32(char const* path, rj::Value const& object, char const* name)
+    -> u32 {
+    if (!object.HasMember(name) || !object[name].IsUint()) {
+        throw Panic("`{}` should be an unsigned integer in '{}'", name, path);
+    }
+
+    return object[name].GetUint();
+}
+
+static auto get_f32(
+    char const* path, rj::Value const& object, char const* name, f32 fallback
+) -> f32 {
+    if (!object.HasMember(name)) {
+        return fallback;
+    }
+
+    if (!object[name].IsNumber()) {
+        throw Panic("`{}` should be a number in '{}'", name, path);
+    }
+
+    return object[name].GetFloat();
+}
+
+static auto get_uvec3(
+    char const* path, rj::Value const& object, char const* name
+) -> glm::uvec3 {
+    if (!object.HasMember(name) || !object[name].IsArray() ||
+        3 != object[name].Size())
+    {
+        throw Panic("`{}` should be an array of 3 in '{}'", name, path);
+    }
+
+    auto result = glm::uvec3{0};
+
+    for (u32 i = 0; i < 3; ++i) {
+        if (!object[name][i].IsUint()) {
+            throw Panic(
+                "`{}` should contain unsigned integers in '{}'", name, path
+            );
+        }
+
+        result[i] = object[name][i].GetUint();
+    }
+
+    return result;
+}
+
+static auto parse_pressed(char const* path, rj::Value const& object) -> u8 {
+    auto constexpr NAMES = std::array<std::pair<char const*, u8>, 7>{{
+        {"forward", PlayerTickInput::FORWARD},
+        {"backward", PlayerTickInput::BACKWARD},
+        {"right", PlayerTickInput::RIGHT},
+        {"left", PlayerTickInput::LEFT},
+        {"jump", PlayerTickInput::JUMP},
+        {"descend", PlayerTickInput::DESCEND},
+        {"sprint", PlayerTickInput::SPRINT},
+    }};
+
+    if (!object.HasMember("pressed")) {
+        return 0;
+    }
+
+    if (!object["pressed"].IsArray()) {
+        throw Panic("`pressed` should be an array in '{}'", path);
+    }
+
+    auto result = u8{0};
+
+    for (auto const& value : object["pressed"].GetArray()) {
+        auto const name = value.IsString() ? value.GetString() : "";
+        auto const iter = std::ranges::find_if(NAMES, [name](auto entry) {
+            return 0 == std::strcmp(entry.first, name);
+        });
+
+        if (iter == NAMES.end()) {
+            throw Panic("unknown key in `pressed` in '{}'", path);
+        }
+
+        result |= iter->second;
+    }
+
+    return result;
+}
+
+static auto parse_keyframe(char const* path, rj::Value const& object)
+    -> FlyKeyframe {
+    auto movement = PlayerMovement::Fly;
+
+    if (object.HasMember("movement")) {
+        auto const& value = object["movement"];
+
+        if (value.IsString() && 0 == std::strcmp("walk", value.GetString())) {
+            movement = PlayerMovement::Walk;
+        } else if (!value.IsString() ||
+                   0 != std::strcmp("fly", value.GetString()))
+        {
+            throw Panic("`movement` should be 'walk' or 'fly' in '{}'", path);
+        }
+    }
+
+    return FlyKeyframe{
+        .tick = get_u32(path, object, "tick"),
+        .pressed = parse_pressed(path, object),
+        .movement = movement,
+        .camera_angles =
+            glm::vec2{
+                get_f32(path, object, "pitch", 0.0f),
+                get_f32(path, object, "yaw", 0.0f),
+            },
+    };
+}
+
+static auto parse_edit(char const* path, rj::Value const& object) -> FlyEdit {
+    if (!object.HasMember("kind") || !object["kind"].IsString()) {
+        throw Panic("edits should have a `kind` in '{}'", path);
+    }
+
+    auto const kind = std::string_view{object["kind"].GetString()};
+    auto edit = FlyEdit{.tick = get_u32(path, object, "tick")};
+
+    if ("dig" == kind) {
+        edit.kind = FlyEditKind::Dig;
+        edit.lo = get_uvec3(path, object, "lo");
+        edit.hi = get_uvec3(path, object, "hi");
+    } else if ("place" == kind) {
+        edit.kind = FlyEditKind::Place;
+        edit.lo = edit.hi = get_uvec3(path, object, "pos");
+        edit.voxel = Voxel{(VoxelId) get_u32(path, object, "voxel"), 0};
+    } else if ("fill" == kind) {
+        edit.kind = FlyEditKind::Fill;
+        edit.lo = get_uvec3(path, object, "lo");
+        edit.hi = get_uvec3(path, object, "hi");
+        edit.voxel = Voxel{(VoxelId) get_u32(path, object, "voxel"), 0};
+    } else {
+        throw Panic("unknown edit kind '{}' in '{}'", kind, path);
+    }
+
+    return edit;
+}
+
+static auto load_script(char const* path) -> FlyScript {
+    auto const contents = read_to_string(path);
+
+    auto document = rj::Document{};
+    document.Parse(contents.c_str());
+
+    if (!document.IsObject()) {
+        throw Panic("fly-through script '{}' should be an object", path);
+    }
+
+    auto script = FlyScript{
+        .world_size = get_uvec3(path, document, "world_size"),
+        .tick_rate = get_f32(
+            path, document, "tick_rate", FixedUpdater::DEFAULT_TICK_RATE
+        ),
+        .ticks_per_frame = get_u32(path, document, "ticks_per_frame"),
+        .n_frames = get_u32(path, document, "n_frames"),
+    };
+
+    for (char const* name : {"keyframes", "edits"}) {
+        if (!document.HasMember(name) || !document[name].IsArray()) {
+            throw Panic("`{}` should be an array in '{}'", name, path);
+        }
+    }
+
+    for (auto const& value : document["keyframes"].GetArray()) {
+        script.keyframes.push_back(parse_keyframe(path, value));
+    }
+
+    for (auto const& value : document["edits"].GetArray()) {
+        script.edits.push_back(parse_edit(path, value));
+    }
+
+    // Keyframe ticks are strictly increasing, so that interpolation never
+    // divides by zero
+    auto const keyframes_are_sorted =
+        script.keyframes.end() ==
+        std::ranges::adjacent_find(
+            script.keyframes,
+            [](auto const& left, auto const& right) {
+                return left.tick >= right.tick;
+            }
+        );
+
+    if (!keyframes_are_sorted ||
+        !std::ranges::is_sorted(script.edits, {}, &FlyEdit::tick))
+    {
+        throw Panic(
+            "keyframes and edits should be sorted by tick in '{}'", path
+        );
+    }
+
+    if (0 == script.ticks_per_frame) {
+        throw Panic("`ticks_per_frame` should not be zero in '{}'", path);
+    }
+
+    return script;
+}
+
+/// Remeshes chunks touched by edits into plain vertex buffers, the CPU part
+/// of what `Terrain` does before uploading.
+class HeadlessMesher {
+public:
+    explicit HeadlessMesher(ChunkArray const& chunks)
+    : renderer{load_game_blocks_data(
+          Terrain::BLOCK_DATA_PATH, Terrain::BLOCK_TEXTURE_DATA_PATH
+      )}
+    , buffers(chunks.chunk_count()) {}
+
+    /// Marks chunks with voxels from `lo` to `hi` inclusive or next to them.
+    auto mark_edited(
+        this HeadlessMesher& self, ChunkArray const& chunks, glm::uvec3 lo,
+        glm::uvec3 hi
+    ) -> void {
+        auto const chunk_lo = (glm::max(lo, 1u) - 1u) / Chunk::SIZE;
+        auto const chunk_hi =
+            glm::min((hi + 1u) / Chunk::SIZE, chunks.size() - 1u);
+
+        for (u32 y = chunk_lo.y; y <= chunk_hi.y; ++y) {
+            for (u32 z = chunk_lo.z; z <= chunk_hi.z; ++z) {
+                for (u32 x = chunk_lo.x; x <= chunk_hi.x; ++x) {
+                    self.dirty.push_back(chunks.index_of({x, y, z}));
+                }
+            }
+        }
+    }
+
+    auto mark_all(this HeadlessMesher& self, ChunkArray const& chunks)
+        -> void {
+        for (usize i = 0; i < chunks.chunk_count(); ++i) {
+            self.dirty.push_back(i);
+        }
+    }
+
+    /// Meshes marked chunks in parallel, returns the number of chunks.
+    auto remesh(this HeadlessMesher& self, ChunkArray const& chunks)
+        -> usize {
+        std::ranges::sort(self.dirty);
+        self.dirty.erase(
+            std::ranges::unique(self.dirty).begin(), self.dirty.end()
+        );
+
+        auto const n_chunks = (isize) self.dirty.size();
+
+#pragma omp parallel for
+        for (isize i = 0; i < n_chunks; ++i) {
+            auto const index = self.dirty[i];
+            auto& buffer = self.buffers[index];
+
+            buffer.clear();
+            self.renderer.render_opaque(
+                chunks, chunks.index_to_pos(index), &buffer
+            );
+        }
+
+        return std::exchange(self.dirty, {}).size();
+    }
+
+private:
+    TerrainRenderer renderer;
+    std::vector<MeshVec<TerrainRenderer::Vertex>> buffers;
+    std::vector<usize> dirty;
+};
+
+/// Timings and counters of every frame of a run.
+struct FlyReport {
+    std::vector<std::array<f64, N_TIMINGS>> times;
+    std::vector<std::array<u64, N_COUNTERS>> counts;
+    /// Heap allocations per frame, zeros without `TMINE_TRACK_ALLOCATIONS`.
+    std::vector<u64> n_allocations;
+    f64 ticks_per_second{0.0};
+};
+
+/// Flies through `script` at full speed, one frame being
+/// `script.ticks_per_frame` ticks followed by remeshing of edited chunks.
+static auto run(FlyScript const& script) -> FlyReport {
+    auto game = std::make_unique<Game>(HeadlessConfig{
+        .world_size = script.world_size,
+        .tick_rate = script.tick_rate,
+    });
+    auto mesher = HeadlessMesher{game->get_chunks()};
+
+    mesher.mark_all(game->get_chunks());
+    mesher.remesh(game->get_chunks());
+
+    // Drops whatever world generation recorded
+    metrics::REGISTRY.finish_frame();
+
+    // Reserved up front, so that frames count only their own allocations
+    auto report = FlyReport{};
+    report.times.reserve(script.n_frames);
+    report.counts.reserve(script.n_frames);
+    report.n_allocations.reserve(script.n_frames);
+
+    allocations::REGISTRY.finish_frame();
+
+    auto edit = script.edits.begin();
+    auto n_ticks = u32{0};
+
+    auto const apply_edits = [&](u32 tick, Game& target) -> PlayerTickInput {
+        for (; edit != script.edits.end() && edit->tick <= tick; ++edit) {
+            auto const voxel =
+                FlyEditKind::Dig == edit->kind ? Voxel{0, 0} : edit->voxel;
+
+            target.fill_box(edit->lo, edit->hi, voxel);
+            mesher.mark_edited(target.get_chunks(), edit->lo, edit->hi);
+        }
+
+        return script.input_at(tick);
+    };
+
+    auto const stopwatch = Stopwatch{};
+
+    for (u32 frame = 0; frame < script.n_frames; ++frame) {
+        game->run_headless(script.ticks_per_frame, [&](u32 i, Game& target) {
+            return apply_edits(n_ticks + i, target);
+        });
+
+        n_ticks += script.ticks_per_frame;
+
+        {
+            auto const timing = ScopedTiming{Timing::Meshing};
+            auto const n_chunks = mesher.remesh(game->get_chunks());
+
+            metrics::add(Counter::ChunksRemeshed, n_chunks);
+        }
+
+        metrics::REGISTRY.finish_frame();
+        allocations::REGISTRY.finish_frame();
+
+        report.n_allocations.push_back(
+            allocations::REGISTRY.get_n_frame_allocations()
+        );
+
+        auto& times = report.times.emplace_back();
+        auto& counts = report.counts.emplace_back();
+
+        for (usize i = 0; i < N_TIMINGS; ++i) {
+            times[i] = metrics::REGISTRY.get_last_time((Timing) i);
+        }
+
+        for (usize i = 0; i < N_COUNTERS; ++i) {
+            counts[i] = metrics::REGISTRY.get_count((Counter) i);
+        }
+    }
+
+    report.ticks_per_second = (f64) n_ticks / stopwatch.get_seconds();
+
+    return report;
+}
+
+/// Percentiles of every timing in milliseconds.
+static auto summarize(FlyReport const& report)
+    -> std::array<Percentiles, N_TIMINGS> {
+    auto result = std::array<Percentiles, N_TIMINGS>{};
+
+    for (usize i = 0; i < N_TIMINGS; ++i) {
+        auto values = std::vector<f64>{};
+        values.reserve(report.times.size());
+
+        for (auto const& times : report.times) {
+            values.push_back(1e3 * times[i]);
+        }
+
+        result[i] = percentiles_of(std::move(values));
+    }
+
+    return result;
+}
+
+static auto to_csv(FlyReport const& report) -> std::string {
+    auto out = std::string{"frame"};
+    auto out_iter = std::back_inserter(out);
+
+    for (usize i = 0; i < N_TIMINGS; ++i) {
+        fmt::format_to(
+            out_iter, ",{}_ms", key_of(metrics::name_of((Timing) i))
+        );
+    }
+
+    for (usize i = 0; i < N_COUNTERS; ++i) {
+        fmt::format_to(out_iter, ",{}", key_of(metrics::name_of((Counter) i)));
+    }
+
+    out.append(",allocations\n");
+
+    for (usize frame = 0; frame < report.times.size(); ++frame) {
+        fmt::format_to(out_iter, "{}", frame);
+
+        for (auto const time : report.times[frame]) {
+            fmt::format_to(out_iter, ",{:.4f}", 1e3 * time);
+        }
+
+        for (auto const count : report.counts[frame]) {
+            fmt::format_to(out_iter, ",{}", count);
+        }
+
+        fmt::format_to(out_iter, ",{}\n", report.n_allocations[frame]);
+    }
+
+    return out;
+}
+
+static auto to_json(
+    FlyReport const& report, std::array<Percentiles, N_TIMINGS> const& summary
+) -> std::string {
+    auto out = std::string{};
+    auto out_iter = std::back_inserter(out);
+
+    fmt::format_to(
+        out_iter, "{{\n  \"n_frames\": {},\n  \"ticks_per_second\": {:.1f},\n",
+        report.times.size(), report.ticks_per_second
+    );
+
+    out.append("  \"timings_ms\": {\n");
+
+    for (usize i = 0; i < N_TIMINGS; ++i) {
+        auto const& stats = summary[i];
+
+        fmt::format_to(
+            out_iter,
+            "    \"{}\": {{\"min\": {:.4f}, \"avg\": {:.4f}, \"p50\": {:.4f}, "
+            "\"p90\": {:.4f}, \"p99\": {:.4f}, \"max\": {:.4f}}}{}\n",
+            key_of(metrics::name_of((Timing) i)), stats.min, stats.avg,
+            stats.p50, stats.p90, stats.p99, stats.max,
+            i + 1 < N_TIMINGS ? "," : ""
+        );
+    }
+
+    out.append("  },\n  \"counter_totals\": {\n");
+
+    for (usize i = 0; i < N_COUNTERS; ++i) {
+        auto total = u64{0};
+
+        for (auto const& counts : report.counts) {
+            total += counts[i];
+        }
+
+        fmt::format_to(
+            out_iter, "    \"{}\": {}{}\n",
+            key_of(metrics::name_of((Counter) i)), total,
+            i + 1 < N_COUNTERS ? "," : ""
+        );
+    }
+
+    auto n_allocations = u64{0};
+
+    for (auto const count : report.n_allocations) {
+        n_allocations += count;
+    }
+
+    fmt::format_to(
+        out_iter, "  }},\n  \"allocations_per_frame\": {:.1f}\n}}\n",
+        (f64) n_allocations / (f64) std::max(report.n_allocations.size(), 1uz)
+    );
+
+    return out;
+}
+
+/// Compares average and p99 timings against a summary written with
+/// `--json` by an earlier run. Returns the number of regressed metrics.
+static auto check_baseline(
+    char const* path, std::array<Percentiles, N_TIMINGS> const& summary,
+    f64 tolerance
+) -> usize {
+    // Timings this short are mostly noise
+    auto constexpr ABSOLUTE_SLACK_MS = 0.05;
+
+    auto const contents = read_to_string(path);
+
+    auto document = rj::Document{};
+    document.Parse(contents.c_str());
+
+    if (!document.IsObject() || !document.HasMember("timings_ms") ||
+        !document["timings_ms"].IsObject())
+    {
+        throw Panic("baseline '{}' has no `timings_ms` object", path);
+    }
+
+    auto const& baseline = document["timings_ms"];
+    auto n_regressions = usize{0};
+
+    for (usize i = 0; i < N_TIMINGS; ++i) {
+        auto const key = key_of(metrics::name_of((Timing) i));
+
+        if (!baseline.HasMember(key.c_str())) {
+            continue;
+        }
+
+        auto const& stats = baseline[key.c_str()];
+        auto const measured = std::array<std::pair<char const*, f64>, 2>{{
+            {"avg", summary[i].avg},
+            {"p99", summary[i].p99},
+        }};
+
+        for (auto const [name, value] : measured) {
+            if (!stats.HasMember(name) || !stats[name].IsNumber()) {
+                continue;
+            }
+
+            auto const limit =
+                stats[name].GetDouble() * (1.0 + tolerance) + ABSOLUTE_SLACK_MS;
+
+            if (value > limit) {
+                n_regressions += 1;
+
+                fmt::print(
+                    stderr, fmt::fg(fmt::color::red),
+                    "{} {} regressed: {:.3f} ms, baseline {:.3f} ms\n", key,
+                    name, value, stats[name].GetDouble()
+                );
+            }
+        }
+    }
+
+    return n_regressions;
+}
+
+/// Flies through a scripted camera path with edits without a window and
+/// reports per-frame timings of every subsystem.
+///
+/// Usage: flythrough [script.json] [--csv frames.csv] [--json summary.json]
+///                   [--baseline summary.json] [--tolerance 0.15]
+///
+/// The default script and block assets are found relative to the repository
+/// root, so it should be run from there, e.g. `build/flythrough`.
+///
+/// Exits with failure if an average or p99 timing exceeds the baseline by
+/// more than the tolerance.
+auto main(int argc, char** argv) -> int {
+    auto script_path = (char const*) "benches/flythrough.json";
+    auto csv_path = (char const*) nullptr;
+    auto json_path = (char const*) nullptr;
+    auto baseline_path = (char const*) nullptr;
+    auto tolerance = 0.15;
+
+    for (int i = 1; i < argc; ++i) {
+        auto const arg = std::string_view{argv[i]};
+        auto const has_value = i + 1 < argc;
+
+        if ("--csv" == arg && has_value) {
+            csv_path = argv[++i];
+        } else if ("--json" == arg && has_value) {
+            json_path = argv[++i];
+        } else if ("--baseline" == arg && has_value) {
+            baseline_path = argv[++i];
+        } else if ("--tolerance" == arg && has_value) {
+            tolerance = std::strtod(argv[++i], nullptr);
+        } else if (!arg.starts_with("--")) {
+            script_path = argv[i];
+        } else {
+            fmt::print(stderr, "unknown argument '{}'\n", arg);
+            return 2;
+        }
+    }
+
+    if (!std::filesystem::exists(script_path)) {
+        fmt::print(
+            stderr,
+            "fly-through script '{}' not found, run flythrough from {} or "
+            "pass the path of a script\n",
+            script_path, SOURCE_DIR_NAME
+        );
+        return 2;
+    }
+
+    auto const script = load_script(script_path);
+
+    fmt::print(
+        stderr, "flythrough '{}': {} frames of {} ticks, {} edits\n",
+        script_path, script.n_frames, script.ticks_per_frame,
+        script.edits.size()
+    );
+
+    auto const report = run(script);
+    auto const summary = summarize(report);
+
+    for (usize i = 0; i < N_TIMINGS; ++i) {
+        auto const& stats = summary[i];
+
+        if (0.0 == stats.max) {
+            continue;
+        }
+
+        fmt::print(stderr, "flythrough {:.<30}", metrics::name_of((Timing) i));
+        fmt::print(
+            stderr, fmt::fg(fmt::color::lime_green),
+            " avg {:>8.3f} p50 {:>8.3f} p99 {:>8.3f} max {:>8.3f} ms\n",
+            stats.avg, stats.p50, stats.p99, stats.max
+        );
+    }
+
+    fmt::print(
+        stderr, "flythrough {:.<30} {:>14.0f} ticks/s\n", "simulation",
+        report.ticks_per_second
+    );
+
+    if (nullptr != csv_path) {
+        write_report(csv_path, to_csv(report));
+    }
+
+    if (nullptr != json_path) {
+        write_report(json_path, to_json(report, summary));
+    }
+
+    if (nullptr != baseline_path &&
+        0 != check_baseline(baseline_path, summary, tolerance))
+    {
+        return 1;
+    }
+}
@@ -0,0 +1,51 @@
+#include <random>
+#include <vector>
+
+#include "instancing.hpp"
+
+#include "bench.hpp"
+#include "instances.hpp"
+
+namespace tmine_bench {
+
+auto bench_instance_batching() -> void {
+    auto constexpr N_INSTANCES = usize{100'000};
+
+    for (auto const n_keys : {usize{1}, usize{16}, usize{1024}}) {
+        auto rng = std::mt19937{23};
+        auto keys = std::vector<InstanceKey>(N_INSTANCES);
+        auto instances = std::vector<InstanceData>(N_INSTANCES);
+
+        for (usize i = 0; i < N_INSTANCES; ++i) {
+            auto const key = rng() % n_keys;
+
+            keys[i] = InstanceKey{
+                .mesh = (MeshId) (key % 32),
+                .material = (MaterialId) (key / 32),
+            };
+            instances[i] = InstanceData{
+                .offset = glm::vec3{(f32) (rng() % 1024)},
+                .scale = glm::vec3{0.25f},
+            };
+        }
+
+        auto batcher = InstanceBatcher{};
+
+        bench(
+            fmt::format("instance_batching_100k_{}_keys", n_keys), 100,
+            [&] {
+                batcher.clear();
+
+                for (usize i = 0; i < N_INSTANCES; ++i) {
+                    batcher.push(keys[i], instances[i]);
+                }
+
+                batcher.build();
+                do_not_optimize(batcher.get_batches().size());
+            },
+            N_INSTANCES
+        );
+    }
+}
+
+}  // namespace tmine_bench
@@ -0,0 +1,7 @@
+#pragma once
+
+namespace tmine_bench {
+
+auto bench_instance_batching() -> void;
+
+}  // namespace tmine_bench
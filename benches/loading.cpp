@@ -0,0 +1,107 @@
+#include <memory>
+#include <string_view>
+
+#include "loaders.hpp"
+#include "parser.hpp"
+#include "gui.hpp"
+
+#include "bench.hpp"
+#include "loading.hpp"
+
+namespace tmine_bench {
+
+auto bench_png_loading() -> void {
+    for (auto const path : {
+             "assets/images/debug_font.png",
+             "assets/images/texture_atlas.png",
+             "assets/images/startScreenBackground.png",
+         })
+    {
+        auto const name = std::string_view{path};
+        auto const file_name = name.substr(name.rfind('/') + 1);
+
+        bench(fmt::format("load_png_{}", file_name), 10, [path] {
+            auto const image = load_png(path);
+            do_not_optimize(image.data.data());
+        });
+    }
+}
+
+auto bench_font_parsing() -> void {
+    for (auto const path : {
+             "assets/fonts/debug_font.fnt",
+             "assets/fonts/font.fnt",
+         })
+    {
+        auto const name = std::string_view{path};
+        auto const file_name = name.substr(name.rfind('/') + 1);
+        auto const text = read_to_string(path);
+
+        bench(
+            fmt::format("parse_font_{}", file_name), 100,
+            [&text] {
+                auto result = parser::parse_font(text);
+                do_not_optimize(result.ok());
+            },
+            text.size()
+        );
+    }
+}
+
+auto bench_font_loading() -> void {
+    for (auto const path : {
+             "assets/fonts/debug_font.fnt",
+             "assets/fonts/font.fnt",
+         })
+    {
+        auto const name = std::string_view{path};
+        auto const file_name = name.substr(name.rfind('/') + 1);
+
+        bench(fmt::format("parse_font_file_{}", file_name), 100, [path] {
+            auto const font = parse_font_file(path);
+            do_not_optimize(font.pages.data());
+        });
+
+        // The warm up run writes the cache if it is missing
+        bench(fmt::format("load_font_cached_{}", file_name), 100, [path] {
+            auto const font = load_font(path);
+            do_not_optimize(font.pages.data());
+        });
+    }
+}
+
+auto bench_glyph_layout() -> void {
+    auto constexpr TEXT =
+        "Chunks remeshed: 12, vertices uploaded: 65536, draw calls: 42";
+
+    auto const font =
+        std::make_shared<Font>(load_font("assets/fonts/debug_font.fnt"));
+    auto text = Text{font, Texture{}, "", glm::vec2{0.0f}, 0.3f};
+    auto const n_glyphs = std::string_view{TEXT}.size();
+
+    bench(
+        "text_layout", 10'000,
+        [&text] {
+            text.set_text(TEXT);
+            do_not_optimize(text.get_width());
+        },
+        n_glyphs
+    );
+
+    bench(
+        "glyph_lookup", 10'000,
+        [&font] {
+            auto n_units = i32{0};
+            auto const string = std::string_view{TEXT};
+
+            for (usize i = 0; i < string.size(); ++i) {
+                n_units += font->advance_of(string, i);
+            }
+
+            do_not_optimize(n_units);
+        },
+        n_glyphs
+    );
+}
+
+}  // namespace tmine_bench
@@ -0,0 +1,10 @@
+#pragma once
+
+namespace tmine_bench {
+
+auto bench_png_loading() -> void;
+auto bench_font_parsing() -> void;
+auto bench_font_loading() -> void;
+auto bench_glyph_layout() -> void;
+
+}  // namespace tmine_bench
@@ -0,0 +1,97 @@
+#include <cstdio>
+#include <iterator>
+#include <string>
+#include <string_view>
+
+#include "terrain.hpp"
+
+#include "bench.hpp"
+#include "voxels.hpp"
+#include "collisions.hpp"
+#include "ecs.hpp"
+#include "instances.hpp"
+#include "loading.hpp"
+#include "vec.hpp"
+
+using namespace tmine_bench;
+
+/// All results in one JSON document, suitable for trend tracking.
+static auto results_to_json() -> std::string {
+    auto out = std::string{};
+    auto out_iter = std::back_inserter(out);
+
+    fmt::format_to(
+        out_iter,
+        "{{\n  \"voxel_layout\": \"{}\",\n  \"chunk_layout\": \"{}\",\n"
+        "  \"benches\": [\n",
+        Chunk::Layout::NAME, ChunkArray::Layout::NAME
+    );
+
+    for (usize i = 0; i < bench_results.size(); ++i) {
+        auto const& result = bench_results[i];
+
+        fmt::format_to(
+            out_iter,
+            "    {{\"name\": \"{}\", \"iterations\": {}, \"items\": {}, "
+            "\"median_ns\": {:.1f}, \"min_ns\": {:.1f}, \"mean_ns\": {:.1f}, "
+            "\"stddev_ns\": {:.1f}, \"cpu_ns\": {:.1f}, "
+            "\"items_per_second\": {:.1f}, \"allocations\": {:.1f}}}{}\n",
+            result.name, result.n_iterations, result.n_items,
+            result.nanoseconds_per_iteration, result.min_nanoseconds,
+            result.mean_nanoseconds, result.stddev_nanoseconds,
+            result.cpu_nanoseconds_per_iteration, result.items_per_second,
+            result.allocations_per_iteration,
+            i + 1 < bench_results.size() ? "," : ""
+        );
+    }
+
+    out.append("  ]\n}\n");
+
+    return out;
+}
+
+static auto write_results(char const* path) -> void {
+    write_report(path, results_to_json());
+}
+
+/// Usage: bench [--json results.json]
+auto main(int argc, char** argv) -> int {
+    auto json_path = (char const*) nullptr;
+
+    for (int i = 1; i < argc; ++i) {
+        if ("--json" == std::string_view{argv[i]} && i + 1 < argc) {
+            json_path = argv[++i];
+        } else {
+            fmt::print(stderr, "unknown argument '{}'\n", argv[i]);
+            return 2;
+        }
+    }
+
+    fmt::print(
+        stderr, "voxel layout: {}, chunk layout: {}\n", Chunk::Layout::NAME,
+        ChunkArray::Layout::NAME
+    );
+
+    bench_voxel_layout_indexing();
+    bench_chunk_generation();
+    bench_chunk_meshing();
+    bench_ray_casting();
+    bench_ray_casting_batch();
+    bench_collision_scans();
+    bench_structure_pasting();
+    bench_terrain_collisions();
+    bench_physics_broadphase();
+    bench_physics_sleeping();
+    bench_physics_islands();
+    bench_entity_ticks();
+    bench_instance_batching();
+    bench_vec_append_contention();
+    bench_png_loading();
+    bench_font_parsing();
+    bench_font_loading();
+    bench_glyph_layout();
+
+    if (nullptr != json_path) {
+        write_results(json_path);
+    }
+}
@@ -0,0 +1,47 @@
+#include <fmt/format.h>
+#include <fmt/color.h>
+
+#include "replay.hpp"
+
+using namespace tmine;
+
+/// Replays a log recorded in game with F9 and reports how fast the ticks
+/// run. Exits with failure if the replayed state is not bit-exact.
+auto main(int argc, char** argv) -> int {
+    auto const path = argc > 1 ? argv[1] : "physics.tmrp";
+    auto const log = ReplayLog::load(path);
+
+    fmt::print(
+        stderr, "replay '{}': {} ticks, {} patches, {} spawns\n", path,
+        log.tick_count(), log.patches.size(), log.spawns.size()
+    );
+
+    auto const result = replay(log);
+
+    fmt::print(stderr, "replay {:.<55}", "physics_and_player_ticks");
+    fmt::print(
+        stderr, fmt::fg(fmt::color::lime_green), " {:>14.0f} ticks/s\n",
+        result.ticks_per_second
+    );
+
+    if (!log.final_state.has_value()) {
+        fmt::print(stderr, "log has no final state to compare against\n");
+        return 0;
+    }
+
+    if (!result.is_exact) {
+        auto const& expected = log.final_state->box.lo;
+        auto const& actual = result.final_state.box.lo;
+
+        fmt::print(
+            stderr, fmt::fg(fmt::color::red),
+            "final state differs: expected box at ({}, {}, {}), got ({}, {}, "
+            "{})\n",
+            expected.x, expected.y, expected.z, actual.x, actual.y, actual.z
+        );
+
+        return 1;
+    }
+
+    fmt::print(stderr, "final state is bit-exact\n");
+}
@@ -0,0 +1,55 @@
+#include <array>
+
+#ifdef _OPENMP
+#    include <omp.h>
+#endif
+
+#include "collections.hpp"
+
+#include "bench.hpp"
+#include "vec.hpp"
+
+namespace tmine_bench {
+
+auto bench_vec_append_contention() -> void {
+    auto constexpr N_APPENDS = usize{1 << 16};
+    auto constexpr CHUNK_SIZE = usize{6};
+
+#ifdef _OPENMP
+    auto const prev_n_threads = omp_get_max_threads();
+#endif
+
+    for (auto const n_threads : {1, 2, 4, 8}) {
+#ifdef _OPENMP
+        omp_set_num_threads(n_threads);
+#else
+        if (1 != n_threads) {
+            continue;
+        }
+#endif
+
+        bench(
+            fmt::format("vec_append_{}_threads", n_threads), 10,
+            [] {
+                auto vec = ThreadsafeVec<u32>{};
+
+#pragma omp parallel for
+                for (usize i = 0; i < N_APPENDS; ++i) {
+                    auto values = std::array<u32, CHUNK_SIZE>{};
+                    values.fill((u32) i);
+
+                    vec.append(values);
+                }
+
+                do_not_optimize(vec.data());
+            },
+            N_APPENDS
+        );
+    }
+
+#ifdef _OPENMP
+    omp_set_num_threads(prev_n_threads);
+#endif
+}
+
+}  // namespace tmine_bench
@@ -0,0 +1,7 @@
+#pragma once
+
+namespace tmine_bench {
+
+auto bench_vec_append_contention() -> void;
+
+}  // namespace tmine_bench
@@ -0,0 +1,406 @@
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "terrain.hpp"
+#include "objects.hpp"
+#include "loaders.hpp"
+
+#include "bench.hpp"
+#include "voxels.hpp"
+
+namespace tmine_bench {
+
+auto constexpr WORLD_SIZES = glm::uvec3{8, 4, 8};
+auto constexpr RANDOM_SEED = u32{42};
+
+static auto world() -> ChunkArray const& {
+    static auto const chunks = ChunkArray{WORLD_SIZES};
+    return chunks;
+}
+
+static auto random_point(RefMut<std::mt19937> rng) -> glm::vec3 {
+    auto const world_size = glm::vec3{WORLD_SIZES * Chunk::SIZE};
+    auto distribution = std::uniform_real_distribution<f32>{0.0f, 1.0f};
+
+    return world_size * glm::vec3{
+        distribution(*rng), distribution(*rng), distribution(*rng)
+    };
+}
+
+static auto random_direction(RefMut<std::mt19937> rng) -> glm::vec3 {
+    auto distribution = std::normal_distribution<f32>{0.0f, 1.0f};
+
+    return glm::normalize(glm::vec3{
+        distribution(*rng), distribution(*rng), distribution(*rng)
+    });
+}
+
+template <class Layout>
+static auto sample_neighbourhoods(std::span<Voxel const> voxels) -> usize {
+    auto n_solid = usize{0};
+
+    for (u32 y = 1; y + 1 < Chunk::HEIGHT; ++y) {
+        for (u32 z = 1; z + 1 < Chunk::DEPTH; ++z) {
+            for (u32 x = 1; x + 1 < Chunk::WIDTH; ++x) {
+                for (u32 dy = 0; dy < 3; ++dy) {
+                    for (u32 dz = 0; dz < 3; ++dz) {
+                        for (u32 dx = 0; dx < 3; ++dx) {
+                            auto const pos =
+                                glm::uvec3{x + dx - 1, y + dy - 1, z + dz - 1};
+                            auto const index =
+                                Layout::index_of(pos, Chunk::SIZE);
+
+                            n_solid += 0 != voxels[index].id;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    return n_solid;
+}
+
+template <class Layout>
+static auto bench_neighbourhood_sampling(std::string_view name) -> void {
+    auto voxels = std::vector<Voxel>(Chunk::VOLUME);
+    auto rng = std::mt19937{RANDOM_SEED};
+
+    for (auto& voxel : voxels) {
+        voxel.id = (VoxelId) (rng() % 2);
+    }
+
+    bench(name, 1000, [&] {
+        do_not_optimize(sample_neighbourhoods<Layout>(voxels));
+    });
+}
+
+auto bench_voxel_layout_indexing() -> void {
+    bench_neighbourhood_sampling<LinearLayout>(
+        "voxel_layout_linear_neighbourhood"
+    );
+    bench_neighbourhood_sampling<MortonLayout<Chunk::N_POSITION_BITS>>(
+        "voxel_layout_morton_neighbourhood"
+    );
+
+    bench(
+        "voxel_layout_linear_roundtrip", 1000,
+        [] {
+            auto sum = usize{0};
+
+            for (usize i = 0; i < Chunk::VOLUME; ++i) {
+                auto const pos = LinearLayout::pos_of(i, Chunk::SIZE);
+                sum += LinearLayout::index_of(pos, Chunk::SIZE);
+            }
+
+            do_not_optimize(sum);
+        },
+        Chunk::VOLUME
+    );
+
+    bench(
+        "voxel_layout_morton_roundtrip", 1000,
+        [] {
+            using Layout = MortonLayout<Chunk::N_POSITION_BITS>;
+
+            auto sum = usize{0};
+
+            for (usize i = 0; i < Chunk::VOLUME; ++i) {
+                auto const pos = Layout::pos_of(i, Chunk::SIZE);
+                sum += Layout::index_of(pos, Chunk::SIZE);
+            }
+
+            do_not_optimize(sum);
+        },
+        Chunk::VOLUME
+    );
+}
+
+auto bench_chunk_generation() -> void {
+    auto constexpr N_CHUNKS_PER_SIDE = u32{4};
+    auto constexpr N_CHUNKS = N_CHUNKS_PER_SIDE * N_CHUNKS_PER_SIDE;
+
+    bench(
+        "chunk_generation", 4,
+        [] {
+            for (u32 z = 0; z < N_CHUNKS_PER_SIDE; ++z) {
+                for (u32 x = 0; x < N_CHUNKS_PER_SIDE; ++x) {
+                    auto const chunk = Chunk{{x, 1, z}};
+                    do_not_optimize(chunk.get_voxels().data());
+                }
+            }
+        },
+        N_CHUNKS
+    );
+
+    bench(
+        "height_map_column", 100,
+        [] {
+            auto sum = 0.0f;
+
+            for (u32 z = 0; z < Chunk::DEPTH; ++z) {
+                for (u32 x = 0; x < Chunk::WIDTH; ++x) {
+                    sum += height_map_at({x, z});
+                }
+            }
+
+            do_not_optimize(sum);
+        },
+        Chunk::WIDTH * Chunk::DEPTH
+    );
+}
+
+/// Scatters translucent voxels over a chunk-high slab in the middle of the
+/// world, so that transparent meshing has work to do.
+static auto translucent_world(GameBlocksData const& data) -> ChunkArray {
+    auto result = ChunkArray{WORLD_SIZES};
+    auto const world_size = result.size() * Chunk::SIZE;
+    auto rng = std::mt19937{RANDOM_SEED};
+
+    auto translucent_ids = std::vector<VoxelId>{};
+
+    for (usize id = 1; id < data.blocks.size(); ++id) {
+        if (data.blocks[id][0].is_translucent()) {
+            translucent_ids.push_back((VoxelId) id);
+        }
+    }
+
+    if (translucent_ids.empty()) {
+        return result;
+    }
+
+    for (u32 y = 0; y < Chunk::HEIGHT; ++y) {
+        for (u32 z = 0; z < world_size.z; ++z) {
+            for (u32 x = 0; x < world_size.x; ++x) {
+                if (0 != rng() % 3) {
+                    continue;
+                }
+
+                auto const id = translucent_ids[rng() % translucent_ids.size()];
+                result.set_voxel({x, y + world_size.y / 2, z}, Voxel{id, 0});
+            }
+        }
+    }
+
+    return result;
+}
+
+auto bench_chunk_meshing() -> void {
+    auto const& chunks = world();
+    auto const data = load_game_blocks_data(
+        Terrain::BLOCK_DATA_PATH, Terrain::BLOCK_TEXTURE_DATA_PATH
+    );
+    auto const renderer = TerrainRenderer{data};
+
+    auto buffer = MeshVec<TerrainRenderer::Vertex>{};
+
+    bench(
+        "chunk_meshing_opaque", 4,
+        [&] {
+            for (usize i = 0; i < chunks.chunk_count(); ++i) {
+                renderer.render_opaque(chunks, chunks.index_to_pos(i), &buffer);
+                do_not_optimize(buffer.data());
+            }
+        },
+        chunks.chunk_count()
+    );
+
+    auto const translucent = translucent_world(data);
+    auto const camera_pos =
+        0.5f * glm::vec3{translucent.size() * Chunk::SIZE};
+
+    auto transparent_buffer =
+        ThreadsafeVec<TerrainRenderer::TransparentVertex>{};
+
+    bench(
+        "chunk_meshing_transparent", 4,
+        [&] {
+            transparent_buffer.clear();
+
+            for (auto const& chunk : translucent.as_span()) {
+                renderer.render_transparent(
+                    chunk, translucent, &transparent_buffer, camera_pos
+                );
+            }
+
+            do_not_optimize(transparent_buffer.data());
+        },
+        translucent.chunk_count()
+    );
+
+    auto const unsorted = std::vector<TerrainRenderer::TransparentVertex>(
+        transparent_buffer.begin(), transparent_buffer.end()
+    );
+    auto vertices = unsorted;
+
+    bench(
+        "sort_transparent_triangles", 10,
+        [&] {
+            std::ranges::copy(unsorted, vertices.begin());
+            TerrainRenderer::sort_transparent_triangles(vertices, camera_pos);
+            do_not_optimize(vertices.data());
+        },
+        vertices.size() / 3
+    );
+}
+
+auto bench_ray_casting() -> void {
+    auto constexpr N_RAYS = usize{4096};
+
+    auto const& chunks = world();
+    auto rng = std::mt19937{RANDOM_SEED};
+
+    auto origins = std::vector<glm::vec3>(N_RAYS);
+    auto directions = std::vector<glm::vec3>(N_RAYS);
+
+    for (usize i = 0; i < N_RAYS; ++i) {
+        origins[i] = random_point(&rng);
+        directions[i] = random_direction(&rng);
+    }
+
+    for (auto const max_distance : {8.0f, 64.0f, 512.0f}) {
+        bench(
+            fmt::format("ray_cast_{}", max_distance), 10,
+            [&] {
+                for (usize i = 0; i < N_RAYS; ++i) {
+                    do_not_optimize(
+                        chunks.ray_cast(origins[i], directions[i], max_distance)
+                    );
+                }
+            },
+            N_RAYS
+        );
+    }
+}
+
+auto bench_ray_casting_batch() -> void {
+    auto constexpr N_RAYS = usize{1 << 16};
+    auto constexpr MAX_DISTANCE = 64.0f;
+
+    auto const& chunks = world();
+    auto rng = std::mt19937{RANDOM_SEED};
+
+    auto rays = std::vector<Ray>(N_RAYS);
+    auto results = std::vector<RayCastResult>(N_RAYS);
+
+    for (auto& ray : rays) {
+        ray = Ray{
+            .origin = random_point(&rng),
+            .direction = random_direction(&rng),
+            .max_distance = MAX_DISTANCE,
+        };
+    }
+
+    bench(
+        "ray_cast_single_64", 4,
+        [&] {
+            for (usize i = 0; i < N_RAYS; ++i) {
+                results[i] = chunks.ray_cast(
+                    rays[i].origin, rays[i].direction, rays[i].max_distance
+                );
+            }
+
+            do_not_optimize(results.data());
+        },
+        N_RAYS
+    );
+
+    bench(
+        "ray_cast_batch_64", 4,
+        [&] {
+            chunks.ray_cast_batch(rays, results);
+            do_not_optimize(results.data());
+        },
+        N_RAYS
+    );
+}
+
+auto bench_collision_scans() -> void {
+    auto constexpr N_BOXES = usize{4096};
+    auto constexpr BOX_SIZE = glm::vec3{0.6f, 1.75f, 0.6f};
+
+    auto const& chunks = world();
+    auto rng = std::mt19937{RANDOM_SEED};
+    auto boxes = std::vector<Aabb>(N_BOXES);
+
+    for (auto& box : boxes) {
+        auto const lo = random_point(&rng);
+        box = Aabb{lo, lo + BOX_SIZE};
+    }
+
+    bench(
+        "collision_box_scan", 100,
+        [&] {
+            auto n_solid = usize{0};
+
+            for (auto const box : boxes) {
+                auto const lo = glm::uvec3{glm::round(box.lo - 0.5f)};
+                auto const hi = glm::uvec3{glm::round(box.hi - 0.5f)};
+
+                for (u32 x = lo.x; x <= hi.x; ++x) {
+                    for (u32 y = lo.y; y <= hi.y; ++y) {
+                        for (u32 z = lo.z; z <= hi.z; ++z) {
+                            auto const voxel = chunks.get_voxel({x, y, z});
+                            n_solid += voxel.has_value() && 0 != voxel->id;
+                        }
+                    }
+                }
+            }
+
+            do_not_optimize(n_solid);
+        },
+        N_BOXES
+    );
+
+    auto cells = std::vector<glm::uvec3>{};
+
+    bench(
+        "collision_box_occupancy", 100,
+        [&] {
+            for (auto const box : boxes) {
+                auto const lo = glm::uvec3{glm::round(box.lo - 0.5f)};
+                auto const hi = glm::uvec3{glm::round(box.hi - 0.5f)};
+
+                cells.clear();
+                chunks.solid_cells_in(lo, hi, &cells);
+            }
+
+            do_not_optimize(cells.data());
+        },
+        N_BOXES
+    );
+}
+
+auto bench_structure_pasting() -> void {
+    auto constexpr STRUCTURE_SIZE = glm::uvec3{64};
+
+    auto chunks = ChunkArray{WORLD_SIZES};
+    auto structure = VoxelStructure{STRUCTURE_SIZE};
+    auto rng = std::mt19937{RANDOM_SEED};
+
+    for (u32 y = 0; y < STRUCTURE_SIZE.y; ++y) {
+        for (u32 z = 0; z < STRUCTURE_SIZE.z; ++z) {
+            for (u32 x = 0; x < STRUCTURE_SIZE.x; ++x) {
+                structure.set_voxel({x, y, z}, Voxel{(VoxelId) (rng() % 4), 0});
+            }
+        }
+    }
+
+    auto n_edited_chunks = usize{0};
+
+    bench(
+        "paste_structure_64", 100,
+        [&] {
+            chunks.paste_structure(
+                structure, glm::uvec3{32, 0, 32},
+                [&](glm::uvec3, glm::uvec3, glm::uvec3) { ++n_edited_chunks; }
+            );
+
+            do_not_optimize(n_edited_chunks);
+        },
+        STRUCTURE_SIZE.x * STRUCTURE_SIZE.y * STRUCTURE_SIZE.z
+    );
+}
+
+}  // namespace tmine_bench
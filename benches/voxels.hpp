@@ -0,0 +1,13 @@
+#pragma once
+
+namespace tmine_bench {
+
+auto bench_voxel_layout_indexing() -> void;
+auto bench_chunk_generation() -> void;
+auto bench_chunk_meshing() -> void;
+auto bench_ray_casting() -> void;
+auto bench_ray_casting_batch() -> void;
+auto bench_collision_scans() -> void;
+auto bench_structure_pasting() -> void;
+
+}  // namespace tmine_bench
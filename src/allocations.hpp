@@ -0,0 +1,174 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#include "types.hpp"
+
+namespace tmine {
+
+#ifdef TMINE_TRACK_ALLOCATIONS
+inline auto constexpr ALLOCATION_TRACKING_IS_ENABLED = true;
+#else
+inline auto constexpr ALLOCATION_TRACKING_IS_ENABLED = false;
+#endif
+
+/// Subsystems heap memory is accounted to.
+enum class AllocationTag : u8 {
+    Untagged = 0,
+    Chunks,
+    MeshBuffers,
+    ThreadsafeVec,
+    Fonts,
+    Images,
+};
+
+inline auto constexpr N_ALLOCATION_TAGS = usize{6};
+
+struct AllocationStats {
+    u64 live_bytes{0};
+    /// Allocations made during the last finished frame.
+    u64 n_frame_allocations{0};
+};
+
+/// Live bytes and allocation counts per tag. Accounting may happen on any
+/// thread, it only touches atomics. Everything else belongs to the main
+/// thread.
+class AllocationRegistry {
+public:
+    inline auto add_allocation(
+        this AllocationRegistry& self, AllocationTag tag, u64 n_bytes
+    ) noexcept -> void {
+        self.live_bytes[(usize) tag].fetch_add(
+            n_bytes, std::memory_order_relaxed
+        );
+        self.n_allocations[(usize) tag].fetch_add(
+            1, std::memory_order_relaxed
+        );
+    }
+
+    inline auto add_deallocation(
+        this AllocationRegistry& self, AllocationTag tag, u64 n_bytes
+    ) noexcept -> void {
+        self.live_bytes[(usize) tag].fetch_sub(
+            n_bytes, std::memory_order_relaxed
+        );
+    }
+
+    /// Remembers allocation counts, so that the next frame counts from zero.
+    auto finish_frame(this AllocationRegistry& self) noexcept -> void;
+
+    auto get_stats(this AllocationRegistry const& self, AllocationTag tag)
+        -> AllocationStats;
+
+    /// Allocations of all tags during the last finished frame.
+    auto get_n_frame_allocations(this AllocationRegistry const& self) noexcept
+        -> u64;
+
+    /// Allocations of all tags since the start of the program.
+    auto get_n_allocations(this AllocationRegistry const& self) noexcept
+        -> u64;
+
+private:
+    std::array<std::atomic<u64>, N_ALLOCATION_TAGS> live_bytes{};
+    std::array<std::atomic<u64>, N_ALLOCATION_TAGS> n_allocations{};
+    std::array<u64, N_ALLOCATION_TAGS> frame_start_counts{};
+    std::array<u64, N_ALLOCATION_TAGS> last_frame_counts{};
+};
+
+namespace allocations {
+
+    inline constinit auto REGISTRY = AllocationRegistry{};
+
+    /// Accounts memory a container got from `malloc` directly. Does nothing
+    /// without `TMINE_TRACK_ALLOCATIONS`.
+    inline auto on_allocate(AllocationTag tag, usize n_bytes) noexcept
+        -> void {
+        if constexpr (ALLOCATION_TRACKING_IS_ENABLED) {
+            REGISTRY.add_allocation(tag, n_bytes);
+        }
+    }
+
+    inline auto on_deallocate(AllocationTag tag, usize n_bytes) noexcept
+        -> void {
+        if constexpr (ALLOCATION_TRACKING_IS_ENABLED) {
+            REGISTRY.add_deallocation(tag, n_bytes);
+        }
+    }
+
+    /// Tag global `new` on the calling thread accounts memory to.
+    auto current_tag() noexcept -> AllocationTag;
+
+    auto name_of(AllocationTag tag) noexcept -> char const*;
+
+    /// Finishes the frame of the global registry and shows its stats in
+    /// the debug text.
+    auto update() -> void;
+
+}  // namespace allocations
+
+/// Accounts global `new` on this thread to `tag` for its lifetime.
+class AllocationScope {
+public:
+    explicit AllocationScope(AllocationTag tag) noexcept;
+    ~AllocationScope();
+
+    AllocationScope(AllocationScope const&) = delete;
+    auto operator=(this AllocationScope&, AllocationScope const&)
+        -> AllocationScope& = delete;
+
+private:
+    AllocationTag prev_tag;
+};
+
+/// Standard allocator accounting its memory to `Tag`. Takes memory from
+/// `malloc`, so that global `new` does not count it twice.
+template <class T, AllocationTag Tag>
+struct TrackingAllocator {
+    using value_type = T;
+
+    static_assert(alignof(T) <= alignof(std::max_align_t));
+
+    TrackingAllocator() noexcept = default;
+
+    template <class U>
+    TrackingAllocator(TrackingAllocator<U, Tag> const&) noexcept {}
+
+    template <class U>
+    struct rebind {
+        using other = TrackingAllocator<U, Tag>;
+    };
+
+    inline auto allocate(this TrackingAllocator const&, usize n_values)
+        -> T* {
+        auto const n_bytes = sizeof(T) * n_values;
+        auto const ptr = (T*) std::malloc(n_bytes);
+
+        if (nullptr == ptr) {
+            throw std::bad_alloc{};
+        }
+
+        allocations::on_allocate(Tag, n_bytes);
+
+        return ptr;
+    }
+
+    inline auto deallocate(
+        this TrackingAllocator const&, T* ptr, usize n_values
+    ) noexcept -> void {
+        allocations::on_deallocate(Tag, sizeof(T) * n_values);
+        std::free(ptr);
+    }
+
+    template <class U>
+    inline auto operator==(
+        this TrackingAllocator const&, TrackingAllocator<U, Tag> const&
+    ) noexcept -> bool {
+        return true;
+    }
+};
+
+}  // namespace tmine
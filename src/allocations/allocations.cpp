@@ -0,0 +1,288 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <fmt/format.h>
+
+#include "../allocations.hpp"
+#include "../debug.hpp"
+
+namespace tmine {
+
+static constinit thread_local auto current_allocation_tag =
+    AllocationTag::Untagged;
+
+auto AllocationRegistry::finish_frame(this AllocationRegistry& self) noexcept
+    -> void {
+    for (usize i = 0; i < N_ALLOCATION_TAGS; ++i) {
+        auto const count =
+            self.n_allocations[i].load(std::memory_order_relaxed);
+
+        self.last_frame_counts[i] = count - self.frame_start_counts[i];
+        self.frame_start_counts[i] = count;
+    }
+}
+
+auto AllocationRegistry::get_stats(
+    this AllocationRegistry const& self, AllocationTag tag
+) -> AllocationStats {
+    return AllocationStats{
+        .live_bytes =
+            self.live_bytes[(usize) tag].load(std::memory_order_relaxed),
+        .n_frame_allocations = self.last_frame_counts[(usize) tag],
+    };
+}
+
+auto AllocationRegistry::get_n_frame_allocations(
+    this AllocationRegistry const& self
+) noexcept -> u64 {
+    auto result = u64{0};
+
+    for (auto const count : self.last_frame_counts) {
+        result += count;
+    }
+
+    return result;
+}
+
+auto AllocationRegistry::get_n_allocations(this AllocationRegistry const& self
+) noexcept -> u64 {
+    auto result = u64{0};
+
+    for (auto const& count : self.n_allocations) {
+        result += count.load(std::memory_order_relaxed);
+    }
+
+    return result;
+}
+
+AllocationScope::AllocationScope(AllocationTag tag) noexcept
+: prev_tag{current_allocation_tag} {
+    current_allocation_tag = tag;
+}
+
+AllocationScope::~AllocationScope() {
+    current_allocation_tag = this->prev_tag;
+}
+
+namespace allocations {
+
+    auto current_tag() noexcept -> AllocationTag {
+        return current_allocation_tag;
+    }
+
+    static auto constexpr TAG_NAMES =
+        std::array<char const*, N_ALLOCATION_TAGS>{
+            "Untagged",       "Chunks", "Mesh buffers",
+            "ThreadsafeVec", "Fonts",  "Images",
+        };
+
+    auto name_of(AllocationTag tag) noexcept -> char const* {
+        return TAG_NAMES[(usize) tag];
+    }
+
+    // Digits keep the lines in this order in the debug text
+    static auto constexpr TAG_KEYS =
+        std::array<char const*, N_ALLOCATION_TAGS>{
+            "allocations#0", "allocations#1", "allocations#2",
+            "allocations#3", "allocations#4", "allocations#5",
+        };
+
+    auto update() -> void {
+        if constexpr (!ALLOCATION_TRACKING_IS_ENABLED) {
+            return;
+        }
+
+        REGISTRY.finish_frame();
+
+        // Rebuilding text lines is not free, skip it when nobody sees them
+        if (!DEBUG_IS_ENABLED) {
+            return;
+        }
+
+        auto text = debug::text();
+
+        for (usize i = 0; i < N_ALLOCATION_TAGS; ++i) {
+            auto const stats = REGISTRY.get_stats((AllocationTag) i);
+
+            text->set_formatted(
+                TAG_KEYS[i], "{}: {:.2f} MiB live, {} allocations/frame",
+                name_of((AllocationTag) i),
+                (f64) stats.live_bytes / (f64) (1 << 20),
+                stats.n_frame_allocations
+            );
+        }
+    }
+
+}  // namespace allocations
+
+}  // namespace tmine
+
+#ifdef TMINE_TRACK_ALLOCATIONS
+
+using tmine::usize;
+
+/// Precedes every block from global `new`, so that `delete` knows how much
+/// to account and to which tag.
+struct alignas(std::max_align_t) AllocationHeader {
+    usize n_bytes;
+    tmine::AllocationTag tag;
+};
+
+static auto header_size_of(usize alignment) noexcept -> usize {
+    return std::max(alignment, sizeof(AllocationHeader));
+}
+
+static auto tracked_allocate(usize n_bytes, usize alignment) noexcept
+    -> void* {
+    auto const header_size = header_size_of(alignment);
+    auto const n_total_bytes = header_size + std::max(n_bytes, usize{1});
+
+    auto const block =
+        alignment <= alignof(std::max_align_t)
+            ? std::malloc(n_total_bytes)
+            : std::aligned_alloc(
+                  alignment,
+                  (n_total_bytes + alignment - 1) / alignment * alignment
+              );
+
+    if (nullptr == block) {
+        return nullptr;
+    }
+
+    auto const ptr = (std::byte*) block + header_size;
+    auto const header = (AllocationHeader*) (ptr - sizeof(AllocationHeader));
+    auto const tag = tmine::allocations::current_tag();
+
+    header->n_bytes = n_bytes;
+    header->tag = tag;
+
+    tmine::allocations::REGISTRY.add_allocation(tag, n_bytes);
+
+    return ptr;
+}
+
+static auto tracked_deallocate(void* ptr, usize alignment) noexcept -> void {
+    if (nullptr == ptr) {
+        return;
+    }
+
+    auto const bytes = (std::byte*) ptr;
+    auto const header = (AllocationHeader*) (bytes - sizeof(AllocationHeader));
+
+    tmine::allocations::REGISTRY.add_deallocation(header->tag, header->n_bytes);
+
+    std::free(bytes - header_size_of(alignment));
+}
+
+static auto tracked_allocate_or_throw(usize n_bytes, usize alignment)
+    -> void* {
+    while (true) {
+        if (auto const ptr = tracked_allocate(n_bytes, alignment)) {
+            return ptr;
+        }
+
+        auto const handler = std::get_new_handler();
+
+        if (nullptr == handler) {
+            throw std::bad_alloc{};
+        }
+
+        handler();
+    }
+}
+
+static auto constexpr DEFAULT_ALIGNMENT = alignof(std::max_align_t);
+
+auto operator new(usize n_bytes) -> void* {
+    return tracked_allocate_or_throw(n_bytes, DEFAULT_ALIGNMENT);
+}
+
+auto operator new[](usize n_bytes) -> void* {
+    return tracked_allocate_or_throw(n_bytes, DEFAULT_ALIGNMENT);
+}
+
+auto operator new(usize n_bytes, std::align_val_t alignment) -> void* {
+    return tracked_allocate_or_throw(n_bytes, (usize) alignment);
+}
+
+auto operator new[](usize n_bytes, std::align_val_t alignment) -> void* {
+    return tracked_allocate_or_throw(n_bytes, (usize) alignment);
+}
+
+auto operator new(usize n_bytes, std::nothrow_t const&) noexcept -> void* {
+    return tracked_allocate(n_bytes, DEFAULT_ALIGNMENT);
+}
+
+auto operator new[](usize n_bytes, std::nothrow_t const&) noexcept -> void* {
+    return tracked_allocate(n_bytes, DEFAULT_ALIGNMENT);
+}
+
+auto operator new(
+    usize n_bytes, std::align_val_t alignment, std::nothrow_t const&
+) noexcept -> void* {
+    return tracked_allocate(n_bytes, (usize) alignment);
+}
+
+auto operator new[](
+    usize n_bytes, std::align_val_t alignment, std::nothrow_t const&
+) noexcept -> void* {
+    return tracked_allocate(n_bytes, (usize) alignment);
+}
+
+auto operator delete(void* ptr) noexcept -> void {
+    tracked_deallocate(ptr, DEFAULT_ALIGNMENT);
+}
+
+auto operator delete[](void* ptr) noexcept -> void {
+    tracked_deallocate(ptr, DEFAULT_ALIGNMENT);
+}
+
+auto operator delete(void* ptr, usize) noexcept -> void {
+    tracked_deallocate(ptr, DEFAULT_ALIGNMENT);
+}
+
+auto operator delete[](void* ptr, usize) noexcept -> void {
+    tracked_deallocate(ptr, DEFAULT_ALIGNMENT);
+}
+
+auto operator delete(void* ptr, std::align_val_t alignment) noexcept -> void {
+    tracked_deallocate(ptr, (usize) alignment);
+}
+
+auto operator delete[](void* ptr, std::align_val_t alignment) noexcept
+    -> void {
+    tracked_deallocate(ptr, (usize) alignment);
+}
+
+auto operator delete(void* ptr, usize, std::align_val_t alignment) noexcept
+    -> void {
+    tracked_deallocate(ptr, (usize) alignment);
+}
+
+auto operator delete[](void* ptr, usize, std::align_val_t alignment) noexcept
+    -> void {
+    tracked_deallocate(ptr, (usize) alignment);
+}
+
+auto operator delete(void* ptr, std::nothrow_t const&) noexcept -> void {
+    tracked_deallocate(ptr, DEFAULT_ALIGNMENT);
+}
+
+auto operator delete[](void* ptr, std::nothrow_t const&) noexcept -> void {
+    tracked_deallocate(ptr, DEFAULT_ALIGNMENT);
+}
+
+auto operator delete(
+    void* ptr, std::align_val_t alignment, std::nothrow_t const&
+) noexcept -> void {
+    tracked_deallocate(ptr, (usize) alignment);
+}
+
+auto operator delete[](
+    void* ptr, std::align_val_t alignment, std::nothrow_t const&
+) noexcept -> void {
+    tracked_deallocate(ptr, (usize) alignment);
+}
+
+#endif  // TMINE_TRACK_ALLOCATIONS
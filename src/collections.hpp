@@ -13,6 +13,7 @@
 
 #include "types.hpp"
 #include "panic.hpp"
+#include "allocations.hpp"
 
 namespace tmine {
 
@@ -80,12 +81,18 @@ public:
             this->ptr[i].~T();
         }
 
+        allocations::on_deallocate(
+            AllocationTag::ThreadsafeVec, sizeof(T) * this->cap
+        );
         free(this->ptr);
     }
 
     ~ThreadsafeVec()
         requires std::is_trivially_destructible_v<T>
     {
+        allocations::on_deallocate(
+            AllocationTag::ThreadsafeVec, sizeof(T) * this->cap
+        );
         free(this->ptr);
     }
 
@@ -183,10 +190,22 @@ private:
         if (0 == self.cap) {
             self.cap = additional_cap;
             self.ptr = (T*) std::malloc(sizeof(*self.ptr) * self.cap);
+
+            allocations::on_allocate(
+                AllocationTag::ThreadsafeVec, sizeof(T) * self.cap
+            );
         } else if (self.cap - self.len < additional_cap) {
+            allocations::on_deallocate(
+                AllocationTag::ThreadsafeVec, sizeof(T) * self.cap
+            );
+
             self.cap += additional_cap;
             self.ptr =
                 (T*) std::realloc(self.ptr, sizeof(*self.ptr) * self.cap);
+
+            allocations::on_allocate(
+                AllocationTag::ThreadsafeVec, sizeof(T) * self.cap
+            );
         }
 
         self.len += requested_len;
@@ -367,11 +386,23 @@ auto ThreadsafeVecLock<T>::reserve_exact(
         self.parent->cap = amount;
         self.parent->ptr =
             (T*) std::malloc(sizeof(*self.parent->ptr) * self.parent->cap);
+
+        allocations::on_allocate(
+            AllocationTag::ThreadsafeVec, sizeof(T) * self.parent->cap
+        );
     } else if (self.capacity() - self.size() < amount) {
+        allocations::on_deallocate(
+            AllocationTag::ThreadsafeVec, sizeof(T) * self.parent->cap
+        );
+
         self.parent->cap += amount;
         self.parent->ptr = (T*) std::realloc(
             self.parent->ptr, sizeof(*self.parent->ptr) * self.parent->cap
         );
+
+        allocations::on_allocate(
+            AllocationTag::ThreadsafeVec, sizeof(T) * self.parent->cap
+        );
     }
 }
 
@@ -82,9 +82,43 @@ struct VelocityDynamics {
     glm::vec3 velocity_rate_of_change{0.0f};
 };
 
+/// Everything a fixed update of the player reads from the user, so that
+/// ticks can be recorded and replayed without `io`.
+struct PlayerTickInput {
+    u8 pressed{0};
+    PlayerMovement movement{PlayerMovement::Walk};
+    glm::vec2 camera_angles{0.0f};
+
+    inline auto is_pressed(this PlayerTickInput const& self, u8 action) noexcept
+        -> bool {
+        return 0 != (self.pressed & action);
+    }
+
+    static auto constexpr FORWARD = u8{1 << 0};
+    static auto constexpr BACKWARD = u8{1 << 1};
+    static auto constexpr RIGHT = u8{1 << 2};
+    static auto constexpr LEFT = u8{1 << 3};
+    static auto constexpr JUMP = u8{1 << 4};
+    static auto constexpr DESCEND = u8{1 << 5};
+    static auto constexpr SPRINT = u8{1 << 6};
+    static auto constexpr RESPAWN = u8{1 << 7};
+};
+
+/// Simulated state of the player, enough to continue fixed updates from.
+struct PlayerState {
+    Aabb box{};
+    glm::vec3 velocity{0.0f};
+    glm::vec3 acceleration{0.0f};
+    FovDynamics fov_dynamics{};
+    VelocityDynamics velocity_dynamics{};
+    PlayerMovement movement{PlayerMovement::Walk};
+    glm::vec2 camera_angles{0.0f};
+    f32 fov{0.0f};
+};
+
 class Player {
 public:
-    explicit Player(Terrain const& terrain, RefMut<PhysicsSolver> solver);
+    explicit Player(ChunkArray const& chunks, RefMut<PhysicsSolver> solver);
 
     auto update(
         this Player& self, RefMut<PhysicsSolver> solver,
@@ -93,10 +127,34 @@ public:
     ) -> void;
 
     auto fixed_update(
-        this Player& self, f32 time_step, Terrain const& terrain,
-        RefMut<PhysicsSolver> solver
+        this Player& self, f32 time_step, ChunkArray const& chunks,
+        RefMut<PhysicsSolver> solver, PlayerTickInput const& input
     ) -> void;
 
+    /// Turns the camera by `mouse_delta` pixels, called between fixed
+    /// updates, which take the angles from their input.
+    auto look(
+        this Player& self, glm::vec2 mouse_delta, glm::uvec2 viewport_size
+    ) -> void;
+
+    /// Switches between walking and flying for the next fixed updates.
+    auto toggle_movement(this Player& self) noexcept -> void;
+
+    /// Polls `io` for the input of the next fixed update.
+    auto poll_tick_input(this Player const& self) -> PlayerTickInput;
+
+    auto get_state(this Player const& self, RefMut<PhysicsSolver> solver)
+        -> PlayerState;
+
+    auto set_state(
+        this Player& self, RefMut<PhysicsSolver> solver,
+        PlayerState const& state
+    ) -> void;
+
+    /// Places the camera between its positions after the last two fixed
+    /// updates, `alpha` is the fraction of a tick passed since the last one.
+    auto interpolate(this Player& self, f32 alpha) -> void;
+
     inline auto get_camera(this Player const& self) -> Camera const& {
         return self.camera;
     }
@@ -104,6 +162,8 @@ public:
 private:
     ColliderId collider_id;
     Camera camera;
+    glm::vec3 prev_tick_camera_pos;
+    glm::vec3 tick_camera_pos;
     FovDynamics fov_dynamics;
     VelocityDynamics velocity_dynamics;
     PlayerMovement movement{PlayerMovement::Walk};
@@ -1,3 +1,6 @@
+#include <array>
+#include <utility>
+
 #include "../controls.hpp"
 #include "../objects.hpp"
 #include "../events.hpp"
@@ -17,23 +20,6 @@ static auto lerp(auto a, auto b, f32 param) {
     return (1.0f - param) * a + param * b;
 }
 
-static auto rotate_camera_by_mouse(
-    RefMut<glm::vec2> camera_mouse_angles, RefMut<Camera> camera,
-    glm::uvec2 viewport_size
-) -> void {
-    camera_mouse_angles->x -=
-        io.get_mouse_delta().y / viewport_size.y * MOUSE_SENSITIVITY;
-    camera_mouse_angles->y -=
-        io.get_mouse_delta().x / viewport_size.x * MOUSE_SENSITIVITY;
-
-    camera_mouse_angles->x = glm::clamp(
-        camera_mouse_angles->x, glm::radians(-89.9f), glm::radians(89.9f)
-    );
-
-    camera->reset_rotation();
-    camera->rotate({*camera_mouse_angles, 0.0f});
-}
-
 static auto pick_new_voxel(RefMut<VoxelId> id) -> void {
     for (u32 i = 0; i < 9; i++) {
         auto key = Key{(u32) Key::Key1 + i};
@@ -110,11 +96,10 @@ static auto update_fov_dynamics(
     camera->set_fov(fov);
 }
 
-static auto is_grounded(BoxCollider const& box, Terrain const& terrain)
-    -> bool {
+static auto is_grounded(Aabb box, ChunkArray const& chunks) -> bool {
     auto constexpr TOLERANCE = 0.001f;
 
-    auto displaced_box = box.box;
+    auto displaced_box = box;
     displaced_box.lo.x += TOLERANCE;
     displaced_box.lo.y -= TOLERANCE;
     displaced_box.lo.z += TOLERANCE;
@@ -125,56 +110,51 @@ static auto is_grounded(BoxCollider const& box, Terrain const& terrain)
         glm::vec3{displaced_box.hi.x, displaced_box.lo.y, displaced_box.hi.z} - 0.5f
     );
 
-    for (u32 x = lo.x; x <= hi.x; ++x) {
-        u32 const y = lo.y;
-
-        for (u32 z = lo.z; z <= hi.z; ++z) {
-            auto const voxel = terrain.get_array().get_voxel({x, y, z});
-
-            if (voxel.has_value() && 0 != voxel->id) {
-                return true;
-            }
-        }
+    if (glm::any(glm::lessThan(hi, glm::vec3{0.0f}))) {
+        return false;
     }
 
-    return false;
+    return chunks.any_solid_in(
+        glm::uvec3{glm::max(lo, glm::vec3{0.0f})}, glm::uvec3{hi}
+    );
 }
 
 static auto update_movement(
-    f32 time_step, RefMut<Camera> camera, RefMut<BoxCollider> collider,
-    Terrain const& terrain, PlayerMovement movement,
+    f32 time_step, RefMut<Camera> camera, BoxColliderRef collider,
+    ChunkArray const& chunks, PlayerTickInput const& input,
     RefMut<FovDynamics> fov_dynamics, RefMut<VelocityDynamics> velocity_dynamics
 ) -> void {
+    auto const movement = input.movement;
     auto velocity_direction = glm::vec3{0.0f};
 
-    if (io.is_pressed(Key::W)) {
+    if (input.is_pressed(PlayerTickInput::FORWARD)) {
         velocity_direction += camera->get_move_direction();
     }
 
-    if (io.is_pressed(Key::S)) {
+    if (input.is_pressed(PlayerTickInput::BACKWARD)) {
         velocity_direction -= camera->get_move_direction();
     }
 
-    if (io.is_pressed(Key::D)) {
+    if (input.is_pressed(PlayerTickInput::RIGHT)) {
         velocity_direction += camera->get_right_direction();
     }
 
-    if (io.is_pressed(Key::A)) {
+    if (input.is_pressed(PlayerTickInput::LEFT)) {
         velocity_direction -= camera->get_right_direction();
     }
 
     if (PlayerMovement::Fly == movement) {
-        if (io.is_pressed(Key::Space)) {
+        if (input.is_pressed(PlayerTickInput::JUMP)) {
             velocity_direction.y += 1.0f;
         }
 
-        if (io.is_pressed(Key::LeftShift)) {
+        if (input.is_pressed(PlayerTickInput::DESCEND)) {
             velocity_direction.y -= 1.0f;
         }
 
-        collider->set_collider_acceleration(glm::vec3{0.0f});
+        collider.set_acceleration(glm::vec3{0.0f});
     } else {
-        collider->set_collider_acceleration(GRAVITY_ACCELERATION);
+        collider.set_acceleration(GRAVITY_ACCELERATION);
     }
 
     if (velocity_direction != glm::vec3{0.0f}) {
@@ -184,14 +164,14 @@ static auto update_movement(
     auto speed =
         PlayerMovement::Walk == movement ? MIN_SPEED : 2.0f * MIN_SPEED;
 
-    if (io.is_pressed(Key::LeftControl)) {
+    if (input.is_pressed(PlayerTickInput::SPRINT)) {
         speed *= 3.0f;
     }
 
     auto target_velocity = speed * velocity_direction;
-    auto prev_velocity = collider->get_collider_velocity();
+    auto prev_velocity = collider.get_velocity();
 
-    auto const collider_box = collider->get_collidable_bounding_box();
+    auto const collider_box = collider.get_box();
     auto const camera_pos =
         0.5f *
         (collider_box.hi +
@@ -199,20 +179,6 @@ static auto update_movement(
              collider_box.lo.x, collider_box.hi.y - 0.25f, collider_box.lo.z
          });
 
-    debug::text()->set(
-        "camera", fmt::format(
-                      "x: {:.2f}, y: {:.2f}, z: {:.2f}", camera_pos.x,
-                      camera_pos.y, camera_pos.z
-                  )
-    );
-
-    debug::text()->set(
-        "orientation", fmt::format(
-                           "Orientation: {}",
-                           get_orientation_string(camera->get_front_direction())
-                       )
-    );
-
     camera->set_pos(camera_pos);
 
     auto const speed_for_fov =
@@ -268,12 +234,14 @@ static auto update_movement(
     }
 
     if (PlayerMovement::Walk == movement) {
-        if (is_grounded(*collider, terrain) && io.is_pressed(Key::Space)) {
+        if (input.is_pressed(PlayerTickInput::JUMP) &&
+            is_grounded(collider_box, chunks))
+        {
             next_velocity.y = 0.7f * speed;
         }
     }
 
-    collider->set_collider_velocity(next_velocity);
+    collider.set_velocity(next_velocity);
 }
 
 static auto draw_selection_box(
@@ -338,7 +306,7 @@ static auto draw_selection_box(
 
 static auto interact_with_terrain(
     RefMut<Terrain> terrain, RefMut<SelectionBox> selection_box,
-    BoxCollider const& player_collider, Camera const& camera,
+    Aabb player_box, Camera const& camera,
     VoxelId held_voxel_id
 ) -> void {
     auto constexpr MAX_DISTANCE = 1000.0f;
@@ -361,36 +329,20 @@ static auto interact_with_terrain(
     auto const look_voxel =
         terrain->get_array().get_voxel(ray_cast_result.voxel_pos).value();
 
-    debug::text()->set(
-        "look_on", fmt::format(
-                       "Look on '{}'",
-                       terrain->get_data()
-                           .get_block(look_voxel.id, look_voxel.orientation())
-                           .name
-                   )
+    debug::text()->set_formatted(
+        "look_on", "Look on '{}'",
+        terrain->get_data()
+            .get_block(look_voxel.id, look_voxel.orientation())
+            .name
     );
 
     if (io.clicked(MouseButton::Left)) {
         terrain->set_voxel(ray_cast_result.voxel_pos, {});
 
 #if EXCAVATE
-        auto constexpr RADIUS = i32{15};
-
-        for (i32 x = -RADIUS; x <= RADIUS; ++x) {
-            for (i32 y = -RADIUS; y <= RADIUS; ++y) {
-                for (i32 z = -RADIUS; z <= RADIUS; ++z) {
-                    auto const pos = glm::vec3{x, y, z};
-
-                    if (glm::dot(pos, pos) <= RADIUS * RADIUS) {
-                        terrain->set_voxel(
-                            glm::ivec3{ray_cast_result.voxel_pos} +
-                                glm::ivec3{x, y, z},
-                            {}
-                        );
-                    }
-                }
-            }
-        }
+        auto constexpr RADIUS = u32{15};
+
+        terrain->replace_in_sphere(ray_cast_result.voxel_pos, RADIUS, {});
 #endif
     }
 
@@ -413,7 +365,7 @@ static auto interact_with_terrain(
     auto constexpr PUSHOUT_THREASHOLD = 0.5f;
 
     auto const intersection_size =
-        player_collider.box.intersection(new_voxel_box).size();
+        player_box.intersection(new_voxel_box).size();
 
     auto const player_is_pushable =
         std::min({intersection_size.x, intersection_size.y, intersection_size.z}
@@ -425,30 +377,19 @@ static auto interact_with_terrain(
         );
 
 #if EXCAVATE
-        auto constexpr RADIUS = i32{10};
-
-        for (i32 x = -RADIUS; x <= RADIUS; ++x) {
-            for (i32 y = -RADIUS; y <= RADIUS; ++y) {
-                for (i32 z = -RADIUS; z <= RADIUS; ++z) {
-                    auto const pos = glm::vec3{x, y, z};
-
-                    if (glm::dot(pos, pos) <= RADIUS * RADIUS) {
-                        terrain->set_voxel(
-                            glm::ivec3{ray_cast_result.voxel_pos} +
-                                glm::ivec3{x, y, z},
-                            {held_voxel_id, Voxel::make_meta(orientation)}
-                        );
-                    }
-                }
-            }
-        }
+        auto constexpr RADIUS = u32{10};
+
+        terrain->replace_in_sphere(
+            ray_cast_result.voxel_pos, RADIUS,
+            {held_voxel_id, Voxel::make_meta(orientation)}
+        );
 #endif
     }
 }
 
-static auto reset_collider(Terrain const& terrain, RefMut<BoxCollider> collider)
+static auto reset_collider(ChunkArray const& chunks, BoxColliderRef collider)
     -> void {
-    auto const world_size = terrain.get_array().size() * Chunk::SIZE;
+    auto const world_size = chunks.size() * Chunk::SIZE;
     auto surface_center = glm::uvec3{
         world_size.x / 2,
         world_size.y,
@@ -457,7 +398,7 @@ static auto reset_collider(Terrain const& terrain, RefMut<BoxCollider> collider)
 
     // TODO(hack3rmann): check all voxels that may hit player's collider
     for (; surface_center.y != 0; --surface_center.y) {
-        auto voxel = terrain.get_array().get_voxel(surface_center);
+        auto voxel = chunks.get_voxel(surface_center);
 
         if (voxel.has_value() && voxel->id != 0) {
             break;
@@ -470,77 +411,189 @@ static auto reset_collider(Terrain const& terrain, RefMut<BoxCollider> collider)
         surface_center.y = world_size.y;
     }
 
-    collider->box =
-        Aabb{surface_center, glm::vec3{surface_center} + COLLIDER_SIZE};
-    collider->set_collider_velocity(glm::vec3{0.0f});
+    collider.set_box(
+        Aabb{surface_center, glm::vec3{surface_center} + COLLIDER_SIZE}
+    );
+    collider.set_velocity(glm::vec3{0.0f});
 }
 
-static auto spawn_collider(Terrain const& terrain, RefMut<PhysicsSolver> solver)
-    -> ColliderId {
-    auto collider = BoxCollider{
-        Aabb{INITIAL_POSITION, INITIAL_POSITION + COLLIDER_SIZE},
-        glm::vec3{0.0f},
-        GRAVITY_ACCELERATION,
-        ABSOLUTELY_INELASTIC_ELASTICITY,
-    };
+static auto spawn_collider(
+    ChunkArray const& chunks, RefMut<PhysicsSolver> solver
+) -> ColliderId {
+    auto const id = solver->add(BoxCollider{
+        .box = Aabb{INITIAL_POSITION, INITIAL_POSITION + COLLIDER_SIZE},
+        .velocity = glm::vec3{0.0f},
+        .acceleration = GRAVITY_ACCELERATION,
+        .elasticity = ABSOLUTELY_INELASTIC_ELASTICITY,
+    });
 
-    reset_collider(terrain, &collider);
+    reset_collider(chunks, solver->get_box_collider(id));
 
-    return solver->register_collidable<BoxCollider>(std::move(collider));
+    return id;
 }
 
-Player::Player(Terrain const& terrain, RefMut<PhysicsSolver> solver)
-: collider_id{spawn_collider(terrain, solver)}
+Player::Player(ChunkArray const& chunks, RefMut<PhysicsSolver> solver)
+: collider_id{spawn_collider(chunks, solver)}
 , camera{INITIAL_POSITION, glm::radians(60.0f)}
+, prev_tick_camera_pos{INITIAL_POSITION}
+, tick_camera_pos{INITIAL_POSITION}
 , camera_mouse_angles{glm::vec3{0.0f}}
 , held_voxel_id{1} {}
 
 auto Player::fixed_update(
-    this Player& self, f32 time_step, Terrain const& terrain,
-    RefMut<PhysicsSolver> solver
+    this Player& self, f32 time_step, ChunkArray const& chunks,
+    RefMut<PhysicsSolver> solver, PlayerTickInput const& input
 ) -> void {
-    auto& collider = solver->get_collidable<BoxCollider>(self.collider_id);
+    auto const collider = solver->get_box_collider(self.collider_id);
+
+    if (input.is_pressed(PlayerTickInput::RESPAWN)) {
+        reset_collider(chunks, collider);
+    }
+
+    self.movement = input.movement;
+    self.camera_mouse_angles = input.camera_angles;
+    self.camera.reset_rotation();
+    self.camera.rotate({self.camera_mouse_angles, 0.0f});
 
     update_movement(
-        time_step, &self.camera, &collider, terrain, self.movement,
-        &self.fov_dynamics, &self.velocity_dynamics
+        time_step, &self.camera, collider, chunks, input, &self.fov_dynamics,
+        &self.velocity_dynamics
+    );
+
+    self.prev_tick_camera_pos = self.tick_camera_pos;
+    self.tick_camera_pos = self.camera.get_pos();
+
+    // Do not sweep the camera across the world after a teleport
+    if (input.is_pressed(PlayerTickInput::RESPAWN)) {
+        self.prev_tick_camera_pos = self.tick_camera_pos;
+    }
+}
+
+auto Player::interpolate(this Player& self, f32 alpha) -> void {
+    self.camera.set_pos(
+        glm::mix(self.prev_tick_camera_pos, self.tick_camera_pos, alpha)
     );
 }
 
+auto Player::poll_tick_input(this Player const& self) -> PlayerTickInput {
+    auto constexpr BINDINGS = std::array<std::pair<Key, u8>, 8>{{
+        {Key::W, PlayerTickInput::FORWARD},
+        {Key::S, PlayerTickInput::BACKWARD},
+        {Key::D, PlayerTickInput::RIGHT},
+        {Key::A, PlayerTickInput::LEFT},
+        {Key::Space, PlayerTickInput::JUMP},
+        {Key::LeftShift, PlayerTickInput::DESCEND},
+        {Key::LeftControl, PlayerTickInput::SPRINT},
+        {Key::P, PlayerTickInput::RESPAWN},
+    }};
+
+    auto input = PlayerTickInput{
+        .movement = self.movement,
+        .camera_angles = self.camera_mouse_angles,
+    };
+
+    for (auto const [key, action] : BINDINGS) {
+        if (io.is_pressed(key)) {
+            input.pressed |= action;
+        }
+    }
+
+    return input;
+}
+
+auto Player::get_state(this Player const& self, RefMut<PhysicsSolver> solver)
+    -> PlayerState {
+    auto const collider = solver->get_box_collider(self.collider_id);
+
+    return PlayerState{
+        .box = collider.get_box(),
+        .velocity = collider.get_velocity(),
+        .acceleration = collider.get_acceleration(),
+        .fov_dynamics = self.fov_dynamics,
+        .velocity_dynamics = self.velocity_dynamics,
+        .movement = self.movement,
+        .camera_angles = self.camera_mouse_angles,
+        .fov = self.camera.get_fov(),
+    };
+}
+
+auto Player::set_state(
+    this Player& self, RefMut<PhysicsSolver> solver, PlayerState const& state
+) -> void {
+    auto const collider = solver->get_box_collider(self.collider_id);
+
+    collider.set_box(state.box);
+    collider.set_velocity(state.velocity);
+    collider.set_acceleration(state.acceleration);
+
+    self.fov_dynamics = state.fov_dynamics;
+    self.velocity_dynamics = state.velocity_dynamics;
+    self.movement = state.movement;
+    self.camera_mouse_angles = state.camera_angles;
+    self.camera.set_fov(state.fov);
+    self.camera.reset_rotation();
+    self.camera.rotate({self.camera_mouse_angles, 0.0f});
+}
+
+auto Player::look(
+    this Player& self, glm::vec2 mouse_delta, glm::uvec2 viewport_size
+) -> void {
+    self.camera_mouse_angles.x -=
+        mouse_delta.y / viewport_size.y * MOUSE_SENSITIVITY;
+    self.camera_mouse_angles.y -=
+        mouse_delta.x / viewport_size.x * MOUSE_SENSITIVITY;
+
+    self.camera_mouse_angles.x = glm::clamp(
+        self.camera_mouse_angles.x, glm::radians(-89.9f), glm::radians(89.9f)
+    );
+
+    self.camera.reset_rotation();
+    self.camera.rotate({self.camera_mouse_angles, 0.0f});
+}
+
+auto Player::toggle_movement(this Player& self) noexcept -> void {
+    if (self.movement == PlayerMovement::Walk) {
+        self.movement = PlayerMovement::Fly;
+    } else {
+        self.movement = PlayerMovement::Walk;
+    }
+}
+
 auto Player::update(
     this Player& self, RefMut<PhysicsSolver> solver, RefMut<Terrain> terrain,
     RefMut<SelectionBox> selection_box, glm::uvec2 viewport_size
 ) -> void {
-    auto& collider = solver->get_collidable<BoxCollider>(self.collider_id);
-
-    if (io.is_pressed(Key::P)) {
-        reset_collider(*terrain, &collider);
-    }
+    auto const collider = solver->get_box_collider(self.collider_id);
 
     if (io.just_pressed(Key::F)) {
-        if (self.movement == PlayerMovement::Walk) {
-            self.movement = PlayerMovement::Fly;
-        } else {
-            self.movement = PlayerMovement::Walk;
-        }
+        self.toggle_movement();
     }
 
-    rotate_camera_by_mouse(
-        &self.camera_mouse_angles, &self.camera, viewport_size
+    self.look(io.get_mouse_delta(), viewport_size);
+
+    auto const camera_pos = self.camera.get_pos();
+
+    debug::text()->set_formatted(
+        "camera", "x: {:.2f}, y: {:.2f}, z: {:.2f}", camera_pos.x,
+        camera_pos.y, camera_pos.z
+    );
+
+    debug::text()->set_formatted(
+        "orientation", "Orientation: {}",
+        get_orientation_string(self.camera.get_front_direction())
     );
 
-    debug::text()->set(
-        "hold", fmt::format(
-                    "Held Block: {}",
-                    terrain->get_data()
-                        .get_block(self.held_voxel_id, Orientation::PosX)
-                        .name
-                )
+    debug::text()->set_formatted(
+        "hold", "Held Block: {}",
+        terrain->get_data()
+            .get_block(self.held_voxel_id, Orientation::PosX)
+            .name
     );
 
     pick_new_voxel(&self.held_voxel_id);
     interact_with_terrain(
-        terrain, selection_box, collider, self.camera, self.held_voxel_id
+        terrain, selection_box, collider.get_box(), self.camera,
+        self.held_voxel_id
     );
 }
 
@@ -1,7 +1,9 @@
 #pragma once
 
+#include <array>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <filesystem>
 #include <glm/glm.hpp>
 
@@ -181,10 +183,86 @@ struct FontPage {
     std::vector<FontKerning> kernings;
 };
 
+/// Slot of the open addressing kerning table of `Font`.
+struct FontKerningSlot {
+    static auto constexpr EMPTY_KEY = ~u32{0};
+
+    u32 key{EMPTY_KEY};
+    i32 amount{0};
+};
+
 struct Font {
+    static auto constexpr N_GLYPHS = usize{256};
+
     FontInfo info;
     FontCommon common;
     std::vector<FontPage> pages;
+
+    /// Index of the glyph of every byte in chars of the first page. Missing
+    /// glyphs map to the glyph with id zero, which BMFont exports for them.
+    std::array<u8, N_GLYPHS> glyph_indices{};
+
+    /// Kerning amounts by pairs of bytes. Its size is zero or a power of
+    /// two, at least half of the slots are empty.
+    std::vector<FontKerningSlot> kerning_slots{};
+
+    inline static auto constexpr kerning_key_of(
+        u32 first, u32 second
+    ) noexcept -> u32 {
+        return first << 8 | second;
+    }
+
+    inline static auto constexpr slot_index_of(
+        u32 key, usize n_slots
+    ) noexcept -> usize {
+        return (usize) ((u64) key * 0x9E3779B97F4A7C15 >> 32) & (n_slots - 1);
+    }
+
+    /// # Safety
+    ///
+    /// The font should have at least one page
+    inline auto glyph_of(this Font const& self, char symbol) noexcept
+        -> FontCharDesc const& {
+        return self.pages.front().chars[self.glyph_indices[(u8) symbol]];
+    }
+
+    inline auto kerning_of(this Font const& self, char first, char second)
+        -> i32 {
+        if (self.kerning_slots.empty()) {
+            return 0;
+        }
+
+        auto const key = Font::kerning_key_of((u8) first, (u8) second);
+        auto const mask = self.kerning_slots.size() - 1;
+
+        for (auto i = Font::slot_index_of(key, self.kerning_slots.size());;
+             i = (i + 1) & mask)
+        {
+            auto const& slot = self.kerning_slots[i];
+
+            if (key == slot.key) {
+                return slot.amount;
+            }
+
+            if (FontKerningSlot::EMPTY_KEY == slot.key) {
+                return 0;
+            }
+        }
+    }
+
+    /// Distance from `text[index]` to the next glyph in font units, kerning
+    /// included.
+    inline auto advance_of(
+        this Font const& self, std::string_view text, usize index
+    ) -> i32 {
+        auto result = (i32) self.glyph_of(text[index]).horizontal_advance;
+
+        if (index + 1 < text.size()) {
+            result += self.kerning_of(text[index], text[index + 1]);
+        }
+
+        return result;
+    }
 };
 
 }  // namespace tmine
@@ -5,6 +5,11 @@
 #include <mutex>
 #include <atomic>
 #include <map>
+#include <memory>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <fmt/format.h>
 
 #include "controls.hpp"
 #include "graphics.hpp"
@@ -23,53 +28,138 @@ struct DebugColor {
     inline static auto constexpr BLUE = glm::vec4{0.0f, 0.0f, 1.0f, 1.0f};
 };
 
+struct DebugLineVertex {
+    glm::vec3 pos;
+    u32 color;
+
+    static auto constexpr ATTRIBUTE_SIZES = std::array<usize, 2>{3, 1};
+};
+
+/// Draws lines submitted through `debug::line` and `debug::box` since the
+/// previous render.
 class DebugLines {
 public:
     DebugLines();
 
-    auto line(
-        this DebugLines& self, glm::vec3 from, glm::vec3 to, glm::vec4 color
+    /// Merges lines of all threads and draws them. Should not overlap with
+    /// submission, i.e. run between updates as `Game` does.
+    auto render(
+        this DebugLines& self, Camera const& cam, glm::uvec2 viewport_size
     ) -> void;
 
-    auto box(
-        this DebugLines& self, glm::vec3 position, glm::vec3 size,
-        glm::vec4 color = DebugColor::BLUE
-    ) -> void;
+private:
+    ShaderProgram shader;
+    Mesh<DebugLineVertex> mesh;
+};
 
-    auto box(
-        this DebugLines& self, Aabb box, glm::vec4 color = DebugColor::BLUE
+/// Glyph quads of text lines in the top left corner, ordered by their
+/// names. Kept apart from GL, so that `DebugText` only uploads them.
+class DebugTextLayout {
+public:
+    explicit DebugTextLayout(std::shared_ptr<Font> font);
+
+    /// Rewrites only the glyphs that changed since the previous value.
+    /// Allocates only for new lines or values longer than ever before, which
+    /// require a new `layout`.
+    auto set(
+        this DebugTextLayout& self, StaticString element,
+        std::string_view value
     ) -> void;
 
-    auto render(
-        this DebugLines& self, Camera const& cam, glm::uvec2 viewport_size
-    ) -> void;
+    /// Formats the value into a reused buffer instead of a new string.
+    template <class... Args>
+    inline auto set_formatted(
+        this DebugTextLayout& self, StaticString element,
+        fmt::format_string<Args...> format, Args&&... args
+    ) -> void {
+        self.format_buffer.clear();
+        fmt::format_to(
+            std::back_inserter(self.format_buffer), format,
+            std::forward<Args>(args)...
+        );
+
+        self.set(
+            std::move(element),
+            std::string_view{
+                self.format_buffer.data(), self.format_buffer.size()
+            }
+        );
+    }
 
-    inline auto lock(this DebugLines& self) -> void { self.mutex.lock(); }
+    /// Places all lines for `viewport_size` and rewrites all quads.
+    auto layout(this DebugTextLayout& self, glm::uvec2 viewport_size) -> void;
 
-    inline auto unlock(this DebugLines& self) -> void { self.mutex.unlock(); }
+    /// Vertices `[first, last)` rewritten since the previous call, empty
+    /// right after `layout`.
+    auto take_dirty_range(this DebugTextLayout& self) noexcept
+        -> std::pair<usize, usize>;
 
-private:
-    struct Vertex {
-        glm::vec3 pos;
-        u32 color;
+    inline auto needs_layout(this DebugTextLayout const& self) noexcept
+        -> bool {
+        return self.is_layout_stale;
+    }
 
-        static auto constexpr ATTRIBUTE_SIZES = std::array<usize, 2>{3, 1};
-    };
+    inline auto get_vertices(this DebugTextLayout const& self) noexcept
+        -> MeshVec<GuiObject::Vertex> const& {
+        return self.vertices;
+    }
+
+public:
+    static auto constexpr N_GLYPH_VERTICES = usize{6};
+
+    /// Values of most lines fit, so that changing them never moves other
+    /// lines.
+    static auto constexpr MIN_LINE_CAPACITY = usize{64};
 
 private:
-    ShaderProgram shader;
-    Mesh<Vertex> mesh;
-    std::mutex mutex;
+    /// Glyphs of a line take `capacity` quads starting from `first_glyph`,
+    /// unused quads are degenerate.
+    struct Line {
+        std::string text{};
+        glm::vec2 origin{0.0f};
+        usize first_glyph{0};
+        usize capacity{0};
+    };
+
+    /// Writes glyphs of `value` to the quads of `line`. Skips glyphs equal to
+    /// `line.text` ones unless `rewrite_all` is set.
+    auto write_glyphs(
+        this DebugTextLayout& self, Line const& line, std::string_view value,
+        bool rewrite_all
+    ) -> void;
+
+    std::map<StaticString, Line> text_lines{};
+    MeshVec<GuiObject::Vertex> vertices{};
+    std::shared_ptr<Font> font;
+    fmt::memory_buffer format_buffer{};
+    f32 font_size{0.0f};
+    usize dirty_begin{0};
+    usize dirty_end{0};
+    bool is_layout_stale{true};
 };
 
+/// Draws `DebugTextLayout` with one mesh in one draw call.
 class DebugText {
 public:
     DebugText(glm::uvec2 viewport_size);
 
     auto render(this DebugText& self, glm::uvec2 viewport_size) -> void;
 
-    auto set(this DebugText& self, StaticString element, std::string_view value)
-        -> void;
+    inline auto set(
+        this DebugText& self, StaticString element, std::string_view value
+    ) -> void {
+        self.glyphs.set(std::move(element), value);
+    }
+
+    template <class... Args>
+    inline auto set_formatted(
+        this DebugText& self, StaticString element,
+        fmt::format_string<Args...> format, Args&&... args
+    ) -> void {
+        self.glyphs.set_formatted(
+            std::move(element), format, std::forward<Args>(args)...
+        );
+    }
 
     inline auto lock(this DebugText& self) -> void { self.mutex.lock(); }
 
@@ -78,8 +168,8 @@ public:
 private:
     ShaderProgram shader;
     Texture glyph_texture;
-    std::map<StaticString, Text> text_lines{};
-    std::shared_ptr<Font> font;
+    DebugTextLayout glyphs;
+    Mesh<GuiObject::Vertex> mesh{Primitive::Triangles};
     std::mutex mutex{};
     glm::uvec2 viewport_size;
 };
@@ -129,12 +219,28 @@ namespace debug {
         TEXT.reset();
     }
 
-    inline auto lines() -> Lock<DebugLines> { return Lock{LINES.value()}; }
+    inline auto lines() -> DebugLines& { return LINES.value(); }
 
     inline auto text() -> Lock<DebugText> { return Lock{TEXT.value()}; }
 
     auto update() -> void;
 
+    /// Appends a line to the buffer of the calling thread, takes no lock.
+    /// Does nothing unless `DEBUG_IS_ENABLED`.
+    auto line(glm::vec3 from, glm::vec3 to, glm::vec4 color) -> void;
+
+    auto box(
+        glm::vec3 position, glm::vec3 size, glm::vec4 color = DebugColor::BLUE
+    ) -> void;
+
+    auto box(Aabb box, glm::vec4 color = DebugColor::BLUE) -> void;
+
+    /// Moves lines submitted by all threads to the end of `vertices`.
+    auto take_lines(RefMut<MeshVec<DebugLineVertex>> vertices) -> void;
+
+    /// Drops lines submitted by all threads.
+    auto discard_lines() -> void;
+
 }  // namespace debug
 
 struct DebugOwner {
@@ -1,3 +1,9 @@
+#include <array>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
 #include "../debug.hpp"
 #include "../loaders.hpp"
 #include "../window.hpp"
@@ -19,71 +25,65 @@ static auto compactify_color(glm::vec4 color) -> u32 {
     return result;
 }
 
-DebugLines::DebugLines()
-: shader{load_shader("debug_lines_vertex.glsl", "debug_lines_fragment.glsl")}
-, mesh{Primitive::Lines}
-, mutex{} {}
+/// Lines of one thread. Only the owning thread appends, the renderer takes
+/// them between updates.
+struct DebugLineBuffer {
+    std::vector<DebugLineVertex> vertices;
+};
 
-auto DebugLines::line(
-    this DebugLines& self, glm::vec3 from, glm::vec3 to, glm::vec4 color
-) -> void {
-    if (!DEBUG_IS_ENABLED) {
-        return;
-    }
+static auto line_buffers_mutex = std::mutex{};
+static auto line_buffers = std::vector<std::shared_ptr<DebugLineBuffer>>{};
+
+static auto register_line_buffer() -> std::shared_ptr<DebugLineBuffer> {
+    auto buffer = std::make_shared<DebugLineBuffer>();
+    auto lock = std::lock_guard{line_buffers_mutex};
 
-    auto const compact_color = compactify_color(color);
-    auto& buffer = self.mesh.get_buffer();
-    buffer.reserve(2);
+    line_buffers.push_back(buffer);
 
-    buffer.emplace_back(from, compact_color);
-    buffer.emplace_back(to, compact_color);
+    return buffer;
 }
 
-auto DebugLines::box(
-    this DebugLines& self, glm::vec3 position, glm::vec3 size, glm::vec4 color
-) -> void {
-    if (!DEBUG_IS_ENABLED) {
-        return;
+/// Empties buffers of all threads after passing their vertices to `visit`.
+/// Buffers of exited threads are owned only by `line_buffers` and are
+/// forgotten then.
+template <class F>
+static auto drain_line_buffers(F&& visit) -> void {
+    auto lock = std::lock_guard{line_buffers_mutex};
+
+    for (auto const& buffer : line_buffers) {
+        visit(std::as_const(buffer->vertices));
+
+        // Keeps the capacity, so that the next frame does not allocate
+        buffer->vertices.clear();
     }
 
-    auto x = position.x;
-    auto y = position.y;
-    auto z = position.z;
-    auto w = size.x;
-    auto h = size.y;
-    auto d = size.z;
-
-    w *= 0.5f;
-    h *= 0.5f;
-    d *= 0.5f;
-
-    self.mesh.get_buffer().reserve(24);
-
-    self.line({x - w, y - h, z - d}, {x + w, y - h, z - d}, color);
-    self.line({x - w, y + h, z - d}, {x + w, y + h, z - d}, color);
-    self.line({x - w, y - h, z + d}, {x + w, y - h, z + d}, color);
-    self.line({x - w, y + h, z + d}, {x + w, y + h, z + d}, color);
-    self.line({x - w, y - h, z - d}, {x - w, y + h, z - d}, color);
-    self.line({x + w, y - h, z - d}, {x + w, y + h, z - d}, color);
-    self.line({x - w, y - h, z + d}, {x - w, y + h, z + d}, color);
-    self.line({x + w, y - h, z + d}, {x + w, y + h, z + d}, color);
-    self.line({x - w, y - h, z - d}, {x - w, y - h, z + d}, color);
-    self.line({x + w, y - h, z - d}, {x + w, y - h, z + d}, color);
-    self.line({x - w, y + h, z - d}, {x - w, y + h, z + d}, color);
-    self.line({x + w, y + h, z - d}, {x + w, y + h, z + d}, color);
+    std::erase_if(line_buffers, [](auto const& buffer) {
+        return 1 == buffer.use_count();
+    });
 }
 
-auto DebugLines::box(this DebugLines& self, Aabb box, glm::vec4 color) -> void {
-    self.box(box.center(), box.size(), color);
+/// Registers the buffer on first use only, submission never locks.
+static auto this_thread_line_buffer() -> DebugLineBuffer& {
+    thread_local auto const buffer = register_line_buffer();
+    return *buffer;
 }
 
+DebugLines::DebugLines()
+: shader{load_shader("debug_lines_vertex.glsl", "debug_lines_fragment.glsl")}
+, mesh{Primitive::Lines} {}
+
 auto DebugLines::render(
     this DebugLines& self, Camera const& cam, glm::uvec2 viewport_size
 ) -> void {
+    // Lines submitted before the overlay was switched off are not shown
+    // once it is switched on again
     if (!DEBUG_IS_ENABLED) {
+        debug::discard_lines();
         return;
     }
 
+    debug::take_lines(&self.mesh.get_buffer());
+
     auto const aspect_ratio = Window::aspect_ratio_of(viewport_size);
 
     glLineWidth(LINE_WIDTH);
@@ -100,4 +100,64 @@ auto DebugLines::render(
     self.mesh.get_buffer().clear();
 }
 
+namespace debug {
+
+    auto line(glm::vec3 from, glm::vec3 to, glm::vec4 color) -> void {
+        if (!DEBUG_IS_ENABLED.load(std::memory_order_relaxed)) {
+            return;
+        }
+
+        auto const compact_color = compactify_color(color);
+        auto& vertices = this_thread_line_buffer().vertices;
+
+        vertices.emplace_back(from, compact_color);
+        vertices.emplace_back(to, compact_color);
+    }
+
+    auto box(glm::vec3 position, glm::vec3 size, glm::vec4 color) -> void {
+        if (!DEBUG_IS_ENABLED.load(std::memory_order_relaxed)) {
+            return;
+        }
+
+        // Corner `i` is offset along axis `k` to the positive side if bit `k`
+        // of `i` is set
+        auto const lo = position - 0.5f * size;
+        auto corners = std::array<glm::vec3, 8>{};
+
+        for (u32 i = 0; i < corners.size(); ++i) {
+            auto const offset = glm::uvec3{i & 1, (i >> 1) & 1, (i >> 2) & 1};
+            corners[i] = lo + size * glm::vec3{offset};
+        }
+
+        auto constexpr EDGES = std::array<std::array<u32, 2>, 12>{{
+            {0, 1}, {2, 3}, {4, 5}, {6, 7},
+            {0, 2}, {1, 3}, {4, 6}, {5, 7},
+            {0, 4}, {1, 5}, {2, 6}, {3, 7},
+        }};
+
+        auto const compact_color = compactify_color(color);
+        auto& vertices = this_thread_line_buffer().vertices;
+
+        for (auto const [from, to] : EDGES) {
+            vertices.emplace_back(corners[from], compact_color);
+            vertices.emplace_back(corners[to], compact_color);
+        }
+    }
+
+    auto box(Aabb box, glm::vec4 color) -> void {
+        debug::box(box.center(), box.size(), color);
+    }
+
+    auto take_lines(RefMut<MeshVec<DebugLineVertex>> vertices) -> void {
+        drain_line_buffers([vertices](auto const& buffer) {
+            vertices->insert(vertices->end(), buffer.begin(), buffer.end());
+        });
+    }
+
+    auto discard_lines() -> void {
+        drain_line_buffers([](auto const&) {});
+    }
+
+}  // namespace debug
+
 }  // namespace tmine
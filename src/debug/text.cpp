@@ -1,10 +1,14 @@
+#include <algorithm>
+#include <bit>
+
+#include <glm/ext.hpp>
+
 #include "../debug.hpp"
 #include "../loaders.hpp"
+#include "../panic.hpp"
 
 namespace tmine {
 
-namespace vs = std::ranges::views;
-
 auto constexpr DEBUG_TEXT_SIZE = 0.3f;
 auto constexpr MONITOR_FONT_SCALE = 1623.0f;
 auto constexpr EDGE_OFFSET = 0.025f;
@@ -19,53 +23,179 @@ static auto line_height_of(Font const& font, glm::uvec2 viewport_size) -> f32 {
            (f32) font.common.scale.y;
 }
 
-DebugText::DebugText(glm::uvec2 viewport_size)
-: shader{load_shader("gui_vertex.glsl", "gui_fragment.glsl")}
-, glyph_texture{Texture::from_image(
-      load_png("assets/images/debug_font.png"), TextureLoad::NO_MIPMAP_LINEAR
-  )}
-, font{std::make_shared<Font>(load_font("assets/fonts/debug_font.fnt"))}
-, viewport_size{viewport_size} {}
+DebugTextLayout::DebugTextLayout(std::shared_ptr<Font> font)
+: font{std::move(font)} {
+    if (this->font->pages.empty()) {
+        throw Panic("font {} contains no pages", this->font->info.face);
+    }
+}
 
-auto DebugText::render(this DebugText& self, glm::uvec2 viewport_size) -> void {
-    self.viewport_size = viewport_size;
+auto DebugTextLayout::set(
+    this DebugTextLayout& self, StaticString element, std::string_view value
+) -> void {
+    auto const [iter, is_new] = self.text_lines.try_emplace(std::move(element));
+    auto& line = iter->second;
 
-    if (!DEBUG_IS_ENABLED) {
-        return;
+    if (!is_new && !self.is_layout_stale && value.size() <= line.capacity) {
+        self.write_glyphs(line, value, false);
+    } else {
+        self.is_layout_stale = true;
     }
 
+    // Keeps the capacity, so that the same values do not allocate
+    line.text.assign(value);
+}
+
+auto DebugTextLayout::layout(
+    this DebugTextLayout& self, glm::uvec2 viewport_size
+) -> void {
+    self.font_size = font_size_of(viewport_size);
+
+    auto const aspect_ratio = Window::aspect_ratio_of(viewport_size);
     auto const line_height = line_height_of(*self.font, viewport_size);
+
     auto vertical_offset = 1.0f - EDGE_OFFSET - 0.5f * line_height;
+    auto n_glyphs = usize{0};
 
-    for (auto [i, entry] : self.text_lines | vs::enumerate) {
-        auto& text = entry.second;
+    for (auto& [name, line] : self.text_lines) {
+        line.capacity = std::max({
+            line.capacity, DebugTextLayout::MIN_LINE_CAPACITY,
+            std::bit_ceil(line.text.size()),
+        });
+        line.first_glyph = n_glyphs;
+        line.origin = glm::vec2{-aspect_ratio + EDGE_OFFSET, vertical_offset};
 
-        auto position = text.get_position();
-        position.y = vertical_offset;
         vertical_offset -= line_height + LINE_MARGIN;
-        text.set_position(position);
+        n_glyphs += line.capacity;
+    }
 
-        text.render(self.shader, viewport_size);
+    // Zeroed vertices make degenerate quads
+    self.vertices.clear();
+    self.vertices.resize(DebugTextLayout::N_GLYPH_VERTICES * n_glyphs);
+
+    for (auto const& [name, line] : self.text_lines) {
+        self.write_glyphs(line, line.text, true);
     }
+
+    self.dirty_begin = self.dirty_end = 0;
+    self.is_layout_stale = false;
 }
 
-auto DebugText::set(
-    this DebugText& self, StaticString element, std::string_view value
+auto DebugTextLayout::take_dirty_range(this DebugTextLayout& self) noexcept
+    -> std::pair<usize, usize> {
+    auto const range = std::pair{self.dirty_begin, self.dirty_end};
+    self.dirty_begin = self.dirty_end = 0;
+    return range;
+}
+
+auto DebugTextLayout::write_glyphs(
+    this DebugTextLayout& self, Line const& line, std::string_view value,
+    bool rewrite_all
 ) -> void {
-    auto const font_size = font_size_of(self.viewport_size);
-    auto const aspect_ratio = Window::aspect_ratio_of(self.viewport_size);
+    auto constexpr N_GLYPH_VERTICES = DebugTextLayout::N_GLYPH_VERTICES;
+
+    auto const& font = *self.font;
+    auto const& prev_value = line.text;
+
+    auto const scale = self.font_size / (f32) font.common.scale.x;
+    auto offset = 0.0f;
+
+    // Set once a glyph of different width or kerning moves all glyphs after
+    // it
+    auto is_shifted = rewrite_all;
+
+    auto const n_glyphs =
+        std::min(std::max(value.size(), prev_value.size()), line.capacity);
+
+    for (usize i = 0; i < n_glyphs; ++i) {
+        auto const first_vertex = N_GLYPH_VERTICES * (line.first_glyph + i);
+        auto const is_changed = i >= value.size() || i >= prev_value.size() ||
+                                value[i] != prev_value[i];
+
+        auto const advance =
+            i < value.size() ? font.advance_of(value, i) : i32{0};
+        auto const prev_advance =
+            i < prev_value.size() ? font.advance_of(prev_value, i) : i32{0};
+
+        if (!is_shifted && !is_changed) {
+            // Kerning with a changed next glyph moves the rest
+            is_shifted = advance != prev_advance;
+            offset += scale * (f32) advance;
+            continue;
+        }
+
+        self.dirty_begin = self.dirty_begin < self.dirty_end
+                               ? std::min(self.dirty_begin, first_vertex)
+                               : first_vertex;
+        self.dirty_end =
+            std::max(self.dirty_end, first_vertex + N_GLYPH_VERTICES);
+
+        if (i >= value.size()) {
+            std::fill_n(
+                self.vertices.begin() + first_vertex, N_GLYPH_VERTICES,
+                GuiObject::Vertex{}
+            );
+            continue;
+        }
+
+        is_shifted = is_shifted || advance != prev_advance;
+
+        auto const glyph = Text::make_glyph(
+            font, line.origin + glm::vec2{offset, 0.0f}, self.font_size,
+            value[i]
+        );
+
+        std::ranges::copy(glyph, self.vertices.begin() + first_vertex);
+        offset += scale * (f32) advance;
+    }
+}
 
-    auto pos = glm::vec2{-1.0f * aspect_ratio, 1.0f};
-    auto text = Text{self.font, self.glyph_texture, value, pos, font_size};
+DebugText::DebugText(glm::uvec2 viewport_size)
+: shader{load_shader("gui_vertex.glsl", "gui_fragment.glsl")}
+, glyph_texture{Texture::from_image(
+      load_png("assets/images/debug_font.png"), TextureLoad::NO_MIPMAP_LINEAR
+  )}
+, glyphs{std::make_shared<Font>(load_font("assets/fonts/debug_font.fnt"))}
+, viewport_size{viewport_size} {}
 
-    pos.x += 0.5f * text.get_width() + EDGE_OFFSET;
-    text.set_position(pos);
+auto DebugText::render(this DebugText& self, glm::uvec2 viewport_size) -> void {
+    if (!DEBUG_IS_ENABLED) {
+        return;
+    }
 
-    if (self.text_lines.contains(element)) {
-        self.text_lines.erase(element);
+    auto& vertices = self.mesh.get_buffer();
+
+    if (viewport_size != self.viewport_size || self.glyphs.needs_layout()) {
+        self.viewport_size = viewport_size;
+        self.glyphs.layout(viewport_size);
+        vertices = self.glyphs.get_vertices();
+        self.mesh.reload_buffer();
+    } else if (auto const [first, last] = self.glyphs.take_dirty_range();
+               first < last)
+    {
+        std::copy(
+            self.glyphs.get_vertices().begin() + first,
+            self.glyphs.get_vertices().begin() + last,
+            vertices.begin() + first
+        );
+
+        self.mesh.reload_buffer_range(first, last - first);
     }
 
-    self.text_lines.insert({std::move(element), std::move(text)});
+    self.shader.bind();
+    self.glyph_texture.bind(0);
+
+    glDisable(GL_DEPTH_TEST);
+
+    auto const aspect_ratio = Window::aspect_ratio_of(viewport_size);
+
+    // Glyphs are placed in screen space already
+    self.shader.uniform_mat4(
+        "model_projection",
+        glm::ortho(-aspect_ratio, aspect_ratio, -1.0f, 1.0f, 0.0f, 100.0f)
+    );
+
+    self.mesh.draw();
 }
 
 }  // namespace tmine
@@ -0,0 +1,212 @@
+#pragma once
+
+#include <span>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "types.hpp"
+#include "panic.hpp"
+#include "geometry.hpp"
+#include "physics.hpp"
+#include "instancing.hpp"
+
+namespace tmine {
+
+/// Handle to an entity. Indices of despawned entities are reused with the
+/// next generation, so stale handles never refer to new entities.
+struct Entity {
+    u32 index{~u32{0}};
+    u32 generation{0};
+
+    inline auto operator==(this Entity self, Entity other) noexcept -> bool {
+        return self.index == other.index &&
+               self.generation == other.generation;
+    }
+};
+
+/// Components of type `T` stored contiguously in insertion order, with a
+/// sparse array mapping entity indices into it.
+template <class T>
+class SparseSet {
+public:
+    inline auto contains(this SparseSet const& self, Entity entity) noexcept
+        -> bool {
+        return SparseSet::NONE != self.index_of(entity);
+    }
+
+    /// Position of the component of `entity` in `components()` or
+    /// `SparseSet::NONE` if it has none.
+    inline auto index_of(this SparseSet const& self, Entity entity) noexcept
+        -> u32 {
+        if (entity.index >= self.sparse.size()) {
+            return SparseSet::NONE;
+        }
+
+        auto const index = self.sparse[entity.index];
+
+        if (SparseSet::NONE == index || self.dense[index] != entity) {
+            return SparseSet::NONE;
+        }
+
+        return index;
+    }
+
+    template <class Self>
+    inline auto get(this Self&& self, Entity entity)
+        -> decltype(std::forward<Self>(self).values[0]) {
+        auto const index = self.index_of(entity);
+
+        if (SparseSet::NONE == index) {
+            throw Panic(
+                "entity #{} of generation {} has no such component",
+                entity.index, entity.generation
+            );
+        }
+
+        return std::forward<Self>(self).values[index];
+    }
+
+    /// Adds the component to `entity` or replaces the one it has.
+    inline auto insert(this SparseSet& self, Entity entity, T value) -> T& {
+        if (auto const index = self.index_of(entity); SparseSet::NONE != index)
+        {
+            return self.values[index] = std::move(value);
+        }
+
+        if (entity.index >= self.sparse.size()) {
+            self.sparse.resize(entity.index + 1, SparseSet::NONE);
+        }
+
+        self.sparse[entity.index] = (u32) self.dense.size();
+        self.dense.push_back(entity);
+
+        return self.values.emplace_back(std::move(value));
+    }
+
+    /// Removes the component of `entity` moving the last one into its place.
+    inline auto erase(this SparseSet& self, Entity entity) -> void {
+        auto const index = self.index_of(entity);
+
+        if (SparseSet::NONE == index) {
+            return;
+        }
+
+        auto const last = self.dense.back();
+
+        if (last != entity) {
+            self.dense[index] = last;
+            self.values[index] = std::move(self.values.back());
+            self.sparse[last.index] = index;
+        }
+
+        self.sparse[entity.index] = SparseSet::NONE;
+
+        self.dense.pop_back();
+        self.values.pop_back();
+    }
+
+    inline auto size(this SparseSet const& self) noexcept -> usize {
+        return self.dense.size();
+    }
+
+    inline auto entities(this SparseSet const& self) noexcept
+        -> std::span<Entity const> {
+        return self.dense;
+    }
+
+    template <class Self>
+    inline auto components(this Self&& self) noexcept {
+        return std::span{std::forward<Self>(self).values};
+    }
+
+public:
+    static auto constexpr NONE = ~u32{0};
+
+private:
+    std::vector<u32> sparse;
+    std::vector<Entity> dense;
+    std::vector<T> values;
+};
+
+struct Transform {
+    glm::vec3 pos{0.0f};
+};
+
+struct Velocity {
+    glm::vec3 value{0.0f};
+    glm::vec3 acceleration{0.0f};
+};
+
+/// Box of `size` with its lower corner at the entity position, moved
+/// against the terrain by `move_entities`.
+struct EntityCollider {
+    glm::vec3 size{1.0f};
+    f32 elasticity{ABSOLUTELY_INELASTIC_ELASTICITY};
+
+    inline auto box_at(this EntityCollider self, glm::vec3 pos) noexcept
+        -> Aabb {
+        return Aabb{pos, pos + self.size};
+    }
+};
+
+/// Mesh and material an entity is drawn with.
+struct EntityModel {
+    MeshId mesh{0};
+    MaterialId material{0};
+};
+
+/// Mobs, dropped items and projectiles, stored as sparse sets of
+/// components.
+class EntityRegistry {
+public:
+    auto spawn(this EntityRegistry& self) -> Entity;
+
+    /// Removes `entity` with all its components, does nothing if it is
+    /// already despawned.
+    auto despawn(this EntityRegistry& self, Entity entity) -> void;
+
+    auto is_alive(this EntityRegistry const& self, Entity entity) noexcept
+        -> bool;
+
+    inline auto size(this EntityRegistry const& self) noexcept -> usize {
+        return self.generations.size() - self.free_indices.size();
+    }
+
+    template <class T, class Self>
+    inline auto storage(this Self&& self) -> decltype(auto) {
+        return std::get<SparseSet<T>>(std::forward<Self>(self).storages);
+    }
+
+    template <class T>
+    inline auto add(this EntityRegistry& self, Entity entity, T value) -> T& {
+        if (!self.is_alive(entity)) {
+            throw Panic("entity #{} is not alive", entity.index);
+        }
+
+        return self.storage<T>().insert(entity, std::move(value));
+    }
+
+    template <class T, class Self>
+    inline auto get(this Self&& self, Entity entity) -> decltype(auto) {
+        return std::forward<Self>(self).template storage<T>().get(entity);
+    }
+
+private:
+    std::vector<u32> generations;
+    std::vector<u32> free_indices;
+    std::tuple<
+        SparseSet<Transform>, SparseSet<Velocity>, SparseSet<EntityCollider>,
+        SparseSet<EntityModel>>
+        storages;
+};
+
+/// Integrates velocities of all entities with colliders and sweeps their
+/// boxes through `terrain`, in parallel.
+auto move_entities(
+    RefMut<EntityRegistry> registry, TerrainCollider const& terrain,
+    f32 time_step
+) -> void;
+
+}  // namespace tmine
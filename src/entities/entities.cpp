@@ -0,0 +1,89 @@
+#include "../entities.hpp"
+
+namespace tmine {
+
+auto EntityRegistry::spawn(this EntityRegistry& self) -> Entity {
+    if (self.free_indices.empty()) {
+        self.generations.push_back(0);
+
+        return Entity{
+            .index = (u32) self.generations.size() - 1,
+            .generation = 0,
+        };
+    }
+
+    auto const index = self.free_indices.back();
+    self.free_indices.pop_back();
+
+    return Entity{
+        .index = index,
+        .generation = self.generations[index],
+    };
+}
+
+auto EntityRegistry::despawn(this EntityRegistry& self, Entity entity)
+    -> void {
+    if (!self.is_alive(entity)) {
+        return;
+    }
+
+    std::apply(
+        [&](auto&... storages) { (storages.erase(entity), ...); },
+        self.storages
+    );
+
+    ++self.generations[entity.index];
+    self.free_indices.push_back(entity.index);
+}
+
+auto EntityRegistry::is_alive(this EntityRegistry const& self, Entity entity)
+    noexcept -> bool {
+    return entity.index < self.generations.size() &&
+           self.generations[entity.index] == entity.generation;
+}
+
+auto move_entities(
+    RefMut<EntityRegistry> registry, TerrainCollider const& terrain,
+    f32 time_step
+) -> void {
+    auto& colliders = registry->storage<EntityCollider>();
+    auto& transforms = registry->storage<Transform>();
+    auto& velocities = registry->storage<Velocity>();
+
+    auto const entities = colliders.entities();
+    auto const collider_components = colliders.components();
+    auto const transform_components = transforms.components();
+    auto const velocity_components = velocities.components();
+
+#pragma omp parallel for schedule(static)
+    for (usize i = 0; i < entities.size(); ++i) {
+        auto const transform_index = transforms.index_of(entities[i]);
+        auto const velocity_index = velocities.index_of(entities[i]);
+
+        if (SparseSet<Transform>::NONE == transform_index ||
+            SparseSet<Velocity>::NONE == velocity_index)
+        {
+            continue;
+        }
+
+        auto const collider = collider_components[i];
+        auto& pos = transform_components[transform_index].pos;
+        auto& velocity = velocity_components[velocity_index];
+
+        velocity.value += time_step * velocity.acceleration;
+
+        auto const motion = terrain.sweep_box(
+            collider.box_at(pos), time_step * velocity.value
+        );
+
+        pos += motion.displacement;
+
+        for (i32 axis = 0; axis < 3; ++axis) {
+            if (motion.is_blocked[axis]) {
+                velocity.value[axis] *= -collider.elasticity;
+            }
+        }
+    }
+}
+
+}  // namespace tmine
@@ -1,28 +1,105 @@
 #pragma once
 
+#include <functional>
+#include <memory>
+#include <optional>
+#include <vector>
+
 #include "gui.hpp"
 #include "window.hpp"
 #include "objects.hpp"
 #include "physics.hpp"
 #include "debug.hpp"
 #include "update.hpp"
+#include "replay.hpp"
+#include "entities.hpp"
 
 namespace tmine {
 
+/// Game without window, GL objects and `io`, for CI and profiling.
+struct HeadlessConfig {
+    glm::uvec3 world_size{16, 4, 16};
+    f32 tick_rate{FixedUpdater::DEFAULT_TICK_RATE};
+};
+
+struct HeadlessStats {
+    u32 n_ticks{0};
+    f64 ticks_per_second{0.0};
+};
+
 class Game {
 public:
+    /// Input of the headless tick number `tick`. May edit the world of
+    /// `game`, edits apply before the tick runs.
+    using TickScript = std::function<PlayerTickInput(u32 tick, Game& game)>;
+
     explicit Game(glm::uvec2 viewport_size);
+    explicit Game(HeadlessConfig const& config);
+
+    // Fixed update systems keep pointers to the game
+    Game(Game const&) = delete;
+    auto operator=(Game const&) -> Game& = delete;
 
+    /// Draws a frame, only for games with a window.
     auto render(this Game& self, glm::uvec2 viewport_size) -> void;
+
+    /// Handles `io` and runs fixed updates for the time passed, only for
+    /// games with a window.
     auto update(this Game& self, RefMut<Window> window) -> void;
 
+    /// Runs `n_ticks` fixed updates back to back with inputs from `script`
+    /// instead of `io`.
+    auto run_headless(this Game& self, u32 n_ticks, TickScript const& script)
+        -> HeadlessStats;
+
+    /// Sets all voxels in the box from `lo` to `hi` inclusive to `value`.
+    auto fill_box(this Game& self, glm::uvec3 lo, glm::uvec3 hi, Voxel value)
+        -> void;
+
+    auto get_player_state(this Game& self) -> PlayerState;
+
+    inline auto get_chunks(this Game const& self) noexcept
+        -> ChunkArray const& {
+        return *self.chunks;
+    }
+
+    inline auto get_entities(this Game& self) noexcept -> EntityRegistry& {
+        return self.entities;
+    }
+
+    inline auto is_headless(this Game const& self) noexcept -> bool {
+        return !self.scene.has_value();
+    }
+
+private:
+    /// Wakes colliders near voxels edited since the last call and records
+    /// the edits into the replay log.
+    auto apply_edits(this Game& self) -> void;
+
+    /// Starts recording a replay log or saves the one being recorded.
+    auto toggle_recording(this Game& self) -> void;
+
+    /// Throws a small box from the camera into the world.
+    auto throw_item(this Game& self) -> void;
+
+public:
+    static char constexpr REPLAY_PATH[] = "physics.tmrp";
+
 private:
     FixedUpdater updater;
     PhysicsSolver physics_solver;
-    Scene scene;
-    Gui gui;
+    std::shared_ptr<ChunkArray> chunks;
+    std::optional<Scene> scene;
+    std::optional<Gui> gui;
     Player player;
-    DebugOwner debug;
+    EntityRegistry entities;
+    std::optional<DebugOwner> debug;
+    std::optional<ReplayLog> replay_log;
+    /// Input of the next tick set by `run_headless`, `io` is polled if
+    /// there is none.
+    std::optional<PlayerTickInput> scripted_input;
+    /// Edits made without `Terrain`, which tracks its own.
+    std::vector<Aabb> edited_boxes;
 };
 
 }  // namespace tmine
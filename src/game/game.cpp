@@ -1,6 +1,13 @@
+#include <chrono>
+#include <utility>
+#include <fmt/format.h>
+
 #include "../game.hpp"
 #include "../events.hpp"
 #include "../debug.hpp"
+#include "../profiler.hpp"
+#include "../metrics.hpp"
+#include "../allocations.hpp"
 
 namespace tmine {
 
@@ -12,42 +19,79 @@ static auto setup_opengl() -> void {
 }
 
 Game::Game(glm::uvec2 viewport_size)
-: physics_solver{}
-, scene{viewport_size}
-, gui{GuiState::InGame}
-, player{this->scene.get<Terrain>(), &this->physics_solver}
-, debug{viewport_size} {
+: Game{HeadlessConfig{}} {
+    this->scene.emplace(viewport_size, this->chunks);
+    this->gui.emplace(GuiState::InGame);
+    this->debug.emplace(viewport_size);
+
     setup_opengl();
+}
+
+Game::Game(HeadlessConfig const& config)
+: updater{config.tick_rate}
+, physics_solver{}
+, chunks{std::make_shared<ChunkArray>(config.world_size)}
+, player{*this->chunks, &this->physics_solver} {
+    this->physics_solver.register_collidable<TerrainCollider>(this->chunks);
+
+    // Physics runs first, so that the player sees where it ended up
+    this->updater.add_system([this](f32 time_step) {
+        this->physics_solver.update(time_step);
+    });
+
+    this->updater.add_system([this](f32 time_step) {
+        auto const input = this->scripted_input.has_value()
+                               ? this->scripted_input.value()
+                               : this->player.poll_tick_input();
+
+        if (this->replay_log.has_value()) {
+            this->replay_log->record_tick(input);
+        }
+
+        this->player.fixed_update(
+            time_step, *this->chunks, &this->physics_solver, input
+        );
+    });
 
-    auto& terrain = this->scene.get<Terrain>();
-    auto chunk_array = terrain.borrow_array();
-    this->physics_solver.register_collidable<TerrainCollider>(chunk_array);
+    this->updater.add_system(
+        [this, terrain = TerrainCollider{this->chunks}](f32 time_step) {
+            move_entities(&this->entities, terrain, time_step);
+        }
+    );
+
+    // Runs last, so that the replay ends right after a recorded tick and
+    // not with the camera turned or the movement switched between ticks
+    this->updater.add_system([this](f32) {
+        if (this->replay_log.has_value()) {
+            this->replay_log->finish(
+                this->player.get_state(&this->physics_solver)
+            );
+        }
+    });
 }
 
 static auto draw_debug_text(glm::uvec2 viewport_size) -> void {
-    debug::text()->set(
-        "viewport",
-        fmt::format("Viewport Size: {}x{}", viewport_size.x, viewport_size.y)
+    debug::text()->set_formatted(
+        "viewport", "Viewport Size: {}x{}", viewport_size.x, viewport_size.y
     );
 
-    debug::text()->set(
-        "gl",
-        fmt::format(
-            "Vendor: {}, Renderer: {}", (char const*) glGetString(GL_VENDOR),
-            (char const*) glGetString(GL_RENDERER)
-        )
+    debug::text()->set_formatted(
+        "gl", "Vendor: {}, Renderer: {}",
+        (char const*) glGetString(GL_VENDOR),
+        (char const*) glGetString(GL_RENDERER)
     );
 
-    debug::text()->set(
-        "gl#version",
-        fmt::format("OpenGL v{}", (char const*) glGetString(GL_VERSION))
+    debug::text()->set_formatted(
+        "gl#version", "OpenGL v{}", (char const*) glGetString(GL_VERSION)
     );
 }
 
 auto Game::render(this Game& self, glm::uvec2 viewport_size) -> void {
+    tmine_profile_zone("Game::render");
+
     if (!Window::is_visible(viewport_size)) {
-        if (self.gui.current() == GuiState::InGame) {
-            self.gui.set_state(GuiState::PauseMenu);
+        if (self.gui->current() == GuiState::InGame) {
+            self.gui->set_state(GuiState::PauseMenu);
         }
 
         return;
@@ -57,25 +101,96 @@ auto Game::render(this Game& self, glm::uvec2 viewport_size) -> void {
 
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    if (self.gui.current() == GuiState::PauseMenu ||
-        self.gui.current() == GuiState::InGame)
+    if (self.gui->current() == GuiState::PauseMenu ||
+        self.gui->current() == GuiState::InGame)
     {
-        self.scene.render(self.player.get_camera(), viewport_size);
+        self.scene->get<EntityRenderer>().submit(self.entities);
+        self.scene->render(self.player.get_camera(), viewport_size);
 
-        debug::lines()->render(self.player.get_camera(), viewport_size);
+        debug::lines().render(self.player.get_camera(), viewport_size);
         debug::text()->render(viewport_size);
     }
 
-    if (self.gui.current() == GuiState::StartMenu ||
-        self.gui.current() == GuiState::PauseMenu)
+    if (self.gui->current() == GuiState::StartMenu ||
+        self.gui->current() == GuiState::PauseMenu)
     {
-        debug::lines()->render(self.player.get_camera(), viewport_size);
-        self.gui.render(viewport_size);
+        debug::lines().render(self.player.get_camera(), viewport_size);
+        self.gui->render(viewport_size);
     }
 }
 
+auto Game::toggle_recording(this Game& self) -> void {
+    if (self.replay_log.has_value()) {
+        self.replay_log->record_entity_positions(self.entities);
+        self.replay_log->save(Game::REPLAY_PATH);
+
+        debug::text()->set_formatted(
+            "replay", "Replay of {} ticks saved to '{}'",
+            self.replay_log->tick_count(), Game::REPLAY_PATH
+        );
+
+        self.replay_log.reset();
+        return;
+    }
+
+    // Setting the state wakes the player collider, so that the replay
+    // starts with the same sleeping state
+    auto const state = self.player.get_state(&self.physics_solver);
+    self.player.set_state(&self.physics_solver, state);
+
+    self.replay_log = ReplayLog::capture(
+        self.updater.get_time_step(), *self.chunks, self.entities, state
+    );
+
+    debug::text()->set("replay", "Recording replay");
+}
+
+auto Game::throw_item(this Game& self) -> void {
+    auto constexpr ITEM_SIZE = glm::vec3{0.25f};
+    auto constexpr THROW_SPEED = 15.0f;
+    auto constexpr GRAVITY = glm::vec3{0.0f, -20.0f, 0.0f};
+
+    auto const& camera = self.player.get_camera();
+    auto const item = self.entities.spawn();
+
+    self.entities.add(
+        item, Transform{
+                  .pos = camera.get_pos() + camera.get_front_direction() -
+                         0.5f * ITEM_SIZE,
+              }
+    );
+
+    self.entities.add(
+        item, Velocity{
+                  .value = THROW_SPEED * camera.get_front_direction(),
+                  .acceleration = GRAVITY,
+              }
+    );
+
+    self.entities.add(
+        item, EntityCollider{.size = ITEM_SIZE, .elasticity = 0.3f}
+    );
+
+    if (self.replay_log.has_value()) {
+        self.replay_log->record_spawn(self.entities, item);
+    }
+
+    self.entities.add(
+        item, EntityModel{
+                  .mesh = EntityRenderer::CUBE_MESH,
+                  .material = EntityRenderer::ITEM_MATERIAL,
+              }
+    );
+}
+
 auto Game::update(this Game& self, RefMut<Window> window) -> void {
+    profiler::mark_frame();
+    tmine_profile_zone("Game::update");
+
     debug::update();
+    profiler::update();
+    metrics::update();
+    allocations::update();
 
     self.updater.start_new_frame();
 
@@ -84,28 +199,110 @@ auto Game::update(this Game& self, RefMut<Window> window) -> void {
     }
 
     if (io.just_pressed(Key::Escape)) {
-        self.gui.set_state(GuiState::PauseMenu);
+        self.gui->set_state(GuiState::PauseMenu);
         window->release_cursor();
     }
 
-    if (GuiState::InGame == self.gui.current()) {
-        auto& terrain = self.scene.get<Terrain>();
-        auto& selection = self.scene.get<SelectionBox>();
+    if (GuiState::InGame == self.gui->current()) {
+        auto& terrain = self.scene->get<Terrain>();
+        auto& selection = self.scene->get<SelectionBox>();
 
-        self.updater.fixed_update([&](f32 time_step) {
-            self.physics_solver.update(time_step);
-        });
+        if (io.just_pressed(Key::F9)) {
+            self.toggle_recording();
+        }
 
-        self.updater.fixed_update([&](f32 time_step) {
-            self.player.fixed_update(time_step, terrain, &self.physics_solver);
-        });
-        
-        self.player.update(
-            &self.physics_solver, &terrain, &selection, window->size()
-        );
+        if (io.just_pressed(Key::G)) {
+            self.throw_item();
+        }
+
+        {
+            auto const timing = ScopedTiming{Timing::PhysicsTicks};
+            self.updater.run_ticks();
+        }
+
+        self.player.interpolate(self.updater.get_interpolation_alpha());
+
+        {
+            auto const timing = ScopedTiming{Timing::Input};
+
+            self.player.update(
+                &self.physics_solver, &terrain, &selection, window->size()
+            );
+        }
+
+        self.apply_edits();
+    }
+
+    self.gui->update(window);
+}
+
+auto Game::apply_edits(this Game& self) -> void {
+    auto boxes = std::exchange(self.edited_boxes, {});
+
+    if (self.scene.has_value()) {
+        auto const terrain_boxes =
+            self.scene->get<Terrain>().take_edited_boxes();
+        boxes.insert(boxes.end(), terrain_boxes.begin(), terrain_boxes.end());
+    }
+
+    for (auto const box : boxes) {
+        self.physics_solver.wake_in(box);
+
+        if (self.replay_log.has_value()) {
+            self.replay_log->record_edit(*self.chunks, box);
+        }
+    }
+}
+
+auto Game::fill_box(
+    this Game& self, glm::uvec3 lo, glm::uvec3 hi, Voxel value
+) -> void {
+    if (self.scene.has_value()) {
+        self.scene->get<Terrain>().fill_box(lo, hi, value);
+        return;
     }
 
-    self.gui.update(window);
+    self.chunks->fill_box(
+        lo, hi, value,
+        [&self](
+            glm::uvec3 chunk_pos, glm::uvec3 local_lo, glm::uvec3 local_hi
+        ) {
+            auto const chunk_offset = chunk_pos * Chunk::SIZE;
+
+            self.edited_boxes.push_back(Aabb{
+                glm::vec3{chunk_offset + local_lo},
+                glm::vec3{chunk_offset + local_hi + 1u},
+            });
+        }
+    );
+}
+
+auto Game::run_headless(this Game& self, u32 n_ticks, TickScript const& script)
+    -> HeadlessStats {
+    auto const start = std::chrono::steady_clock::now();
+
+    for (u32 tick = 0; tick < n_ticks; ++tick) {
+        self.scripted_input = script(tick, self);
+        self.apply_edits();
+
+        auto const timing = ScopedTiming{Timing::PhysicsTicks};
+        self.updater.tick();
+    }
+
+    self.scripted_input.reset();
+
+    auto const duration = std::chrono::duration<f64>(
+        std::chrono::steady_clock::now() - start
+    );
+
+    return HeadlessStats{
+        .n_ticks = n_ticks,
+        .ticks_per_second = (f64) n_ticks / duration.count(),
+    };
+}
+
+auto Game::get_player_state(this Game& self) -> PlayerState {
+    return self.player.get_state(&self.physics_solver);
 }
 
 }  // namespace tmine
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <cmath>
 #include <glm/glm.hpp>
 #include "types.hpp"
@@ -26,6 +27,19 @@ struct Aabb {
     }
 };
 
+/// Six planes bounding the visible volume, `dot(plane, vec4{pos, 1})` is
+/// non-negative for points inside.
+struct Frustum {
+    std::array<glm::vec4, 6> planes{};
+
+    static auto from_projection_view(glm::mat4 const& projection_view)
+        -> Frustum;
+
+    /// Whether `box` may be visible. Conservative: boxes outside but near
+    /// the frustum corners pass.
+    auto intersects(this Frustum const& self, Aabb box) -> bool;
+};
+
 auto constexpr INFINITELY_LARGE_AABB = Aabb{glm::vec3{-INFINITY}, glm::vec3{INFINITY}};
 
 }
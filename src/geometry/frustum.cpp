@@ -0,0 +1,44 @@
+#include "../geometry.hpp"
+
+namespace tmine {
+
+auto Frustum::from_projection_view(glm::mat4 const& projection_view)
+    -> Frustum {
+    auto const m = glm::transpose(projection_view);
+
+    auto frustum = Frustum{
+        .planes = {
+            m[3] + m[0],
+            m[3] - m[0],
+            m[3] + m[1],
+            m[3] - m[1],
+            m[3] + m[2],
+            m[3] - m[2],
+        },
+    };
+
+    for (auto& plane : frustum.planes) {
+        plane /= glm::length(glm::vec3{plane});
+    }
+
+    return frustum;
+}
+
+auto Frustum::intersects(this Frustum const& self, Aabb box) -> bool {
+    for (auto const& plane : self.planes) {
+        auto const normal = glm::vec3{plane};
+
+        // Corner of the box farthest along the plane normal
+        auto const corner = glm::mix(
+            box.lo, box.hi, glm::greaterThanEqual(normal, glm::vec3{0.0f})
+        );
+
+        if (glm::dot(normal, corner) + plane.w < 0.0f) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+}  // namespace tmine
@@ -9,6 +9,8 @@
 
 #include "types.hpp"
 #include "data.hpp"
+#include "metrics.hpp"
+#include "allocations.hpp"
 
 namespace tmine {
 
@@ -58,8 +60,14 @@ public:
     ) noexcept -> Texture;
 
     auto bind(this Texture const& self, u32 slot) -> void;
+    static auto bind_id(GLuint id, u32 slot) -> void;
     static auto unbind(u32 slot) -> void;
 
+    /// Name of the GL texture, zero for an empty texture.
+    auto get_id(this Texture const& self) -> GLuint {
+        return nullptr == self.data ? TextureData::DUMMY_ID : self.data->id;
+    }
+
     auto get_size(this Texture const& self) -> glm::uvec2 {
         return self.data->size;
     }
@@ -260,6 +268,8 @@ public:
     }
 
     auto reload_buffer(this BufferedMesh const& self) noexcept -> void {
+        metrics::add(Counter::VerticesUploaded, self.vertices.size());
+
         glBindVertexArray(self.vertex_array_object_id);
         glBindBuffer(GL_ARRAY_BUFFER, self.vertex_buffer_object_id);
         glBufferData(
@@ -268,15 +278,44 @@ public:
         );
     }
 
+    /// Uploads `count` vertices starting from `first`. The range should lie
+    /// within the buffer uploaded by the last `reload_buffer`.
+    auto reload_buffer_range(
+        this BufferedMesh const& self, usize first, usize count
+    ) noexcept -> void {
+        metrics::add(Counter::VerticesUploaded, count);
+
+        glBindVertexArray(self.vertex_array_object_id);
+        glBindBuffer(GL_ARRAY_BUFFER, self.vertex_buffer_object_id);
+        glBufferSubData(
+            GL_ARRAY_BUFFER, sizeof(self.vertices[0]) * first,
+            sizeof(self.vertices[0]) * count,
+            (void const*) (self.vertices.data() + first)
+        );
+    }
+
     auto draw(this BufferedMesh const& self) -> void {
         if (self.vertices.empty()) {
             return;
         }
 
+        metrics::add(Counter::DrawCalls);
+
         glBindVertexArray(self.vertex_array_object_id);
-        glDrawArrays(
-            (GLuint) self.primitive, 0, sizeof(V) * self.vertices.size()
-        );
+        glDrawArrays((GLuint) self.primitive, 0, self.vertices.size());
+    }
+
+    /// Draws `count` vertices starting from `first`.
+    auto draw_range(this BufferedMesh const& self, usize first, usize count)
+        -> void {
+        if (0 == count) {
+            return;
+        }
+
+        metrics::add(Counter::DrawCalls);
+
+        glBindVertexArray(self.vertex_array_object_id);
+        glDrawArrays((GLuint) self.primitive, (GLint) first, (GLsizei) count);
     }
 
 private:
@@ -287,8 +326,13 @@ private:
     static auto constexpr DUMMY_ID = ~GLuint{0};
 };
 
+/// CPU-side vertices of a mesh, accounted to `AllocationTag::MeshBuffers`.
+template <class V>
+using MeshVec =
+    std::vector<V, TrackingAllocator<V, AllocationTag::MeshBuffers>>;
+
 template <WithAttributes V>
-using Mesh = BufferedMesh<V, std::vector<V>>;
+using Mesh = BufferedMesh<V, MeshVec<V>>;
 
 struct GeometryBufferData {
     GLuint frame_buffer_object_id{DUMMY_ID};
@@ -16,8 +16,12 @@ void Texture::bind(this Texture const& self, u32 slot) {
         return;
     }
 
+    Texture::bind_id(self.data->id, slot);
+}
+
+auto Texture::bind_id(GLuint id, u32 slot) -> void {
     glActiveTexture(GL_TEXTURE0 + slot);
-    glBindTexture(GL_TEXTURE_2D, self.data->id);
+    glBindTexture(GL_TEXTURE_2D, id);
 }
 
 auto Texture::unbind(u32 slot) -> void { glBindTexture(GL_TEXTURE_2D, slot); }
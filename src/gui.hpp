@@ -1,5 +1,7 @@
 #pragma once
 
+#include <span>
+#include <vector>
 #include <glm/glm.hpp>
 
 #include "types.hpp"
@@ -14,12 +16,14 @@ struct GuiRect {
     glm::vec2 hi;
 };
 
+class GuiBatcher;
+
 class GuiObject {
 public:
     virtual ~GuiObject() = default;
 
-    virtual auto render(ShaderProgram const& shader, glm::uvec2 viewport_size)
-        -> void = 0;
+    /// Pushes quads of the object, tessellated beforehand, to `batcher`.
+    virtual auto submit(RefMut<GuiBatcher> batcher) const -> void = 0;
 
     struct Vertex {
         glm::vec2 pos;
@@ -29,19 +33,82 @@ public:
     };
 
     static auto add_gui_rect(
-        RefMut<std::vector<Vertex>> buffer, glm::vec2 pos, glm::vec2 size
+        RefMut<MeshVec<Vertex>> buffer, glm::vec2 pos, glm::vec2 size
+    ) -> void;
+};
+
+/// GUI objects overlap in this order, later layers are drawn on top.
+enum class GuiLayer : u8 {
+    Background = 0,
+    Widgets,
+    Labels,
+};
+
+/// What quads are drawn with, quads with equal keys are drawn by a single
+/// call.
+struct GuiBatchKey {
+    GuiLayer layer{GuiLayer::Background};
+    GLuint texture_id{0};
+
+    /// Key ordering quads by layer first, as layers should be drawn in order.
+    inline auto packed(this GuiBatchKey self) noexcept -> u64 {
+        return (u64) self.layer << 32 | (u64) self.texture_id;
+    }
+
+    inline auto operator==(this GuiBatchKey self, GuiBatchKey other) noexcept
+        -> bool {
+        return self.packed() == other.packed();
+    }
+};
+
+/// Contiguous range of vertices in `GuiBatcher::get_vertices()` sharing one
+/// key.
+struct GuiBatch {
+    GuiBatchKey key{};
+    u32 first{0};
+    u32 count{0};
+};
+
+/// Collects quads of GUI objects in any order into one vertex stream with a
+/// batch per key. Touches no GL state.
+class GuiBatcher {
+public:
+    auto clear(this GuiBatcher& self) -> void;
+
+    auto push(
+        this GuiBatcher& self, GuiBatchKey key,
+        std::span<GuiObject::Vertex const> vertices
     ) -> void;
+
+    /// Sorts vertices pushed since the last `clear` by layer, then by
+    /// texture, keeping the push order within a batch.
+    auto build(this GuiBatcher& self) -> void;
+
+    inline auto get_vertices(this GuiBatcher const& self) noexcept
+        -> std::span<GuiObject::Vertex const> {
+        return self.vertices;
+    }
+
+    inline auto get_batches(this GuiBatcher const& self) noexcept
+        -> std::span<GuiBatch const> {
+        return self.batches;
+    }
+
+private:
+    std::vector<GuiBatch> pushed;
+    MeshVec<GuiObject::Vertex> unsorted;
+    MeshVec<GuiObject::Vertex> vertices;
+    std::vector<GuiBatch> batches;
 };
 
 class Sprite : public GuiObject {
 public:
     Sprite(glm::vec2 pos, f32 size, Texture texture);
 
-    auto render(ShaderProgram const& shader, glm::uvec2 viewport_size)
-        -> void override;
+    auto submit(RefMut<GuiBatcher> batcher) const -> void override;
 
 private:
-    Mesh<GuiObject::Vertex> mesh;
+    MeshVec<GuiObject::Vertex> vertices;
     Texture texture;
     glm::vec2 pos;
     f32 size;
@@ -56,23 +123,31 @@ public:
 
     auto set_text(this Text& self, std::string_view text) -> void;
 
-    auto render(ShaderProgram const& shader, glm::uvec2 viewport_size)
-        -> void override;
+    auto submit(RefMut<GuiBatcher> batcher) const -> void override;
 
     inline auto get_position(this Text const& self) -> glm::vec2 {
         return self.pos;
     }
 
-    inline auto set_position(this Text& self, glm::vec2 pos) -> void {
-        self.pos = pos;
-    }
+    /// Moves the glyphs without laying them out again.
+    auto set_position(this Text& self, glm::vec2 pos) -> void;
 
     inline auto get_width(this Text const& self) -> f32 {
         return self.width;
     }
 
+    /// Quad of `symbol` starting at `offset` on a line centered at zero. The
+    /// next glyph starts `Font::advance_of` font units further.
+    ///
+    /// # Safety
+    ///
+    /// `font` should have at least one page
+    static auto make_glyph(
+        Font const& font, glm::vec2 offset, f32 size, char symbol
+    ) -> std::array<GuiObject::Vertex, 6>;
+
 private:
-    Mesh<GuiObject::Vertex> mesh;
+    MeshVec<GuiObject::Vertex> vertices;
     std::shared_ptr<Font> font;
     Texture glyph_texture;
     glm::vec2 pos;
@@ -99,8 +174,7 @@ public:
 
     virtual ~Button() = default;
 
-    auto render(ShaderProgram const& shader, glm::uvec2 viewport_size)
-        -> void override;
+    auto submit(RefMut<GuiBatcher> batcher) const -> void override;
 
     inline auto get_state(this Button const& self) -> ButtonState {
         return self.state;
@@ -116,10 +190,12 @@ public:
 
     auto get_size(this Button const& self) -> glm::vec2;
 
-    auto update_state(this Button& self, glm::uvec2 viewport_size) -> void;
+    /// Returns whether the state changed, so that the button should be
+    /// submitted again.
+    auto update_state(this Button& self, glm::uvec2 viewport_size) -> bool;
 
 private:
-    Mesh<GuiObject::Vertex> mesh{};
+    MeshVec<GuiObject::Vertex> vertices{};
     ButtonStyle style;
     Text text;
     ButtonState state{ButtonState::Default};
@@ -139,16 +215,23 @@ public:
     auto get_button(this GuiStage const& self, std::string_view name)
         -> Button const&;
 
+    /// Draws all objects with a call per batch.
     auto render(this GuiStage& self, glm::uvec2 viewport_size) -> void;
 
     auto update(this GuiStage& self, glm::uvec2 viewport_size) -> void;
 
 private:
+    /// Batches all objects again and uploads the vertices.
+    auto rebuild(this GuiStage& self) -> void;
+
     std::unordered_map<StaticString, Button> buttons{};
     std::vector<Sprite> sprites{};
     ButtonStyle button_style;
     std::shared_ptr<Font> font;
     ShaderProgram shader;
+    GuiBatcher batcher{};
+    Mesh<GuiObject::Vertex> mesh{Primitive::Triangles};
+    bool needs_rebuild{true};
 };
 
 enum class GuiState {
@@ -0,0 +1,58 @@
+#include <algorithm>
+
+#include "../gui.hpp"
+
+namespace tmine {
+
+auto GuiBatcher::clear(this GuiBatcher& self) -> void {
+    self.pushed.clear();
+    self.unsorted.clear();
+    self.vertices.clear();
+    self.batches.clear();
+}
+
+auto GuiBatcher::push(
+    this GuiBatcher& self, GuiBatchKey key,
+    std::span<GuiObject::Vertex const> vertices
+) -> void {
+    if (vertices.empty()) {
+        return;
+    }
+
+    self.pushed.push_back(GuiBatch{
+        .key = key,
+        .first = (u32) self.unsorted.size(),
+        .count = (u32) vertices.size(),
+    });
+
+    self.unsorted.insert(self.unsorted.end(), vertices.begin(), vertices.end());
+}
+
+auto GuiBatcher::build(this GuiBatcher& self) -> void {
+    // A stage has a few dozens of pushes at most, sorting the ranges
+    // instead of vertices is cheap
+    std::ranges::stable_sort(self.pushed, {}, [](GuiBatch const& range) {
+        return range.key.packed();
+    });
+
+    self.vertices.clear();
+    self.batches.clear();
+
+    for (auto const& range : self.pushed) {
+        if (self.batches.empty() || range.key != self.batches.back().key) {
+            self.batches.push_back(GuiBatch{
+                .key = range.key,
+                .first = (u32) self.vertices.size(),
+            });
+        }
+
+        self.vertices.insert(
+            self.vertices.end(), self.unsorted.begin() + range.first,
+            self.unsorted.begin() + range.first + range.count
+        );
+
+        self.batches.back().count += range.count;
+    }
+}
+
+}  // namespace tmine
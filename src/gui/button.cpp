@@ -12,14 +12,7 @@ Button::Button(ButtonStyle style, Text text, glm::vec2 pos, f32 size)
 , text{std::move(text)}
 , pos{pos}
 , size{size} {
-    auto const texture_size = this->style.textures[0].get_size();
-    auto const aspect_ratio = (f32) texture_size.y / (f32) texture_size.x;
-
-    auto& buffer = this->mesh.get_buffer();
-
-    Button::add_gui_rect(&buffer, pos, glm::vec2{size, aspect_ratio * size});
-
-    this->mesh.reload_buffer();
+    Button::add_gui_rect(&this->vertices, pos, this->get_size());
 }
 
 auto Button::get_size(this Button const& self) -> glm::vec2 {
@@ -29,23 +22,19 @@ auto Button::get_size(this Button const& self) -> glm::vec2 {
     return glm::vec2{self.size, aspect_ratio * self.size};
 }
 
-auto Button::render(ShaderProgram const& shader, glm::uvec2 viewport_size)
-    -> void {
-    this->style.textures[(usize) this->state].bind(0);
-
-    auto const aspect_ratio = Window::aspect_ratio_of(viewport_size);
-    auto const proj =
-        glm::ortho(-aspect_ratio, aspect_ratio, -1.0f, 1.0f, 0.0f, 100.0f);
-
-    shader.bind();
-    shader.uniform_mat4("model_projection", proj);
+auto Button::submit(RefMut<GuiBatcher> batcher) const -> void {
+    batcher->push(
+        GuiBatchKey{
+            .layer = GuiLayer::Widgets,
+            .texture_id = this->style.textures[(usize) this->state].get_id(),
+        },
+        this->vertices
+    );
 
-    mesh.draw();
-
-    this->text.render(shader, viewport_size);
+    this->text.submit(batcher);
 }
 
-auto Button::update_state(this Button& self, glm::uvec2 viewport_size) -> void {
+auto Button::update_state(this Button& self, glm::uvec2 viewport_size) -> bool {
     auto const aspect_ratio = Window::aspect_ratio_of(viewport_size);
     auto const transform =
         glm::ortho(-aspect_ratio, aspect_ratio, -1.0f, 1.0f, 0.0f, 100.0f);
@@ -60,6 +49,7 @@ auto Button::update_state(this Button& self, glm::uvec2 viewport_size) -> void {
     auto abs_diff = glm::abs(mouse_pos_local.xy() - self.pos);
     auto button_is_hovered =
         abs_diff.x <= 0.5f * size.x && abs_diff.y <= 0.5f * size.y;
+    auto const prev_state = self.state;
 
     if (button_is_hovered) {
         if (io.is_clicked(MouseButton::Left)) {
@@ -70,6 +60,8 @@ auto Button::update_state(this Button& self, glm::uvec2 viewport_size) -> void {
     } else {
         self.state = ButtonState::Default;
     }
+
+    return prev_state != self.state;
 }
 
 }  // namespace tmine
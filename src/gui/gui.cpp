@@ -1,3 +1,5 @@
+#include <glm/ext.hpp>
+
 #include "../gui.hpp"
 #include "../loaders.hpp"
 #include "../panic.hpp"
@@ -30,6 +32,7 @@ GuiStage::GuiStage(std::shared_ptr<Font> font)
 
 auto GuiStage::add_sprite(this GuiStage& self, Sprite sprite) -> void {
     self.sprites.emplace_back(std::move(sprite));
+    self.needs_rebuild = true;
 }
 
 auto GuiStage::add_button(
@@ -43,6 +46,8 @@ auto GuiStage::add_button(
              pos, size
          }}
     );
+
+    self.needs_rebuild = true;
 }
 
 auto GuiStage::get_button(this GuiStage const& self, std::string_view name)
@@ -54,17 +59,47 @@ auto GuiStage::get_button(this GuiStage const& self, std::string_view name)
     return self.buttons.at(name);
 }
 
-auto GuiStage::render(this GuiStage& self, glm::uvec2 viewport_size) -> void {
-    for (auto& sprite : self.sprites) {
-        sprite.render(self.shader, viewport_size);
+auto GuiStage::rebuild(this GuiStage& self) -> void {
+    self.batcher.clear();
+
+    for (auto const& sprite : self.sprites) {
+        sprite.submit(&self.batcher);
     }
 
-    for (auto& elem : self.buttons) {
+    for (auto const& elem : self.buttons) {
         // C++ just unable to use structural binding by reference without
         // copying so we should manually unpack button reference
-        auto& button = elem.second;
+        auto const& button = elem.second;
 
-        button.render(self.shader, viewport_size);
+        button.submit(&self.batcher);
+    }
+
+    self.batcher.build();
+
+    auto const vertices = self.batcher.get_vertices();
+    self.mesh.get_buffer().assign(vertices.begin(), vertices.end());
+    self.mesh.reload_buffer();
+
+    self.needs_rebuild = false;
+}
+
+auto GuiStage::render(this GuiStage& self, glm::uvec2 viewport_size) -> void {
+    if (self.needs_rebuild) {
+        self.rebuild();
+    }
+
+    auto const aspect_ratio = Window::aspect_ratio_of(viewport_size);
+    auto const projection =
+        glm::ortho(-aspect_ratio, aspect_ratio, -1.0f, 1.0f, 0.0f, 100.0f);
+
+    glDisable(GL_DEPTH_TEST);
+
+    self.shader.bind();
+    self.shader.uniform_mat4("model_projection", projection);
+
+    for (auto const& batch : self.batcher.get_batches()) {
+        Texture::bind_id(batch.key.texture_id, 0);
+        self.mesh.draw_range(batch.first, batch.count);
     }
 }
 
@@ -72,7 +107,9 @@ auto GuiStage::update(this GuiStage& self, glm::uvec2 viewport_size) -> void {
     for (auto& elem : self.buttons) {
         auto& button = elem.second;
 
-        button.update_state(viewport_size);
+        if (button.update_state(viewport_size)) {
+            self.needs_rebuild = true;
+        }
     }
 }
 
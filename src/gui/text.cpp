@@ -1,18 +1,12 @@
-#include "../window.hpp"
 #include "../panic.hpp"
 #include "../gui.hpp"
 
-#include <glm/ext.hpp>
-
 namespace tmine {
 
-namespace rg = std::ranges;
-
-static auto add_quad(
-    std::vector<GuiObject::Vertex>* buffer, glm::vec2 pos, glm::vec2 size,
-    glm::vec2 uv, glm::vec2 uv_size
-) -> void {
-    auto const vertices = std::array{
+static auto quad_of(
+    glm::vec2 pos, glm::vec2 size, glm::vec2 uv, glm::vec2 uv_size
+) -> std::array<GuiObject::Vertex, 6> {
+    return std::array{
         GuiObject::Vertex{
             glm::vec2{pos.x, pos.y + size.y}, glm::vec2{uv.x, uv.y}
         },
@@ -35,44 +29,31 @@ static auto add_quad(
             glm::vec2{uv.x + uv_size.x, uv.y - uv_size.y}
         },
     };
-
-    buffer->insert(buffer->end(), vertices.begin(), vertices.end());
 }
 
-/// # Safety
-///
-/// `font` should have at least one page
-///
-/// # Errors
-///
-/// Throws PanicException if symbol is not alphanumeric
-static auto add_glyph(
-    std::vector<GuiObject::Vertex>* buffer, Font const& font, f32 offset,
-    f32 size, char symbol
-) -> f32 {
-    auto const& first_page = font.pages.front();
-    auto const& desc = first_page.chars[(usize) symbol];
+auto Text::make_glyph(
+    Font const& font, glm::vec2 offset, f32 size, char symbol
+) -> std::array<GuiObject::Vertex, 6> {
+    auto const& desc = font.glyph_of(symbol);
     auto const y = (i32) font.common.line_height / 2 - (i32) desc.offset.y -
                    (i32) desc.size.y;
 
     auto const pos =
-        glm::vec2{offset, size * (f32) y / (f32) font.common.scale.y};
+        offset + glm::vec2{0.0f, size * (f32) y / (f32) font.common.scale.y};
 
-    add_quad(
-        buffer, pos, size * glm::vec2{desc.size} / glm::vec2{font.common.scale},
+    return quad_of(
+        pos, size * glm::vec2{desc.size} / glm::vec2{font.common.scale},
         glm::vec2{desc.pos.x, (i32) font.common.scale.y - (i32) desc.pos.y} /
             glm::vec2{font.common.scale},
         glm::vec2{desc.size} / glm::vec2{font.common.scale}
     );
-
-    return size * (f32) desc.horizontal_advance / (f32) font.common.scale.x;
 }
 
 Text::Text(
     std::shared_ptr<Font> font, Texture glyph_texture, std::string_view text,
     glm::vec2 pos, f32 size
 )
-: mesh{Primitive::Triangles}
+: vertices{}
 , font{font}
 , glyph_texture{std::move(glyph_texture)}
 , pos{pos}
@@ -86,46 +67,49 @@ Text::Text(
 }
 
 auto Text::set_text(this Text& self, std::string_view text) -> void {
-    auto const& first_page = self.font->pages.front();
-    auto const scale_width = self.font->common.scale.x;
+    auto const& font = *self.font;
+    auto const scale = self.size / (f32) font.common.scale.x;
 
-    auto const length =
-        self.size / (f32) scale_width *
-        (f32) rg::fold_left(text, 0, [&](u32 acc, char elem) {
-            return acc + first_page.chars[(usize) elem].horizontal_advance;
-        });
+    auto n_units = i32{0};
 
-    auto& buffer = self.mesh.get_buffer();
-    buffer.clear();
+    for (usize i = 0; i < text.size(); ++i) {
+        n_units += font.advance_of(text, i);
+    }
+
+    auto const length = scale * (f32) n_units;
 
+    self.vertices.clear();
     self.width = 0.0f;
 
-    for (auto symbol : text) {
-        self.width += add_glyph(
-            &buffer, *self.font, self.width - 0.5f * length, self.size, symbol
+    for (usize i = 0; i < text.size(); ++i) {
+        auto const glyph = Text::make_glyph(
+            font, self.pos + glm::vec2{self.width - 0.5f * length, 0.0f},
+            self.size, text[i]
         );
-    }
 
-    self.mesh.reload_buffer();
+        self.vertices.insert(self.vertices.end(), glyph.begin(), glyph.end());
+        self.width += scale * (f32) font.advance_of(text, i);
+    }
 }
 
-auto Text::render(ShaderProgram const& shader, glm::uvec2 viewport_size)
-    -> void {
-    shader.bind();
-    this->glyph_texture.bind(0);
-
-    glDisable(GL_DEPTH_TEST);
+auto Text::set_position(this Text& self, glm::vec2 pos) -> void {
+    auto const shift = pos - self.pos;
 
-    auto const aspect_ratio = Window::aspect_ratio_of(viewport_size);
-    auto const proj =
-        glm::ortho(-aspect_ratio, aspect_ratio, -1.0f, 1.0f, 0.0f, 100.0f);
-
-    auto const model =
-        glm::translate(glm::mat4{1.0f}, glm::vec3(this->pos, 0.0f));
+    for (auto& vertex : self.vertices) {
+        vertex.pos += shift;
+    }
 
-    shader.uniform_mat4("model_projection", proj * model);
+    self.pos = pos;
+}
 
-    mesh.draw();
+auto Text::submit(RefMut<GuiBatcher> batcher) const -> void {
+    batcher->push(
+        GuiBatchKey{
+            .layer = GuiLayer::Labels,
+            .texture_id = this->glyph_texture.get_id(),
+        },
+        this->vertices
+    );
 }
 
 }  // namespace tmine
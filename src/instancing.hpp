@@ -0,0 +1,194 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include "types.hpp"
+#include "graphics.hpp"
+
+namespace tmine {
+
+using MeshId = u16;
+using MaterialId = u16;
+
+/// What an instance is drawn with, instances with equal keys are drawn by a
+/// single call.
+struct InstanceKey {
+    MeshId mesh{0};
+    MaterialId material{0};
+
+    /// Key ordering instances by material first, so that the material
+    /// changes as rarely as possible.
+    inline auto packed(this InstanceKey self) noexcept -> u32 {
+        return (u32) self.material << 16 | (u32) self.mesh;
+    }
+
+    inline auto operator==(this InstanceKey self, InstanceKey other) noexcept
+        -> bool {
+        return self.mesh == other.mesh && self.material == other.material;
+    }
+};
+
+/// Per-instance transform streamed to the GPU.
+struct InstanceData {
+    glm::vec3 offset{0.0f};
+    glm::vec3 scale{1.0f};
+
+    static auto constexpr ATTRIBUTE_SIZES = std::array<usize, 2>{3, 3};
+};
+
+/// Contiguous range of instances in `InstanceBatcher::get_instances()`
+/// sharing one key.
+struct InstanceBatch {
+    InstanceKey key{};
+    u32 first{0};
+    u32 count{0};
+};
+
+/// Collects instances in any order and packs them into batches of equal
+/// keys. Touches no GL state.
+class InstanceBatcher {
+public:
+    auto clear(this InstanceBatcher& self) -> void;
+
+    auto push(
+        this InstanceBatcher& self, InstanceKey key,
+        InstanceData const& instance
+    ) -> void;
+
+    /// Sorts instances pushed since the last `clear` by material, then by
+    /// mesh, keeping the push order within a batch.
+    auto build(this InstanceBatcher& self) -> void;
+
+    inline auto get_instances(this InstanceBatcher const& self) noexcept
+        -> std::span<InstanceData const> {
+        return self.instances;
+    }
+
+    inline auto get_batches(this InstanceBatcher const& self) noexcept
+        -> std::span<InstanceBatch const> {
+        return self.batches;
+    }
+
+private:
+    std::vector<u32> keys;
+    std::vector<InstanceData> unsorted;
+    std::vector<u64> order;
+    std::vector<u64> scratch;
+    std::vector<InstanceData> instances;
+    std::vector<InstanceBatch> batches;
+};
+
+struct InstanceRingBufferData {
+    static auto constexpr DUMMY_ID = GLuint{0};
+    static auto constexpr N_FRAMES_IN_FLIGHT = usize{3};
+
+    GLuint buffer_id{DUMMY_ID};
+    InstanceData* mapped{nullptr};
+    std::array<GLsync, N_FRAMES_IN_FLIGHT> fences{};
+
+    InstanceRingBufferData() = default;
+    ~InstanceRingBufferData();
+    InstanceRingBufferData(InstanceRingBufferData&) = delete;
+    auto operator=(this InstanceRingBufferData&, InstanceRingBufferData&)
+        -> InstanceRingBufferData& = delete;
+
+    /// Blocks until the GPU is done reading the segment of `frame`.
+    auto wait(this InstanceRingBufferData& self, usize frame) -> void;
+};
+
+/// Persistently mapped buffer split into one segment per frame in flight.
+/// Instances are written straight into the mapping, fences keep the CPU from
+/// overwriting a segment the GPU still reads.
+class InstanceRingBuffer {
+public:
+    explicit InstanceRingBuffer(usize capacity = DEFAULT_CAPACITY);
+
+    /// Copies `instances` into the segment of the current frame and returns
+    /// the index of the first of them, to be used as the base instance.
+    auto upload(
+        this InstanceRingBuffer& self, std::span<InstanceData const> instances
+    ) -> u32;
+
+    /// Fences the segment of the current frame and moves to the next one.
+    auto finish_frame(this InstanceRingBuffer& self) -> void;
+
+    inline auto get_id(this InstanceRingBuffer const& self) noexcept
+        -> GLuint {
+        return self.data->buffer_id;
+    }
+
+public:
+    static auto constexpr N_FRAMES_IN_FLIGHT =
+        InstanceRingBufferData::N_FRAMES_IN_FLIGHT;
+    static auto constexpr DEFAULT_CAPACITY = usize{1} << 14;
+
+private:
+    auto allocate(this InstanceRingBuffer& self, usize capacity) -> void;
+
+private:
+    std::shared_ptr<InstanceRingBufferData> data;
+    usize capacity{0};
+    usize frame{0};
+};
+
+struct InstancedVertex {
+    glm::vec3 pos;
+    glm::vec3 normal;
+
+    static auto constexpr ATTRIBUTE_SIZES = std::array<usize, 2>{3, 3};
+};
+
+struct InstancedMeshData {
+    GLuint vertex_array_id{DUMMY_ID};
+    GLuint vertex_buffer_id{DUMMY_ID};
+    u32 n_vertices{0};
+
+    static auto constexpr DUMMY_ID = GLuint{0};
+
+    InstancedMeshData() = default;
+    ~InstancedMeshData();
+    InstancedMeshData(InstancedMeshData&) = delete;
+    auto operator=(this InstancedMeshData&, InstancedMeshData&)
+        -> InstancedMeshData& = delete;
+};
+
+/// Draws batches of `InstanceBatcher` with one instanced call per batch.
+class InstancedRenderer {
+public:
+    InstancedRenderer();
+
+    auto add_mesh(
+        this InstancedRenderer& self,
+        std::span<InstancedVertex const> vertices
+    ) -> MeshId;
+
+    auto add_material(this InstancedRenderer& self, glm::vec4 color)
+        -> MaterialId;
+
+    /// Uploads instances of built `batcher` and draws them.
+    auto draw(
+        this InstancedRenderer& self, InstanceBatcher const& batcher,
+        glm::mat4 projection_view, glm::vec3 light_direction
+    ) -> void;
+
+public:
+    static char constexpr VERTEX_SHADER_NAME[] = "instanced_vertex.glsl";
+    static char constexpr FRAGMENT_SHADER_NAME[] = "instanced_fragment.glsl";
+
+private:
+    std::vector<std::shared_ptr<InstancedMeshData>> meshes;
+    std::vector<glm::vec4> materials;
+    ShaderProgram shader;
+    InstanceRingBuffer instances;
+};
+
+/// Unit cube with its lower corner at the origin.
+auto make_cube_vertices() -> std::vector<InstancedVertex>;
+
+}  // namespace tmine
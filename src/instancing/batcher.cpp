@@ -0,0 +1,91 @@
+#include <array>
+#include <utility>
+
+#include "../instancing.hpp"
+
+namespace tmine {
+
+auto InstanceBatcher::clear(this InstanceBatcher& self) -> void {
+    self.keys.clear();
+    self.unsorted.clear();
+    self.instances.clear();
+    self.batches.clear();
+}
+
+auto InstanceBatcher::push(
+    this InstanceBatcher& self, InstanceKey key, InstanceData const& instance
+) -> void {
+    self.keys.push_back(key.packed());
+    self.unsorted.push_back(instance);
+}
+
+auto InstanceBatcher::build(this InstanceBatcher& self) -> void {
+    auto constexpr N_DIGIT_BITS = u32{8};
+    auto constexpr N_BUCKETS = usize{1} << N_DIGIT_BITS;
+
+    auto const n_instances = self.keys.size();
+
+    // Keys go to the upper half and push indices to the lower one, so
+    // that sorting by keys is stable and gives the order of instances
+    self.order.resize(n_instances);
+    self.scratch.resize(n_instances);
+
+    for (usize i = 0; i < n_instances; ++i) {
+        self.order[i] = (u64) self.keys[i] << 32 | (u64) i;
+    }
+
+    // LSD radix sort by keys, digits every key shares are skipped, so few
+    // distinct meshes and materials cost a pass or two
+    for (u32 shift = 32; shift < 64; shift += N_DIGIT_BITS) {
+        auto counts = std::array<usize, N_BUCKETS>{};
+
+        for (auto const item : self.order) {
+            ++counts[(item >> shift) & (N_BUCKETS - 1)];
+        }
+
+        if (0 == n_instances ||
+            n_instances == counts[(self.order[0] >> shift) & (N_BUCKETS - 1)])
+        {
+            continue;
+        }
+
+        auto offset = usize{0};
+
+        for (auto& count : counts) {
+            offset += std::exchange(count, offset);
+        }
+
+        for (auto const item : self.order) {
+            self.scratch[counts[(item >> shift) & (N_BUCKETS - 1)]++] = item;
+        }
+
+        std::swap(self.order, self.scratch);
+    }
+
+    self.instances.resize(n_instances);
+    self.batches.clear();
+
+    for (usize i = 0; i < n_instances; ++i) {
+        auto const packed_key = (u32) (self.order[i] >> 32);
+        auto const index = (usize) (self.order[i] & ~u32{0});
+
+        self.instances[i] = self.unsorted[index];
+
+        if (self.batches.empty() ||
+            packed_key != self.batches.back().key.packed())
+        {
+            self.batches.push_back(InstanceBatch{
+                .key =
+                    InstanceKey{
+                        .mesh = (MeshId) (packed_key & 0xFFFF),
+                        .material = (MaterialId) (packed_key >> 16),
+                    },
+                .first = (u32) i,
+            });
+        }
+
+        ++self.batches.back().count;
+    }
+}
+
+}  // namespace tmine
@@ -0,0 +1,185 @@
+#include <array>
+#include <limits>
+#include <optional>
+
+#include "../instancing.hpp"
+#include "../loaders.hpp"
+#include "../metrics.hpp"
+#include "../panic.hpp"
+
+namespace tmine {
+
+auto constexpr VERTEX_BINDING = GLuint{0};
+auto constexpr INSTANCE_BINDING = GLuint{1};
+
+InstancedMeshData::~InstancedMeshData() {
+    if (InstancedMeshData::DUMMY_ID != this->vertex_buffer_id) {
+        glDeleteBuffers(1, &this->vertex_buffer_id);
+    }
+
+    if (InstancedMeshData::DUMMY_ID != this->vertex_array_id) {
+        glDeleteVertexArrays(1, &this->vertex_array_id);
+    }
+}
+
+/// Sets up float attributes of `V` starting at `first_location` to be read
+/// from `binding`.
+template <WithAttributes V>
+static auto set_attribute_formats(
+    GLuint vertex_array_id, GLuint binding, GLuint first_location
+) -> void {
+    auto offset = usize{0};
+    auto location = first_location;
+
+    for (auto const size : V::ATTRIBUTE_SIZES) {
+        glEnableVertexArrayAttrib(vertex_array_id, location);
+        glVertexArrayAttribFormat(
+            vertex_array_id, location, (GLint) size, GL_FLOAT, GL_FALSE,
+            (GLuint) (offset * sizeof(f32))
+        );
+        glVertexArrayAttribBinding(vertex_array_id, location, binding);
+
+        offset += size;
+        ++location;
+    }
+}
+
+InstancedRenderer::InstancedRenderer()
+: shader{load_shader(
+      InstancedRenderer::VERTEX_SHADER_NAME,
+      InstancedRenderer::FRAGMENT_SHADER_NAME
+  )}
+, instances{} {}
+
+auto InstancedRenderer::add_mesh(
+    this InstancedRenderer& self, std::span<InstancedVertex const> vertices
+) -> MeshId {
+    if (self.meshes.size() > std::numeric_limits<MeshId>::max()) {
+        throw Panic("too many instanced meshes");
+    }
+
+    auto mesh = std::make_shared<InstancedMeshData>();
+    mesh->n_vertices = (u32) vertices.size();
+
+    glCreateBuffers(1, &mesh->vertex_buffer_id);
+    glNamedBufferStorage(
+        mesh->vertex_buffer_id, vertices.size_bytes(), vertices.data(), 0
+    );
+
+    glCreateVertexArrays(1, &mesh->vertex_array_id);
+    glVertexArrayVertexBuffer(
+        mesh->vertex_array_id, VERTEX_BINDING, mesh->vertex_buffer_id, 0,
+        sizeof(InstancedVertex)
+    );
+
+    set_attribute_formats<InstancedVertex>(
+        mesh->vertex_array_id, VERTEX_BINDING, 0
+    );
+    set_attribute_formats<InstanceData>(
+        mesh->vertex_array_id, INSTANCE_BINDING,
+        (GLuint) InstancedVertex::ATTRIBUTE_SIZES.size()
+    );
+    glVertexArrayBindingDivisor(mesh->vertex_array_id, INSTANCE_BINDING, 1);
+
+    self.meshes.emplace_back(std::move(mesh));
+
+    return (MeshId) (self.meshes.size() - 1);
+}
+
+auto InstancedRenderer::add_material(
+    this InstancedRenderer& self, glm::vec4 color
+) -> MaterialId {
+    if (self.materials.size() > std::numeric_limits<MaterialId>::max()) {
+        throw Panic("too many instanced materials");
+    }
+
+    self.materials.push_back(color);
+
+    return (MaterialId) (self.materials.size() - 1);
+}
+
+auto InstancedRenderer::draw(
+    this InstancedRenderer& self, InstanceBatcher const& batcher,
+    glm::mat4 projection_view, glm::vec3 light_direction
+) -> void {
+    auto const batches = batcher.get_batches();
+
+    if (batches.empty()) {
+        return;
+    }
+
+    auto const base_instance = self.instances.upload(batcher.get_instances());
+
+    self.shader.bind();
+    self.shader.uniform_mat4("projection_view", projection_view);
+    self.shader.uniform_vec3("light_direction", light_direction);
+
+    auto material = std::optional<MaterialId>{};
+
+    for (auto const& batch : batches) {
+        auto const& mesh = *self.meshes.at(batch.key.mesh);
+
+        // Batches are sorted by material, so it changes rarely
+        if (material != batch.key.material) {
+            material = batch.key.material;
+
+            auto const color = self.materials.at(batch.key.material);
+            self.shader.uniform_vec3("color", glm::vec3{color});
+            self.shader.uniform_float("alpha", color.a);
+        }
+
+        glVertexArrayVertexBuffer(
+            mesh.vertex_array_id, INSTANCE_BINDING, self.instances.get_id(), 0,
+            sizeof(InstanceData)
+        );
+
+        glBindVertexArray(mesh.vertex_array_id);
+
+        metrics::add(Counter::DrawCalls);
+        glDrawArraysInstancedBaseInstance(
+            GL_TRIANGLES, 0, (GLsizei) mesh.n_vertices, (GLsizei) batch.count,
+            base_instance + batch.first
+        );
+    }
+
+    glBindVertexArray(0);
+
+    self.instances.finish_frame();
+}
+
+auto make_cube_vertices() -> std::vector<InstancedVertex> {
+    auto vertices = std::vector<InstancedVertex>{};
+    vertices.reserve(36);
+
+    for (i32 axis = 0; axis < 3; ++axis) {
+        auto const u = (axis + 1) % 3;
+        auto const v = (axis + 2) % 3;
+
+        for (auto const side : {0.0f, 1.0f}) {
+            auto normal = glm::vec3{0.0f};
+            normal[axis] = 2.0f * side - 1.0f;
+
+            auto const corner = [&](f32 a, f32 b) {
+                auto pos = glm::vec3{0.0f};
+                pos[axis] = side;
+                pos[u] = a;
+                pos[v] = b;
+
+                return InstancedVertex{.pos = pos, .normal = normal};
+            };
+
+            // Counter-clockwise when looking at the face from outside
+            auto const quad = 0.0f == side
+                ? std::array{corner(0, 0), corner(0, 1), corner(1, 1),
+                             corner(0, 0), corner(1, 1), corner(1, 0)}
+                : std::array{corner(0, 0), corner(1, 0), corner(1, 1),
+                             corner(0, 0), corner(1, 1), corner(0, 1)};
+
+            vertices.insert(vertices.end(), quad.begin(), quad.end());
+        }
+    }
+
+    return vertices;
+}
+
+}  // namespace tmine
@@ -0,0 +1,118 @@
+#include <bit>
+#include <cstring>
+
+#include "../instancing.hpp"
+#include "../panic.hpp"
+
+namespace tmine {
+
+InstanceRingBufferData::~InstanceRingBufferData() {
+    for (auto const fence : this->fences) {
+        if (nullptr != fence) {
+            glDeleteSync(fence);
+        }
+    }
+
+    if (InstanceRingBufferData::DUMMY_ID != this->buffer_id) {
+        glUnmapNamedBuffer(this->buffer_id);
+        glDeleteBuffers(1, &this->buffer_id);
+    }
+}
+
+auto InstanceRingBufferData::wait(
+    this InstanceRingBufferData& self, usize frame
+) -> void {
+    auto constexpr TIMEOUT_NANOSECONDS = GLuint64{1'000'000};
+
+    auto& fence = self.fences[frame];
+
+    if (nullptr == fence) {
+        return;
+    }
+
+    for (;;) {
+        auto const status = glClientWaitSync(
+            fence, GL_SYNC_FLUSH_COMMANDS_BIT, TIMEOUT_NANOSECONDS
+        );
+
+        if (GL_ALREADY_SIGNALED == status || GL_CONDITION_SATISFIED == status)
+        {
+            break;
+        }
+
+        if (GL_WAIT_FAILED == status) {
+            throw Panic(
+                "failed to wait for instance buffer segment #{}", frame
+            );
+        }
+    }
+
+    glDeleteSync(fence);
+    fence = nullptr;
+}
+
+InstanceRingBuffer::InstanceRingBuffer(usize capacity) {
+    this->allocate(capacity);
+}
+
+auto InstanceRingBuffer::allocate(this InstanceRingBuffer& self, usize capacity)
+    -> void {
+    auto constexpr FLAGS =
+        GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    // Old buffer is deleted only after the GPU is done with every segment
+    if (nullptr != self.data) {
+        for (usize i = 0; i < InstanceRingBuffer::N_FRAMES_IN_FLIGHT; ++i) {
+            self.data->wait(i);
+        }
+    }
+
+    auto data = std::make_shared<InstanceRingBufferData>();
+    auto const size = InstanceRingBuffer::N_FRAMES_IN_FLIGHT * capacity *
+                      sizeof(InstanceData);
+
+    glCreateBuffers(1, &data->buffer_id);
+    glNamedBufferStorage(data->buffer_id, size, nullptr, FLAGS);
+
+    data->mapped = (InstanceData*) glMapNamedBufferRange(
+        data->buffer_id, 0, size, FLAGS
+    );
+
+    if (nullptr == data->mapped) {
+        throw Panic("failed to map instance buffer of {} bytes", size);
+    }
+
+    self.data = std::move(data);
+    self.capacity = capacity;
+}
+
+auto InstanceRingBuffer::upload(
+    this InstanceRingBuffer& self, std::span<InstanceData const> instances
+) -> u32 {
+    if (instances.size() > self.capacity) {
+        self.allocate(std::bit_ceil(instances.size()));
+    }
+
+    self.data->wait(self.frame);
+
+    auto const first = self.frame * self.capacity;
+
+    std::memcpy(
+        self.data->mapped + first, instances.data(), instances.size_bytes()
+    );
+
+    return (u32) first;
+}
+
+auto InstanceRingBuffer::finish_frame(this InstanceRingBuffer& self) -> void {
+    auto& fence = self.data->fences[self.frame];
+
+    if (nullptr != fence) {
+        glDeleteSync(fence);
+    }
+
+    fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    self.frame = (self.frame + 1) % InstanceRingBuffer::N_FRAMES_IN_FLIGHT;
+}
+
+}  // namespace tmine
@@ -3,6 +3,8 @@
 #include "data.hpp"
 #include "graphics.hpp"
 
+#include <optional>
+#include <span>
 #include <unordered_map>
 
 namespace tmine {
@@ -11,6 +13,9 @@ char constexpr SHADERS_PATH[] = "assets/shaders";
 
 auto read_to_string(char const* path) -> std::string;
 
+/// Replaces contents of the file at `path` with `bytes`.
+auto write_to_file(char const* path, std::span<u8 const> bytes) -> void;
+
 auto load_png(char const* path) -> Image;
 
 auto load_shader_source(
@@ -34,6 +39,31 @@ auto load_game_blocks_data(
     char const* game_blocks_path, char const* game_block_textures_path
 ) -> GameBlocksData;
 
+/// Identifies the version of a font text file a binary cache was made from.
+struct FontSourceStamp {
+    u64 size{0};
+    i64 modification_time{0};
+
+    auto operator==(this FontSourceStamp const&, FontSourceStamp const&)
+        -> bool = default;
+};
+
+/// Loads a BMFont text file through its binary cache next to it, see
+/// `font_cache_path_of`. The cache is written from the parsed text when it
+/// is missing or does not match the text file.
 auto load_font(char const* font_path) -> Font;
 
+/// Parses a BMFont text file ignoring the cache.
+auto parse_font_file(char const* font_path) -> Font;
+
+auto font_cache_path_of(char const* font_path) -> std::string;
+
+auto serialize_font(Font const& font, FontSourceStamp stamp) -> std::vector<u8>;
+
+/// Returns nothing if `bytes` are not a valid cache of the font text file
+/// with `stamp`. Arrays are copied out of `bytes` with one `memcpy` each, so
+/// the font stays valid after `bytes` are unmapped.
+auto deserialize_font(std::span<u8 const> bytes, FontSourceStamp stamp)
+    -> std::optional<Font>;
+
 }  // namespace tmine
@@ -1,22 +1,474 @@
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <type_traits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <fmt/format.h>
 
 #include "../loaders.hpp"
 #include "../parser.hpp"
 #include "../panic.hpp"
+#include "../profiler.hpp"
+#include "../allocations.hpp"
+#include "../log.hpp"
 
 namespace tmine {
 
 using namespace parser;
 
-auto load_font(char const* path) -> Font {
+static char constexpr FONT_CACHE_MAGIC[] = "TMFN";
+static auto constexpr FONT_CACHE_VERSION = u32{1};
+
+class FontWriter {
+public:
+    explicit FontWriter(RefMut<std::vector<u8>> bytes)
+    : bytes{bytes} {}
+
+    template <class T>
+        requires std::is_trivially_copyable_v<T>
+    auto write(this FontWriter& self, T const& value) -> void {
+        auto const offset = self.bytes->size();
+        self.bytes->resize(offset + sizeof(T));
+        std::memcpy(self.bytes->data() + offset, &value, sizeof(T));
+    }
+
+    /// Writes the number of values followed by the values.
+    template <class T>
+        requires std::is_trivially_copyable_v<T>
+    auto write_array(this FontWriter& self, std::span<T const> values)
+        -> void {
+        self.write((u32) values.size());
+
+        auto const offset = self.bytes->size();
+        self.bytes->resize(offset + values.size_bytes());
+        std::memcpy(
+            self.bytes->data() + offset, values.data(), values.size_bytes()
+        );
+    }
+
+    auto write_string(this FontWriter& self, std::string_view string)
+        -> void {
+        self.write_array(std::span{string.data(), string.size()});
+    }
+
+private:
+    RefMut<std::vector<u8>> bytes;
+};
+
+/// Reads values from a font cache. Running out of bytes gives zeroed values
+/// and is reported by `is_ok`.
+class FontReader {
+public:
+    explicit FontReader(std::span<u8 const> bytes)
+    : bytes{bytes} {}
+
+    template <class T>
+        requires std::is_trivially_copyable_v<T>
+    auto read(this FontReader& self) -> T {
+        auto value = T{};
+
+        if (self.bytes.size() - self.offset < sizeof(T)) {
+            self.is_truncated = true;
+            return value;
+        }
+
+        std::memcpy(&value, self.bytes.data() + self.offset, sizeof(T));
+        self.offset += sizeof(T);
+
+        return value;
+    }
+
+    template <class T>
+        requires std::is_trivially_copyable_v<T>
+    auto read_array(this FontReader& self, RefMut<std::vector<T>> values)
+        -> void {
+        auto const count = (usize) self.read<u32>();
+
+        // Checked before resizing, so that garbage counts do not allocate
+        if ((self.bytes.size() - self.offset) / sizeof(T) < count) {
+            self.is_truncated = true;
+            return;
+        }
+
+        values->resize(count);
+        std::memcpy(
+            values->data(), self.bytes.data() + self.offset, count * sizeof(T)
+        );
+        self.offset += count * sizeof(T);
+    }
+
+    auto read_string(this FontReader& self) -> std::string {
+        auto const size = (usize) self.read<u32>();
+
+        if (self.bytes.size() - self.offset < size) {
+            self.is_truncated = true;
+            return {};
+        }
+
+        auto result =
+            std::string{(char const*) self.bytes.data() + self.offset, size};
+        self.offset += size;
+
+        return result;
+    }
+
+    inline auto is_ok(this FontReader const& self) noexcept -> bool {
+        return !self.is_truncated;
+    }
+
+    inline auto is_finished(this FontReader const& self) noexcept -> bool {
+        return self.offset == self.bytes.size();
+    }
+
+private:
+    std::span<u8 const> bytes;
+    usize offset{0};
+    bool is_truncated{false};
+};
+
+/// Read-only mapping of a whole file, empty if the file can not be mapped.
+class MappedFile {
+public:
+    explicit MappedFile(char const* path) {
+        auto const descriptor = open(path, O_RDONLY | O_CLOEXEC);
+
+        if (-1 == descriptor) {
+            return;
+        }
+
+        struct stat status {};
+
+        if (0 == fstat(descriptor, &status) && status.st_size > 0) {
+            auto const data = mmap(
+                nullptr, (usize) status.st_size, PROT_READ, MAP_PRIVATE,
+                descriptor, 0
+            );
+
+            if (MAP_FAILED != data) {
+                this->data = (u8 const*) data;
+                this->size = (usize) status.st_size;
+            }
+        }
+
+        close(descriptor);
+    }
+
+    ~MappedFile() {
+        if (nullptr != this->data) {
+            munmap((void*) this->data, this->size);
+        }
+    }
+
+    MappedFile(MappedFile const&) = delete;
+    auto operator=(this MappedFile&, MappedFile const&)
+        -> MappedFile& = delete;
+
+    inline auto get_bytes(this MappedFile const& self) noexcept
+        -> std::span<u8 const> {
+        return std::span{self.data, self.size};
+    }
+
+private:
+    u8 const* data{nullptr};
+    usize size{0};
+};
+
+/// Fills lookup tables of `font` from chars and kernings of its first page.
+static auto build_lookups(RefMut<Font> font) -> void {
+    if (font->pages.empty()) {
+        return;
+    }
+
+    auto const& first_page = font->pages.front();
+
+    // The parser puts every char at the index of its id, ids that do not fit
+    // a byte overwrite others and are dropped here
+    for (usize i = 0; i < Font::N_GLYPHS; ++i) {
+        auto const is_present =
+            i < first_page.chars.size() && i == first_page.chars[i].id;
+
+        font->glyph_indices[i] = is_present ? (u8) i : u8{0};
+    }
+
+    auto const is_byte_pair = [](FontKerning const& kerning) {
+        return kerning.first < Font::N_GLYPHS &&
+               kerning.second < Font::N_GLYPHS;
+    };
+
+    auto const n_kernings = std::ranges::count_if(
+        first_page.kernings, is_byte_pair
+    );
+
+    font->kerning_slots.clear();
+
+    if (0 == n_kernings) {
+        return;
+    }
+
+    font->kerning_slots.resize(std::bit_ceil(2 * (usize) n_kernings));
+
+    auto const n_slots = font->kerning_slots.size();
+
+    for (auto const& kerning : first_page.kernings) {
+        if (!is_byte_pair(kerning)) {
+            continue;
+        }
+
+        auto const key = Font::kerning_key_of(kerning.first, kerning.second);
+        auto i = Font::slot_index_of(key, n_slots);
+
+        while (FontKerningSlot::EMPTY_KEY != font->kerning_slots[i].key &&
+               key != font->kerning_slots[i].key)
+        {
+            i = (i + 1) & (n_slots - 1);
+        }
+
+        font->kerning_slots[i] =
+            FontKerningSlot{.key = key, .amount = kerning.amount};
+    }
+}
+
+/// Checks what lookups of a deserialized font rely on.
+static auto has_valid_lookups(Font const& font) -> bool {
+    if (font.pages.empty()) {
+        return false;
+    }
+
+    auto const n_chars = font.pages.front().chars.size();
+
+    for (auto const index : font.glyph_indices) {
+        if (index >= n_chars) {
+            return false;
+        }
+    }
+
+    auto const n_slots = font.kerning_slots.size();
+
+    if (0 == n_slots) {
+        return true;
+    }
+
+    // Probing stops only at an empty slot
+    return std::has_single_bit(n_slots) &&
+           std::ranges::any_of(font.kerning_slots, [](auto const& slot) {
+               return FontKerningSlot::EMPTY_KEY == slot.key;
+           });
+}
+
+static auto source_stamp_of(char const* path)
+    -> std::optional<FontSourceStamp> {
+    auto error = std::error_code{};
+
+    auto const size = std::filesystem::file_size(path, error);
+
+    if (error) {
+        return std::nullopt;
+    }
+
+    auto const time = std::filesystem::last_write_time(path, error);
+
+    if (error) {
+        return std::nullopt;
+    }
+
+    return FontSourceStamp{
+        .size = (u64) size,
+        .modification_time = (i64) time.time_since_epoch().count(),
+    };
+}
+
+/// Writes a temporary file first, so that readers never map a partial cache.
+static auto write_font_cache(char const* path, std::span<u8 const> bytes)
+    -> bool {
+    auto const temporary_path = fmt::format("{}.tmp", path);
+
+    try {
+        write_to_file(temporary_path.c_str(), bytes);
+    } catch (PanicException const&) {
+        std::remove(temporary_path.c_str());
+        return false;
+    }
+
+    return 0 == std::rename(temporary_path.c_str(), path);
+}
+
+auto font_cache_path_of(char const* font_path) -> std::string {
+    return fmt::format("{}.bin", font_path);
+}
+
+auto serialize_font(Font const& font, FontSourceStamp stamp)
+    -> std::vector<u8> {
+    auto bytes = std::vector<u8>{};
+    auto writer = FontWriter{&bytes};
+
+    for (usize i = 0; i < sizeof(FONT_CACHE_MAGIC) - 1; ++i) {
+        writer.write(FONT_CACHE_MAGIC[i]);
+    }
+
+    writer.write(FONT_CACHE_VERSION);
+    writer.write(stamp.size);
+    writer.write(stamp.modification_time);
+
+    auto const& info = font.info;
+
+    writer.write_string(info.face);
+    writer.write(info.size);
+    writer.write((u8) info.is_bold);
+    writer.write((u8) info.is_italic);
+    writer.write_string(info.charset);
+    writer.write((u8) info.is_unicode);
+    writer.write(info.horizontal_stretch);
+    writer.write((u8) info.is_smooth);
+    writer.write((u8) info.is_antialiased);
+    writer.write(info.padding);
+    writer.write(info.spacing);
+
+    auto const& common = font.common;
+
+    writer.write(common.line_height);
+    writer.write(common.base);
+    writer.write(common.scale);
+    writer.write(common.n_pages);
+    writer.write((u8) common.is_packed);
+
+    writer.write((u32) font.pages.size());
+
+    for (auto const& page : font.pages) {
+        writer.write(page.header.id);
+        writer.write_string(page.header.file);
+        writer.write(page.chars_header.count);
+        writer.write_array(std::span{page.chars});
+        writer.write(page.kernings_header.count);
+        writer.write_array(std::span{page.kernings});
+    }
+
+    writer.write(font.glyph_indices);
+    writer.write_array(std::span{font.kerning_slots});
+
+    return bytes;
+}
+
+auto deserialize_font(std::span<u8 const> bytes, FontSourceStamp stamp)
+    -> std::optional<Font> {
+    auto reader = FontReader{bytes};
+
+    for (usize i = 0; i < sizeof(FONT_CACHE_MAGIC) - 1; ++i) {
+        if (reader.read<char>() != FONT_CACHE_MAGIC[i]) {
+            return std::nullopt;
+        }
+    }
+
+    if (FONT_CACHE_VERSION != reader.read<u32>()) {
+        return std::nullopt;
+    }
+
+    auto const cached_stamp = FontSourceStamp{
+        .size = reader.read<u64>(),
+        .modification_time = reader.read<i64>(),
+    };
+
+    if (stamp != cached_stamp) {
+        return std::nullopt;
+    }
+
+    auto font = Font{};
+    auto& info = font.info;
+
+    info.face = reader.read_string();
+    info.size = reader.read<u32>();
+    info.is_bold = 0 != reader.read<u8>();
+    info.is_italic = 0 != reader.read<u8>();
+    info.charset = reader.read_string();
+    info.is_unicode = 0 != reader.read<u8>();
+    info.horizontal_stretch = reader.read<u32>();
+    info.is_smooth = 0 != reader.read<u8>();
+    info.is_antialiased = 0 != reader.read<u8>();
+    info.padding = reader.read<glm::ivec4>();
+    info.spacing = reader.read<glm::ivec2>();
+
+    auto& common = font.common;
+
+    common.line_height = reader.read<u32>();
+    common.base = reader.read<u32>();
+    common.scale = reader.read<glm::uvec2>();
+    common.n_pages = reader.read<u32>();
+    common.is_packed = 0 != reader.read<u8>();
+
+    auto const n_pages = (usize) reader.read<u32>();
+
+    // Every page takes more than a byte, so that garbage counts are caught
+    // before allocating
+    if (n_pages > bytes.size()) {
+        return std::nullopt;
+    }
+
+    font.pages.resize(n_pages);
+
+    for (auto& page : font.pages) {
+        page.header.id = reader.read<u32>();
+        page.header.file = reader.read_string();
+        page.chars_header.count = reader.read<u32>();
+        reader.read_array(&page.chars);
+        page.kernings_header.count = reader.read<u32>();
+        reader.read_array(&page.kernings);
+    }
+
+    font.glyph_indices = reader.read<std::array<u8, Font::N_GLYPHS>>();
+    reader.read_array(&font.kerning_slots);
+
+    if (!reader.is_ok() || !reader.is_finished() || !has_valid_lookups(font)) {
+        return std::nullopt;
+    }
+
+    return font;
+}
+
+auto parse_font_file(char const* path) -> Font {
+    tmine_profile_zone("parse_font_file");
+
     auto const font_text = read_to_string(path);
-    auto const parse_result = parse_font(font_text);
+    auto parse_result = parse_font(font_text);
 
     if (!parse_result.ok()) {
         throw Panic("failed to parse font {}", path);
     }
 
-    return std::move(parse_result).get_value();
+    auto font = std::move(parse_result).get_value();
+    build_lookups(&font);
+
+    return font;
+}
+
+auto load_font(char const* path) -> Font {
+    tmine_profile_zone("load_font");
+    auto const allocation_scope = AllocationScope{AllocationTag::Fonts};
+
+    auto const cache_path = font_cache_path_of(path);
+    auto const stamp = source_stamp_of(path);
+
+    if (stamp.has_value()) {
+        auto const cache = MappedFile{cache_path.c_str()};
+
+        if (auto font = deserialize_font(cache.get_bytes(), stamp.value())) {
+            return std::move(font).value();
+        }
+    }
+
+    auto font = parse_font_file(path);
+
+    // Fonts still load from a read-only directory, only slower
+    if (stamp.has_value() &&
+        !write_font_cache(cache_path.c_str(), serialize_font(font, *stamp)))
+    {
+        tmine_log("failed to write font cache '{}'\n", cache_path);
+    }
+
+    return font;
 }
 
 }  // namespace tmine
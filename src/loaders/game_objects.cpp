@@ -6,6 +6,7 @@
 
 #include "../panic.hpp"
 #include "../loaders.hpp"
+#include "../profiler.hpp"
 
 namespace tmine {
 
@@ -395,6 +396,8 @@ auto load_game_block_textures(char const* path)
 auto load_game_blocks_data(
     char const* game_blocks_path, char const* game_block_textures_path
 ) -> GameBlocksData {
+    tmine_profile_zone("load_game_blocks_data");
+
     auto textures = load_game_block_textures(game_block_textures_path);
     auto blocks = load_game_blocks(game_blocks_path, textures);
 
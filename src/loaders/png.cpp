@@ -8,10 +8,15 @@
 #include <fmt/format.h>
 
 #include "../loaders.hpp"
+#include "../profiler.hpp"
+#include "../allocations.hpp"
 
 namespace tmine {
 
 auto load_png(char const* path) -> Image {
+    tmine_profile_zone("load_png");
+    auto const allocation_scope = AllocationScope{AllocationTag::Images};
+
     FILE* image_file;
     int result = 0;
     spng_ctx* ctx = NULL;
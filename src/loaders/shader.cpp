@@ -1,4 +1,5 @@
 #include "../loaders.hpp"
+#include "../profiler.hpp"
 
 namespace tmine {
 
@@ -24,6 +25,8 @@ auto load_shader_source(
 auto load_shader(
     char const* vertex_source_path, char const* fragment_source_path
 ) -> ShaderProgram {
+    tmine_profile_zone("load_shader");
+
     auto const source =
         load_shader_source(vertex_source_path, fragment_source_path);
 
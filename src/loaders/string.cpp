@@ -5,6 +5,7 @@
 #include <fmt/format.h>
 
 #include "../loaders.hpp"
+#include "../panic.hpp"
 
 namespace tmine {
 
@@ -63,4 +64,19 @@ auto read_to_string(char const* path) -> std::string {
     return result;
 }
 
+auto write_to_file(char const* path, std::span<u8 const> bytes) -> void {
+    auto const file = std::fopen(path, "wb");
+
+    if (nullptr == file) {
+        throw Panic("failed to open file '{}': {}", path, std::strerror(errno));
+    }
+
+    auto const n_written = std::fwrite(bytes.data(), 1, bytes.size(), file);
+    auto const is_closed = 0 == std::fclose(file);
+
+    if (bytes.size() != n_written || !is_closed) {
+        throw Panic("failed to write to file '{}'", path);
+    }
+}
+
 }  // namespace tmine
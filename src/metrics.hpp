@@ -0,0 +1,134 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+
+#include "types.hpp"
+
+namespace tmine {
+
+/// Subsystems timed every frame. Scopes of the same subsystem add up within
+/// a frame.
+enum class Timing : u8 {
+    Input = 0,
+    PhysicsTicks,
+    Meshing,
+    TransparentSort,
+    Uploads,
+    DrawSubmission,
+};
+
+inline auto constexpr N_TIMINGS = usize{6};
+
+/// Events counted every frame.
+enum class Counter : u8 {
+    ChunksRemeshed = 0,
+    VerticesUploaded,
+    DrawCalls,
+    CulledChunks,
+};
+
+inline auto constexpr N_COUNTERS = usize{4};
+
+/// Timings of one subsystem over the last `MetricsRegistry::WINDOW_SIZE`
+/// frames, in seconds.
+struct TimingStats {
+    f64 min{0.0};
+    f64 avg{0.0};
+    f64 p99{0.0};
+};
+
+/// Per-frame timings and counters. `add_time` and `add` may be called from
+/// any thread, they only touch atomics. Everything else belongs to the main
+/// thread.
+class MetricsRegistry {
+public:
+    inline auto add(
+        this MetricsRegistry& self, Counter counter, u64 value = 1
+    ) noexcept -> void {
+        self.frame_counts[(usize) counter].fetch_add(
+            value, std::memory_order_relaxed
+        );
+    }
+
+    inline auto add_time(
+        this MetricsRegistry& self, Timing timing, u64 nanoseconds
+    ) noexcept -> void {
+        self.frame_times[(usize) timing].fetch_add(
+            nanoseconds, std::memory_order_relaxed
+        );
+    }
+
+    /// Moves values accumulated since the previous call into the rolling
+    /// windows and starts accumulating anew.
+    auto finish_frame(this MetricsRegistry& self) noexcept -> void;
+
+    auto get_stats(this MetricsRegistry const& self, Timing timing)
+        -> TimingStats;
+
+    /// Time of `timing` in the last finished frame, in seconds.
+    inline auto get_last_time(
+        this MetricsRegistry const& self, Timing timing
+    ) noexcept -> f64 {
+        if (0 == self.n_frames) {
+            return 0.0;
+        }
+
+        auto const slot = (self.n_frames - 1) % MetricsRegistry::WINDOW_SIZE;
+        return self.history[(usize) timing][slot];
+    }
+
+    /// Count of the last finished frame.
+    inline auto get_count(
+        this MetricsRegistry const& self, Counter counter
+    ) noexcept -> u64 {
+        return self.last_counts[(usize) counter];
+    }
+
+public:
+    static auto constexpr WINDOW_SIZE = usize{240};
+
+private:
+    std::array<std::atomic<u64>, N_TIMINGS> frame_times{};
+    std::array<std::atomic<u64>, N_COUNTERS> frame_counts{};
+    std::array<std::array<f32, WINDOW_SIZE>, N_TIMINGS> history{};
+    std::array<u64, N_COUNTERS> last_counts{};
+    usize n_frames{0};
+};
+
+namespace metrics {
+
+    inline constinit auto REGISTRY = MetricsRegistry{};
+
+    inline auto add(Counter counter, u64 value = 1) noexcept -> void {
+        REGISTRY.add(counter, value);
+    }
+
+    /// Human-readable name, e.g. "Physics ticks".
+    auto name_of(Timing timing) noexcept -> char const*;
+
+    /// Human-readable name, e.g. "Draw calls".
+    auto name_of(Counter counter) noexcept -> char const*;
+
+    /// Finishes the frame of the global registry and shows its stats in
+    /// the debug text.
+    auto update() -> void;
+
+}  // namespace metrics
+
+/// Adds its lifetime to `timing` of the global registry.
+class ScopedTiming {
+public:
+    explicit ScopedTiming(Timing timing) noexcept;
+    ~ScopedTiming();
+
+    ScopedTiming(ScopedTiming const&) = delete;
+    auto operator=(this ScopedTiming&, ScopedTiming const&)
+        -> ScopedTiming& = delete;
+
+private:
+    Timing timing;
+    u64 start;
+};
+
+}  // namespace tmine
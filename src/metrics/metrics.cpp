@@ -0,0 +1,126 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numeric>
+#include <span>
+#include <fmt/format.h>
+
+#include "../metrics.hpp"
+#include "../profiler.hpp"
+#include "../debug.hpp"
+
+namespace tmine {
+
+auto MetricsRegistry::finish_frame(this MetricsRegistry& self) noexcept
+    -> void {
+    auto const slot = self.n_frames % MetricsRegistry::WINDOW_SIZE;
+
+    for (usize i = 0; i < N_TIMINGS; ++i) {
+        auto const nanoseconds =
+            self.frame_times[i].exchange(0, std::memory_order_relaxed);
+
+        self.history[i][slot] = (f32) (1e-9 * (f64) nanoseconds);
+    }
+
+    for (usize i = 0; i < N_COUNTERS; ++i) {
+        self.last_counts[i] =
+            self.frame_counts[i].exchange(0, std::memory_order_relaxed);
+    }
+
+    self.n_frames += 1;
+}
+
+auto MetricsRegistry::get_stats(this MetricsRegistry const& self, Timing timing)
+    -> TimingStats {
+    auto const n_values =
+        std::min(self.n_frames, MetricsRegistry::WINDOW_SIZE);
+
+    if (0 == n_values) {
+        return TimingStats{};
+    }
+
+    auto values = self.history[(usize) timing];
+    auto const sorted = std::span{values.data(), n_values};
+
+    std::ranges::sort(sorted);
+
+    auto const p99_index = (usize) std::ceil(0.99 * (f64) n_values) - 1;
+    auto const sum = std::accumulate(sorted.begin(), sorted.end(), 0.0);
+
+    return TimingStats{
+        .min = sorted.front(),
+        .avg = sum / (f64) n_values,
+        .p99 = sorted[p99_index],
+    };
+}
+
+ScopedTiming::ScopedTiming(Timing timing) noexcept
+: timing{timing}
+, start{profiler::now()} {}
+
+ScopedTiming::~ScopedTiming() {
+    metrics::REGISTRY.add_time(this->timing, profiler::now() - this->start);
+}
+
+namespace metrics {
+
+    static auto constexpr TIMING_NAMES = std::array<char const*, N_TIMINGS>{
+        "Input",   "Physics ticks", "Meshing", "Transparent sort",
+        "Uploads", "Draw submission",
+    };
+
+    static auto constexpr COUNTER_NAMES = std::array<char const*, N_COUNTERS>{
+        "Chunks remeshed",
+        "Vertices uploaded",
+        "Draw calls",
+        "Culled chunks",
+    };
+
+    auto name_of(Timing timing) noexcept -> char const* {
+        return TIMING_NAMES[(usize) timing];
+    }
+
+    auto name_of(Counter counter) noexcept -> char const* {
+        return COUNTER_NAMES[(usize) counter];
+    }
+
+    // Digits keep the lines in this order in the debug text
+    static auto constexpr TIMING_KEYS = std::array<char const*, N_TIMINGS>{
+        "metrics#0", "metrics#1", "metrics#2",
+        "metrics#3", "metrics#4", "metrics#5",
+    };
+
+    auto update() -> void {
+        REGISTRY.finish_frame();
+
+        // Rebuilding text lines is not free, skip it when nobody sees them
+        if (!DEBUG_IS_ENABLED) {
+            return;
+        }
+
+        auto text = debug::text();
+
+        for (usize i = 0; i < N_TIMINGS; ++i) {
+            auto const stats = REGISTRY.get_stats((Timing) i);
+
+            text->set_formatted(
+                TIMING_KEYS[i], "{}: min {:.2f}, avg {:.2f}, p99 {:.2f} ms",
+                name_of((Timing) i), 1e3 * stats.min, 1e3 * stats.avg,
+                1e3 * stats.p99
+            );
+        }
+
+        text->set_formatted(
+            "metrics#counters",
+            "Chunks remeshed: {}, vertices uploaded: {}, draw calls: {}, "
+            "culled chunks: {}",
+            REGISTRY.get_count(Counter::ChunksRemeshed),
+            REGISTRY.get_count(Counter::VerticesUploaded),
+            REGISTRY.get_count(Counter::DrawCalls),
+            REGISTRY.get_count(Counter::CulledChunks)
+        );
+    }
+
+}  // namespace metrics
+
+}  // namespace tmine
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <memory>
+#include <utility>
 #include <concepts>
 
 #include "graphics.hpp"
@@ -8,6 +9,8 @@
 #include "terrain.hpp"
 #include "panic.hpp"
 #include "physics.hpp"
+#include "entities.hpp"
+#include "instancing.hpp"
 
 namespace tmine {
 
@@ -83,6 +86,29 @@ private:
     Mesh<Vertex> mesh;
 };
 
+/// Draws entities with colliders as boxes scaled to their colliders.
+class EntityRenderer : public SceneObject {
+public:
+    EntityRenderer();
+
+    /// Batches entities of `registry` to be drawn on the next render.
+    auto submit(this EntityRenderer& self, EntityRegistry const& registry)
+        -> void;
+
+    auto render(
+        Camera const& camera, SceneParameters const& params, RenderPass pass
+    ) -> void override;
+
+public:
+    static auto constexpr CUBE_MESH = MeshId{0};
+    static auto constexpr DEFAULT_MATERIAL = MaterialId{0};
+    static auto constexpr ITEM_MATERIAL = MaterialId{1};
+
+private:
+    InstanceBatcher batcher;
+    InstancedRenderer renderer;
+};
+
 enum class ChunkState : u8 {
     UpToDate,
     VoxelsUpdated,
@@ -91,7 +117,9 @@ enum class ChunkState : u8 {
 
 class Terrain : public SceneObject {
 public:
-    explicit Terrain(glm::uvec3 sizes);
+    /// Draws `chunks`, generated elsewhere, so that the world can exist
+    /// without GL.
+    explicit Terrain(std::shared_ptr<ChunkArray> chunks);
 
     auto render(
         Camera const& camera, SceneParameters const& params, RenderPass pass
@@ -109,15 +137,64 @@ public:
 
     auto set_voxel(this Terrain& self, glm::uvec3 pos, Voxel value) -> void;
 
+    /// Sets all voxels in the box from `lo` to `hi` inclusive to `value`.
+    auto fill_box(
+        this Terrain& self, glm::uvec3 lo, glm::uvec3 hi, Voxel value
+    ) -> void;
+
+    /// Sets all voxels within `radius` from `center` to `value`.
+    auto replace_in_sphere(
+        this Terrain& self, glm::uvec3 center, u32 radius, Voxel value
+    ) -> void;
+
+    /// Copies non-air voxels of `structure` with its corner placed at `pos`.
+    auto paste_structure(
+        this Terrain& self, VoxelStructure const& structure, glm::uvec3 pos
+    ) -> void;
+
     auto update(this Terrain& self, glm::vec3 camera_pos) -> void;
 
+    /// Bounding boxes of voxels edited since the last call, at most one box
+    /// per edited chunk.
+    inline auto take_edited_boxes(this Terrain& self) -> std::vector<Aabb> {
+        return std::exchange(self.edited_boxes, {});
+    }
+
     inline auto get_data(this Terrain const& self) -> GameBlocksData const& {
         return self.renderer.data;
     }
 
 private:
+    /// Local bounds and translucency changes of voxels edited in one chunk.
+    struct ChunkEdit {
+        glm::uvec3 lo{Chunk::SIZE};
+        glm::uvec3 hi{0};
+        bool removes_translucent{false};
+        bool adds_translucent{false};
+    };
+
     auto generate_meshes(this Terrain& self, glm::vec3 camera_pos) -> void;
 
+    /// Writes `voxel_at(pos)` for every voxel `pos` in `[lo, hi]` through
+    /// `ChunkArray::edit_region` and marks the edited chunks.
+    template <class F>
+    auto edit_region(
+        this Terrain& self, glm::uvec3 lo, glm::uvec3 hi, F&& voxel_at
+    ) -> void;
+
+    /// Marks local voxels from `lo` to `hi` of a chunk edited in bulk.
+    auto mark_region_edited(
+        this Terrain& self, glm::uvec3 chunk_pos, glm::uvec3 lo, glm::uvec3 hi
+    ) -> void;
+
+    /// Updates transparency and mesh bookkeeping after `chunk_pos` was edited.
+    auto mark_chunk_edited(
+        this Terrain& self, glm::uvec3 chunk_pos, ChunkEdit const& edit
+    ) -> void;
+
+    auto is_translucent(this Terrain const& self, Voxel voxel) noexcept
+        -> bool;
+
     auto render_opaque(
         this Terrain& self, Camera const& camera, SceneParameters const& params,
         glm::uvec2 viewport_size
@@ -151,6 +228,7 @@ private:
     TerrainRenderer::TransparentMesh transparent_mesh{};
     std::vector<usize> chunks_to_update;
     ThreadsafeVec<usize> chunks_with_transparency;
+    std::vector<Aabb> edited_boxes;
     TerrainRenderer renderer;
     ShaderProgram opaque_shader;
     ShaderProgram transparent_shader;
@@ -158,28 +236,9 @@ private:
     Texture normal_atlas;
 };
 
-class TerrainCollider final : public Collidable {
-public:
-    using Super = Collidable;
-
-    inline explicit TerrainCollider(std::shared_ptr<ChunkArray> chunks)
-    : Super{glm::vec3{0.0f}, glm::vec3{0.0f}, ABSOLUTELY_ELASTIC_ELASTICITY, false}
-    , chunks{chunks} {}
-
-    auto get_collidable_bounding_box() const -> Aabb override;
-    auto collide(Collidable const& other) const -> Collision override;
-    inline auto displace_collidable(glm::vec3) -> void override {}
-
-    auto collide_box(this TerrainCollider const& self, BoxCollider const& other)
-        -> Collision;
-
-private:
-    std::shared_ptr<ChunkArray> chunks;
-};
-
 class Scene {
 public:
-    explicit Scene(glm::uvec2 viewport_size);
+    Scene(glm::uvec2 viewport_size, std::shared_ptr<ChunkArray> chunks);
 
     auto render(
         this Scene& self, Camera const& camera, glm::uvec2 viewport_size
@@ -0,0 +1,70 @@
+#include "../objects.hpp"
+#include "../window.hpp"
+#include "../metrics.hpp"
+
+namespace tmine {
+
+EntityRenderer::EntityRenderer() {
+    auto const cube = make_cube_vertices();
+
+    this->renderer.add_mesh(cube);
+    this->renderer.add_material(glm::vec4{0.8f, 0.8f, 0.8f, 1.0f});
+    this->renderer.add_material(glm::vec4{0.9f, 0.55f, 0.2f, 1.0f});
+}
+
+auto EntityRenderer::submit(
+    this EntityRenderer& self, EntityRegistry const& registry
+) -> void {
+    auto const& colliders = registry.storage<EntityCollider>();
+    auto const& transforms = registry.storage<Transform>();
+    auto const& models = registry.storage<EntityModel>();
+
+    auto const entities = colliders.entities();
+    auto const collider_components = colliders.components();
+
+    self.batcher.clear();
+
+    for (usize i = 0; i < entities.size(); ++i) {
+        auto const transform_index = transforms.index_of(entities[i]);
+
+        if (SparseSet<Transform>::NONE == transform_index) {
+            continue;
+        }
+
+        auto const model_index = models.index_of(entities[i]);
+        auto const model = SparseSet<EntityModel>::NONE == model_index
+                               ? EntityModel{}
+                               : models.components()[model_index];
+
+        self.batcher.push(
+            InstanceKey{.mesh = model.mesh, .material = model.material},
+            InstanceData{
+                .offset = transforms.components()[transform_index].pos,
+                .scale = collider_components[i].size,
+            }
+        );
+    }
+
+    self.batcher.build();
+}
+
+auto EntityRenderer::render(
+    Camera const& camera, SceneParameters const& params, RenderPass pass
+) -> void {
+    auto const timing = ScopedTiming{Timing::DrawSubmission};
+    auto const aspect_ratio = Window::aspect_ratio_of(pass.viewport_size);
+
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_CULL_FACE);
+
+    this->renderer.draw(
+        this->batcher,
+        camera.get_projection(aspect_ratio) * camera.get_view(),
+        params.light_direction
+    );
+
+    glDisable(GL_CULL_FACE);
+    glDisable(GL_DEPTH_TEST);
+}
+
+}  // namespace tmine
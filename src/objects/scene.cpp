@@ -1,12 +1,14 @@
 #include "../objects.hpp"
 #include "../loaders.hpp"
+#include "../profiler.hpp"
+#include "../metrics.hpp"
 
 namespace tmine {
 
 char constexpr FRAMEBUFFER_VERTEX_SHADER_NAME[] = "postproc_vertex.glsl";
 char constexpr FRAMEBUFFER_FRAGMENT_SHADER_NAME[] = "postproc_fragment.glsl";
 
-Scene::Scene(glm::uvec2 viewport_size)
+Scene::Scene(glm::uvec2 viewport_size, std::shared_ptr<ChunkArray> chunks)
 : deferred_shader{load_shader(
       FRAMEBUFFER_VERTEX_SHADER_NAME, FRAMEBUFFER_FRAGMENT_SHADER_NAME
   )}
@@ -14,13 +16,18 @@ Scene::Scene(glm::uvec2 viewport_size)
 , viewport_size{viewport_size}
 , objects{} {
     this->add(Skybox{});
-    this->add_unique(Terrain{glm::uvec3{16, 4, 16}});
+    // Entities go before the terrain, so that its transparent voxels blend
+    // over them
+    this->add_unique(EntityRenderer{});
+    this->add_unique(Terrain{std::move(chunks)});
     this->add_unique(SelectionBox{});
 }
 
 auto Scene::render(
     this Scene& self, Camera const& camera, glm::uvec2 viewport_size
 ) -> void {
+    tmine_profile_zone("Scene::render");
+
     // reload frame buffer if viewport size have been updated
     if (viewport_size != self.viewport_size) {
         self.viewport_size = viewport_size;
@@ -42,6 +49,8 @@ auto Scene::render(
     }
 
     self.deferred_renderer.unbind_geometry_buffer();
+
+    auto const timing = ScopedTiming{Timing::DrawSubmission};
     self.deferred_renderer.draw_screen_pass();
 }
 
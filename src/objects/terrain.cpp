@@ -6,7 +6,8 @@
 #include "../objects.hpp"
 #include "../loaders.hpp"
 #include "../window.hpp"
-#include "../debug.hpp"
+#include "../profiler.hpp"
+#include "../metrics.hpp"
 
 namespace tmine {
 
@@ -22,12 +23,12 @@ static auto dedup_vector(RefMut<T> vec) -> void {
     vec->erase(it, vec->end());
 }
 
-Terrain::Terrain(glm::uvec3 sizes)
-: chunks{std::make_shared<ChunkArray>(sizes)}
+Terrain::Terrain(std::shared_ptr<ChunkArray> chunks)
+: chunks{std::move(chunks)}
 , meshes{std::make_unique<Mesh<TerrainRenderer::Vertex>[]>(
-      sizes.x * sizes.y * sizes.z
+      this->chunks->chunk_count()
   )}
-, chunks_to_update(sizes.x * sizes.y * sizes.z)
+, chunks_to_update(this->chunks->chunk_count())
 , chunks_with_transparency{}
 , renderer{load_game_blocks_data(
       Terrain::BLOCK_DATA_PATH, Terrain::BLOCK_TEXTURE_DATA_PATH
@@ -41,23 +42,14 @@ Terrain::Terrain(glm::uvec3 sizes)
 , texture_atlas{Texture::from_image(
       load_png(Terrain::TEXTURE_ATLAS_PATH), TextureLoad::DEFAULT
   )} {
-    auto const n_meshes = sizes.x * sizes.y * sizes.z;
+    auto const n_meshes = this->chunks->chunk_count();
 
     for (usize i = 0; i < n_meshes; ++i) {
         this->chunks_to_update[i] = i;
     }
 
-#pragma omp parallel
-    for (auto [i, chunk] : this->chunks->get_span() | vs::enumerate) {
-        auto const any_voxel_is_transparent =
-            rg::any_of(chunk.get_voxels(), [this](auto voxel) {
-                return 0 != voxel.id &&
-                       this->renderer.data
-                           .get_block(voxel.id, voxel.orientation())
-                           .is_translucent();
-            });
-
-        if (any_voxel_is_transparent) {
+    for (auto [i, chunk] : this->chunks->as_span() | vs::enumerate) {
+        if (0 != this->renderer.count_translucent(chunk)) {
             this->chunks_with_transparency.push((usize) i);
         }
     }
@@ -65,48 +57,10 @@ Terrain::Terrain(glm::uvec3 sizes)
     this->generate_meshes(glm::vec3{0.0f});
 }
 
-static auto sort_transparent_triangles(
-    RefMut<TerrainRenderer::TransparentMesh> mesh, glm::vec3 camera_pos
-) -> void {
-    auto vertices = mesh->get_buffer().lock();
-
-    if (vertices.size() % 3 != 0) {
-        throw Panic("transparent mesh size should be divisible by 3");
-    }
-
-    struct Triangle {
-        std::array<TerrainRenderer::TransparentVertex, 3> vertices;
-    };
-
-    auto triangles = std::span<Triangle>{
-        reinterpret_cast<Triangle*>(vertices.begin()),
-        reinterpret_cast<Triangle*>(vertices.end())
-    };
-
-    auto manhattan_comparator =
-        [camera_pos](auto const& left, auto const& right) {
-            auto pos = 3.0f * camera_pos;
-
-            auto left_center = left.vertices[0].pos + left.vertices[1].pos +
-                               left.vertices[2].pos;
-            auto left_distance = glm::abs(pos.x - left_center.x) +
-                                 glm::abs(pos.y - left_center.y) +
-                                 glm::abs(pos.z - left_center.z);
-
-            auto right_center = right.vertices[0].pos + right.vertices[1].pos +
-                                right.vertices[2].pos;
-            auto right_distance = glm::abs(pos.x - right_center.x) +
-                                  glm::abs(pos.y - right_center.y) +
-                                  glm::abs(pos.z - right_center.z);
-
-            return left_distance > right_distance;
-        };
-
-    rg::sort(triangles, manhattan_comparator);
-}
-
 auto Terrain::generate_meshes(this Terrain& self, glm::vec3 camera_pos)
     -> void {
+    tmine_profile_zone("Terrain::generate_meshes");
+
     // remove duplicates from vector to prevent data race
     {
         dedup_vector(&self.chunks_to_update);
@@ -117,33 +71,52 @@ auto Terrain::generate_meshes(this Terrain& self, glm::vec3 camera_pos)
 
     self.transparent_mesh.get_buffer().clear();
 
+    metrics::add(Counter::ChunksRemeshed, self.chunks_to_update.size());
+
+    {
+        auto const timing = ScopedTiming{Timing::Meshing};
+
 #pragma omp parallel for
-    for (auto i : self.chunks_to_update) {
-        auto const pos = self.chunks->index_to_pos(i);
+        for (auto i : self.chunks_to_update) {
+            auto const pos = self.chunks->index_to_pos(i);
+
+            // Do not reload mesh buffer on multithread
+            self.renderer.render_opaque(
+                *self.chunks, pos, &self.meshes[i],
+                TerrainRenderUploadMesh::Skip
+            );
+        }
 
-        // Do not reload mesh buffer on multithread
-        self.renderer.render_opaque(
-            *self.chunks, pos, &self.meshes[i], TerrainRenderUploadMesh::Skip
-        );
+#pragma omp parallel for
+        for (auto i : self.chunks_with_transparency) {
+            auto const pos = self.chunks->index_to_pos(i);
+            auto const chunk = *self.chunks->chunk(pos);
+
+            self.renderer.render_transparent(
+                chunk, *self.chunks, &self.transparent_mesh.get_buffer(),
+                camera_pos
+            );
+        }
     }
 
-#pragma omp parallel for
-    for (auto i : self.chunks_with_transparency) {
-        auto const pos = self.chunks->index_to_pos(i);
-        auto const chunk = *self.chunks->chunk(pos);
+    {
+        auto const timing = ScopedTiming{Timing::TransparentSort};
+        auto vertices = self.transparent_mesh.get_buffer().lock();
 
-        self.renderer.render_transparent(
-            chunk, *self.chunks, &self.transparent_mesh, camera_pos
+        TerrainRenderer::sort_transparent_triangles(
+            vertices.as_span(), camera_pos
         );
     }
 
-    sort_transparent_triangles(&self.transparent_mesh, camera_pos);
+    {
+        auto const timing = ScopedTiming{Timing::Uploads};
 
-    self.transparent_mesh.reload_buffer();
+        self.transparent_mesh.reload_buffer();
 
-    // Reload buffers on main thread
-    for (auto i : self.chunks_to_update) {
-        self.meshes[i].reload_buffer();
+        // Reload buffers on main thread
+        for (auto i : self.chunks_to_update) {
+            self.meshes[i].reload_buffer();
+        }
     }
 
     self.chunks_to_update.clear();
@@ -158,6 +131,8 @@ auto Terrain::render(
 ) -> void {
     this->update(cam.get_pos());
 
+    auto const timing = ScopedTiming{Timing::DrawSubmission};
+
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_CULL_FACE);
 
@@ -211,67 +186,83 @@ auto Terrain::render_opaque(
     auto const n_chunks = self.chunks->chunk_count();
     auto model = glm::mat4{1.0f};
     auto meshes = std::span{self.meshes.get(), self.meshes.get() + n_chunks};
+    auto const frustum = Frustum::from_projection_view(
+        camera.get_projection(Window::aspect_ratio_of(viewport_size)) *
+        camera.get_view()
+    );
+    auto n_culled = usize{0};
 
     for (auto [chunk, mesh] : vs::zip(self.chunks->as_span(), meshes)) {
         auto const pos = chunk.get_pos();
         auto const offset =
             glm::vec3{pos} * glm::vec3{Chunk::SIZE} + glm::vec3{0.5f};
 
+        // Margin covers vertices sticking out of the chunk by half a voxel
+        auto const bounds = Aabb{
+            offset - glm::vec3{1.0f},
+            offset + glm::vec3{Chunk::SIZE} + glm::vec3{1.0f},
+        };
+
+        if (!frustum.intersects(bounds)) {
+            n_culled += 1;
+            continue;
+        }
+
         model = glm::translate(glm::mat4{1.0f}, offset);
 
         self.opaque_shader.uniform_mat4("model", model);
         mesh.draw();
     }
-}
-
-auto Terrain::set_voxel(this Terrain& self, glm::uvec3 pos, Voxel value)
-    -> void {
-    auto const chunk_pos = pos / Chunk::SIZE;
-    auto const local_pos = pos % Chunk::SIZE;
 
-    if (!self.chunks->is_in_bounds(chunk_pos) ||
-        !Chunk::is_in_bounds(local_pos))
-    {
-        return;
-    }
+    metrics::add(Counter::CulledChunks, n_culled);
+}
 
-    auto chunk_index = self.chunks->index_of(chunk_pos);
-    auto prev_voxel_id = self.chunks->get_voxel(pos).value();
+auto Terrain::is_translucent(this Terrain const& self, Voxel voxel) noexcept
+    -> bool {
+    return 0 != voxel.id &&
+           self.renderer.data.blocks[voxel.id][0].is_translucent();
+}
 
-    self.chunks->set_voxel(pos, value);
+auto Terrain::mark_chunk_edited(
+    this Terrain& self, glm::uvec3 chunk_pos, ChunkEdit const& edit
+) -> void {
+    auto const chunk_index = self.chunks->index_of(chunk_pos);
+    auto const chunk_offset = chunk_pos * Chunk::SIZE;
 
-    auto chunks_with_transparency = self.chunks_with_transparency.lock();
+    self.edited_boxes.push_back(Aabb{
+        glm::vec3{chunk_offset + edit.lo},
+        glm::vec3{chunk_offset + edit.hi + 1u},
+    });
 
-    // update `chunks_with_transparency` if user is removing transparent voxel
-    if (0 == value.id &&
-        self.renderer.data.blocks[prev_voxel_id.id][0].is_translucent())
     {
-        auto& chunk = *self.chunks->chunk(chunk_pos);
-        bool contains_translucent =
-            rg::any_of(chunk.get_voxels(), [&self](auto voxel) {
-                return 0 != voxel.id &&
-                       self.renderer.data.blocks[voxel.id][0].is_translucent();
-            });
-
-        // remove chunk which is transparent no more
-        if (!contains_translucent && !chunks_with_transparency.empty()) {
-            auto const iter =
-                rg::lower_bound(chunks_with_transparency, chunk_index);
-
-            if (iter != chunks_with_transparency.end() && *iter == chunk_index)
-            {
-                chunks_with_transparency.erase(iter, iter + 1);
+        auto chunks_with_transparency = self.chunks_with_transparency.lock();
+
+        // update `chunks_with_transparency` if user is removing transparent
+        // voxel
+        if (edit.removes_translucent && !edit.adds_translucent) {
+            auto const& chunk = *self.chunks->chunk(chunk_pos);
+            auto const contains_translucent =
+                0 != self.renderer.count_translucent(chunk);
+
+            // remove chunk which is transparent no more
+            if (!contains_translucent && !chunks_with_transparency.empty()) {
+                auto const iter =
+                    rg::lower_bound(chunks_with_transparency, chunk_index);
+
+                if (iter != chunks_with_transparency.end() &&
+                    *iter == chunk_index)
+                {
+                    chunks_with_transparency.erase(iter, iter + 1);
+                }
             }
         }
-    }
 
-    if (0 != value.id &&
-        self.renderer.data.blocks[value.id][0].is_translucent())
-    {
-        auto it = rg::lower_bound(chunks_with_transparency, chunk_index);
+        if (edit.adds_translucent) {
+            auto it = rg::lower_bound(chunks_with_transparency, chunk_index);
 
-        if (it == chunks_with_transparency.end() || *it != chunk_index) {
-            chunks_with_transparency.insert(it, chunk_index);
+            if (it == chunks_with_transparency.end() || *it != chunk_index) {
+                chunks_with_transparency.insert(it, chunk_index);
+            }
         }
     }
 
@@ -289,112 +280,128 @@ auto Terrain::set_voxel(this Terrain& self, glm::uvec3 pos, Voxel value)
 
     update_sorted(chunk_pos);
 
-    if (0 == local_pos.x && 0 != chunk_pos.x) {
+    if (0 == edit.lo.x && 0 != chunk_pos.x) {
         update_sorted(glm::uvec3(chunk_pos.x - 1, chunk_pos.y, chunk_pos.z));
     }
 
-    if (Chunk::WIDTH == local_pos.x + 1 && sizes.x != chunk_pos.x + 1) {
+    if (Chunk::WIDTH == edit.hi.x + 1 && sizes.x != chunk_pos.x + 1) {
         update_sorted(glm::uvec3(chunk_pos.x + 1, chunk_pos.y, chunk_pos.z));
     }
 
-    if (0 == local_pos.y && 0 != chunk_pos.y) {
+    if (0 == edit.lo.y && 0 != chunk_pos.y) {
         update_sorted(glm::uvec3(chunk_pos.x, chunk_pos.y - 1, chunk_pos.z));
     }
 
-    if (Chunk::HEIGHT == local_pos.y + 1 && sizes.y != chunk_pos.y + 1) {
+    if (Chunk::HEIGHT == edit.hi.y + 1 && sizes.y != chunk_pos.y + 1) {
         update_sorted(glm::uvec3(chunk_pos.x, chunk_pos.y + 1, chunk_pos.z));
     }
 
-    if (0 == local_pos.z && 0 != chunk_pos.z) {
+    if (0 == edit.lo.z && 0 != chunk_pos.z) {
         update_sorted(glm::uvec3(chunk_pos.x, chunk_pos.y, chunk_pos.z - 1));
     }
 
-    if (Chunk::DEPTH == local_pos.z + 1 && sizes.z != chunk_pos.z + 1) {
+    if (Chunk::DEPTH == edit.hi.z + 1 && sizes.z != chunk_pos.z + 1) {
         update_sorted(glm::uvec3(chunk_pos.x, chunk_pos.y, chunk_pos.z + 1));
     }
 }
 
-auto TerrainCollider::get_collidable_bounding_box() const -> Aabb {
-    return Aabb{
-        glm::vec3{0.0f},
-        glm::vec3{this->chunks->size() * Chunk::SIZE},
-    };
-}
+auto Terrain::set_voxel(this Terrain& self, glm::uvec3 pos, Voxel value)
+    -> void {
+    auto const chunk_pos = pos / Chunk::SIZE;
+    auto const local_pos = pos % Chunk::SIZE;
 
-auto TerrainCollider::collide(Collidable const& other) const -> Collision {
-    if (auto other_box = dynamic_cast<BoxCollider const*>(&other)) {
-        return this->collide_box(*other_box);
-    } else {
-        return Collision{};
+    if (!self.chunks->is_in_bounds(chunk_pos) ||
+        !Chunk::is_in_bounds(local_pos))
+    {
+        return;
     }
-}
-
-auto TerrainCollider::collide_box(
-    this TerrainCollider const& self, BoxCollider const& other
-) -> Collision {
-    auto const other_box = other.get_collidable_bounding_box();
-    auto const position_corrected_box = Aabb{
-        other_box.lo - glm::vec3{0.5f},
-        other_box.hi - glm::vec3{0.5f},
-    };
 
-    auto const lo = glm::uvec3{
-        glm::max(glm::vec3{0.0f}, glm::round(position_corrected_box.lo))
-    };
+    auto& chunk = *self.chunks->chunk(chunk_pos);
+    auto const prev_voxel = chunk.get_voxel_unchecked(local_pos);
 
-    auto const hi = glm::uvec3{
-        glm::max(glm::vec3{0.0f}, glm::round(position_corrected_box.hi))
-    };
+    chunk.set_voxel(local_pos, value);
 
-    debug::lines()->box(other_box, 0.8f * DebugColor::GREEN);
+    self.mark_chunk_edited(
+        chunk_pos, ChunkEdit{
+                       .lo = local_pos,
+                       .hi = local_pos,
+                       .removes_translucent = 0 == value.id &&
+                                              self.is_translucent(prev_voxel),
+                       .adds_translucent = self.is_translucent(value),
+                   }
+    );
+}
 
-    auto max_box = std::optional<Aabb>{};
+auto Terrain::mark_region_edited(
+    this Terrain& self, glm::uvec3 chunk_pos, glm::uvec3 lo, glm::uvec3 hi
+) -> void {
+    // Counts are kept per voxel id, so recounting is cheaper than tracking
+    // translucency of every written voxel
+    auto const has_translucent =
+        0 != self.renderer.count_translucent(*self.chunks->chunk(chunk_pos));
+
+    self.mark_chunk_edited(
+        chunk_pos, ChunkEdit{
+                       .lo = lo,
+                       .hi = hi,
+                       .removes_translucent = !has_translucent,
+                       .adds_translucent = has_translucent,
+                   }
+    );
+}
 
-    for (u32 x = lo.x; x <= hi.x; ++x) {
-        for (u32 y = lo.y; y <= hi.y; ++y) {
-            for (u32 z = lo.z; z <= hi.z; ++z) {
-                auto maybe_id = self.chunks->get_voxel({x, y, z});
+template <class F>
+auto Terrain::edit_region(
+    this Terrain& self, glm::uvec3 lo, glm::uvec3 hi, F&& voxel_at
+) -> void {
+    self.chunks->edit_region(
+        lo, hi, std::forward<F>(voxel_at),
+        [&self](
+            glm::uvec3 chunk_pos, glm::uvec3 local_lo, glm::uvec3 local_hi
+        ) { self.mark_region_edited(chunk_pos, local_lo, local_hi); }
+    );
+}
 
-                if (!maybe_id.has_value() || 0 == maybe_id.value().id) {
-                    continue;
-                }
+auto Terrain::fill_box(
+    this Terrain& self, glm::uvec3 lo, glm::uvec3 hi, Voxel value
+) -> void {
+    self.chunks->fill_box(
+        lo, hi, value,
+        [&self](
+            glm::uvec3 chunk_pos, glm::uvec3 local_lo, glm::uvec3 local_hi
+        ) { self.mark_region_edited(chunk_pos, local_lo, local_hi); }
+    );
+}
 
-                auto const lo = glm::vec3{x, y, z};
-                auto const box = Aabb{lo, lo + glm::vec3{1.0f}};
-                auto const intersection = other.box.intersection(box);
+auto Terrain::replace_in_sphere(
+    this Terrain& self, glm::uvec3 center, u32 radius, Voxel value
+) -> void {
+    auto const lo = glm::uvec3{
+        glm::max(glm::ivec3{center} - (i32) radius, glm::ivec3{0})
+    };
+    auto const hi = center + radius;
+    auto const radius_squared = (i32) (radius * radius);
 
-                if (intersection.is_empty()) {
-                    continue;
-                }
+    self.edit_region(lo, hi, [=](glm::uvec3 pos) -> std::optional<Voxel> {
+        auto const offset = glm::ivec3{pos} - glm::ivec3{center};
 
-                if (!max_box.has_value() ||
-                    max_box->intersection(other.box).volume() <
-                        intersection.volume())
-                {
-                    max_box.emplace(box);
-                }
-            }
+        if (glm::dot(offset, offset) > radius_squared) {
+            return std::nullopt;
         }
-    }
-
-    if (!max_box.has_value()) {
-        return Collision{};
-    }
-
-    debug::lines()->box(max_box.value(), 0.8f * DebugColor::BLUE);
 
-    auto const collider = BoxCollider{
-        max_box.value(), glm::vec3{0.0f},
-        glm::vec3{0.0f}, ABSOLUTELY_ELASTIC_ELASTICITY,
-        false,
-    };
-
-    auto const displacement = other.collide(collider).self_displacement;
+        return value;
+    });
+}
 
-    return Collision{
-        .self_displacement = glm::vec3{0.0f},
-        .other_displacement = displacement,
-    };
+auto Terrain::paste_structure(
+    this Terrain& self, VoxelStructure const& structure, glm::uvec3 pos
+) -> void {
+    self.chunks->paste_structure(
+        structure, pos,
+        [&self](
+            glm::uvec3 chunk_pos, glm::uvec3 local_lo, glm::uvec3 local_hi
+        ) { self.mark_region_edited(chunk_pos, local_lo, local_hi); }
+    );
 }
 
 }  // namespace tmine
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <algorithm>
+#include <compare>
 #include <vector>
 #include <memory>
 #include <glm/glm.hpp>
@@ -26,123 +28,277 @@ struct Collision {
     }
 };
 
+/// Motion of a box clipped against an obstacle, `is_blocked` marks axes
+/// along which the box has hit it.
+struct SweptMotion {
+    glm::vec3 displacement{0.0f};
+    glm::bvec3 is_blocked{false};
+};
+
 inline auto constexpr ABSOLUTELY_ELASTIC_ELASTICITY = 1.0f;
 inline auto constexpr ABSOLUTELY_INELASTIC_ELASTICITY = 0.0f;
 
-class Collidable {
+enum class ColliderKind : u8 {
+    Box,
+    Terrain,
+};
+
+/// Description of a box collider passed to the solver on registration.
+struct BoxCollider {
+    Aabb box{};
+    glm::vec3 velocity{0.0f};
+    glm::vec3 acceleration{0.0f};
+    f32 elasticity{ABSOLUTELY_ELASTIC_ELASTICITY};
+    bool is_dynamic{true};
+};
+
+class ChunkArray;
+
+/// Static collider made of all solid voxels of a chunk array.
+class TerrainCollider {
 public:
-    Collidable() = default;
-    virtual ~Collidable() = default;
+    explicit TerrainCollider(std::shared_ptr<ChunkArray> chunks);
+
+    auto get_bounding_box(this TerrainCollider const& self) -> Aabb;
 
-    inline Collidable(
-        glm::vec3 velocity, glm::vec3 acceleration = glm::vec3{0.0f},
-        f32 elasticity = ABSOLUTELY_ELASTIC_ELASTICITY, bool is_dynamic = true
-    )
-    : velocity{velocity}
-    , acceleration{acceleration}
-    , elasticity{elasticity}
-    , is_dynamic{is_dynamic} {}
+    /// Finds displacement pushing dynamic `box` out of the terrain, it is
+    /// stored in `other_displacement` of the result.
+    auto collide_box(this TerrainCollider const& self, Aabb box) -> Collision;
 
-    virtual auto get_collidable_bounding_box() const -> Aabb = 0;
-    virtual auto displace_collidable(glm::vec3 displacement) -> void = 0;
-    virtual auto collide(Collidable const& other) const -> Collision = 0;
+    /// Moves `box` axis by axis stopping it in front of the first solid
+    /// voxel on its way.
+    auto sweep_box(
+        this TerrainCollider const& self, Aabb box, glm::vec3 displacement
+    ) -> SweptMotion;
+
+private:
+    std::shared_ptr<ChunkArray> chunks;
+};
+
+/// Pushes `dynamic_box` out of `static_box` along the axis of the least
+/// penetration, the displacement is stored in `other_displacement`.
+auto collide_static_box(Aabb static_box, Aabb dynamic_box) -> Collision;
+
+class BoxColliderRef;
+
+class PhysicsSolver {
+    friend class BoxColliderRef;
+
+public:
+    PhysicsSolver() noexcept = default;
 
-    inline virtual auto get_collider_velocity() const -> glm::vec3 {
-        return this->velocity;
+    template <class T, typename... Args>
+    inline auto register_collidable(this PhysicsSolver& self, Args&&... args)
+        -> ColliderId {
+        return self.add(T{std::forward<Args>(args)...});
     }
 
-    inline virtual auto set_collider_velocity(glm::vec3 velocity) -> void {
-        this->velocity = velocity;
+    auto add(this PhysicsSolver& self, BoxCollider const& collider)
+        -> ColliderId;
+
+    auto add(this PhysicsSolver& self, TerrainCollider collider)
+        -> ColliderId;
+
+    /// Handle to the box collider with `id`. Ids are never reused, so the
+    /// handle stays valid for the whole life of the solver.
+    auto get_box_collider(this PhysicsSolver& self, ColliderId id)
+        -> BoxColliderRef;
+
+    inline auto collider_count(this PhysicsSolver const& self) noexcept
+        -> usize {
+        return self.kinds.size();
     }
 
-    inline virtual auto get_collider_acceleration() const -> glm::vec3 {
-        return this->acceleration;
+    inline auto is_sleeping(this PhysicsSolver const& self, ColliderId id)
+        -> bool {
+        return 0 != (self.flags[id.value] & PhysicsSolver::SLEEPING_FLAG);
     }
 
-    inline virtual auto set_collider_acceleration(glm::vec3 value) -> void {
-        this->acceleration = value;
+    /// Allows colliders at rest to fall asleep, which is on by default.
+    inline auto set_allow_sleeping(
+        this PhysicsSolver& self, bool value
+    ) noexcept -> void {
+        self.allow_sleeping = value;
     }
 
-    inline virtual auto collides(Collidable const& other) const -> bool {
-        return this->collide(other).exist();
+    /// Wakes up all sleeping colliders touching `region`, should be called
+    /// when something changes there, e.g. voxels get edited.
+    auto wake_in(this PhysicsSolver& self, Aabb region) -> void;
+
+    auto update(this PhysicsSolver& self, f32 time_step) -> void;
+
+private:
+    inline auto is_dynamic(this PhysicsSolver const& self, u32 index) noexcept
+        -> bool {
+        return 0 != (self.flags[index] & PhysicsSolver::DYNAMIC_FLAG);
     }
 
-    inline virtual auto is_collidable_dynamic() const -> bool {
-        return this->is_dynamic;
+    /// Checks that collider is dynamic and not sleeping.
+    inline auto is_awake(this PhysicsSolver const& self, u32 index) noexcept
+        -> bool {
+        return PhysicsSolver::DYNAMIC_FLAG == self.flags[index];
     }
 
-    inline virtual auto collidable_elasticity() const -> f32 {
-        return this->elasticity;
+    inline auto wake(this PhysicsSolver& self, u32 index) noexcept -> void {
+        self.flags[index] &= (u8) ~PhysicsSolver::SLEEPING_FLAG;
+        self.rest_tick_counts[index] = 0;
     }
 
-protected:
-    glm::vec3 velocity{};
-    glm::vec3 acceleration{};
-    f32 elasticity{ABSOLUTELY_ELASTIC_ELASTICITY};
-    bool is_dynamic{true};
-};
+    auto push_collider(
+        this PhysicsSolver& self, ColliderKind kind, u32 kind_index, Aabb box,
+        glm::vec3 velocity, glm::vec3 acceleration, f32 elasticity,
+        bool is_dynamic
+    ) -> ColliderId;
 
-class PhysicsSolver {
-public:
-    PhysicsSolver() noexcept = default;
+    auto integrate(this PhysicsSolver& self, f32 time_step) -> void;
 
-    template <std::derived_from<Collidable> T, typename... Args>
-    inline auto register_collidable(this PhysicsSolver& self, Args&&... args)
-        -> ColliderId {
-        auto const id = ColliderId{(u32) self.colliders.size()};
-        self.colliders.emplace_back(std::make_unique<T>(std::forward<Args>(args
-        )...));
+    /// Puts colliders that barely moved for `N_REST_TICKS_TO_SLEEP` ticks
+    /// to sleep.
+    auto update_sleeping(this PhysicsSolver& self, f32 time_step) -> void;
 
-        return id;
-    }
+    /// Fills `candidate_pairs` with pairs of colliders whose bounding boxes
+    /// overlap, ordered the same way as the all-pairs loop would visit them.
+    auto find_candidate_pairs(this PhysicsSolver& self) -> void;
 
-    template <std::derived_from<Collidable> T, class Self>
-    inline auto get_collidable(this Self&& self, ColliderId id)
-        -> decltype(auto) {
-        if (id >= self.colliders.size()) {
-            throw Panic("invalid collidable id {}", id.value);
-        }
+    /// Splits `candidate_pairs` into islands of colliders touching each
+    /// other. Islands share no dynamic colliders, so they can be solved in
+    /// parallel, and pairs of an island keep their relative order, so the
+    /// result does not depend on the number of threads.
+    auto find_islands(this PhysicsSolver& self) -> void;
 
-        auto result = dynamic_cast<T*>(self.colliders[(usize) id.value].get());
+    auto find_island_root(this PhysicsSolver& self, u32 index) noexcept -> u32;
 
-        if (nullptr == result) {
-            throw Panic(
-                "invalid type `{}` for collidable id {}", typeid(T).name(),
-                id.value
-            );
-        }
+    auto handle_collisions(this PhysicsSolver& self) -> bool;
 
-        return std::forward_like<Self>(*result);
-    }
+    auto handle_collision(this PhysicsSolver& self, u32 first, u32 second)
+        -> bool;
 
-    auto update(this PhysicsSolver& self, f32 time_step) -> void;
+    /// Narrow phase, dispatches on kinds of both colliders.
+    auto collide(this PhysicsSolver const& self, u32 first, u32 second)
+        -> Collision;
+
+    auto displace(this PhysicsSolver& self, u32 first, u32 second) -> bool;
+
+    auto static_binary_displace(
+        this PhysicsSolver& self, u32 static_index, u32 dynamic_index
+    ) -> bool;
 
 private:
-    std::vector<std::unique_ptr<Collidable>> colliders{};
+    struct ColliderPair {
+        u32 first;
+        u32 second;
+
+        inline auto constexpr operator<=>(ColliderPair const&) const = default;
+    };
+
+    // Colliders are stored component-wise, index of a collider is its id
+    std::vector<ColliderKind> kinds{};
+    std::vector<u32> kind_indices{};
+    std::vector<Aabb> boxes{};
+    std::vector<glm::vec3> velocities{};
+    std::vector<glm::vec3> accelerations{};
+    std::vector<f32> elasticities{};
+    std::vector<u8> flags{};
+    std::vector<u16> rest_tick_counts{};
+
+    std::vector<TerrainCollider> terrains{};
+
+    /// Positions of colliders at the beginning of the current tick.
+    std::vector<glm::vec3> tick_start_positions{};
 
+    /// Displacements of colliders during integration step.
+    std::vector<glm::vec3> displacements{};
+
+    /// Bounding boxes of all colliders cached once per collision pass.
+    std::vector<Aabb> pass_boxes{};
+
+    /// Indices of colliders sorted by the lower `x` of their boxes. The order
+    /// is kept between passes so re-sorting it is almost linear.
+    std::vector<u32> sweep_order{};
+
+    std::vector<ColliderPair> candidate_pairs{};
+
+    /// Union-find forest over colliders used to build islands.
+    std::vector<u32> island_parents{};
+    std::vector<u32> island_indices{};
+    std::vector<u32> pair_islands{};
+
+    /// Pairs of island `i` are `island_pairs[island_offsets[i]..
+    /// island_offsets[i + 1]]`.
+    std::vector<u32> island_offsets{};
+    std::vector<ColliderPair> island_pairs{};
+
+    bool allow_sleeping{true};
+
+    /// Indices of terrain colliders used to clip motion of dynamic ones.
+    std::vector<u32> obstacles{};
+
+    static auto constexpr DYNAMIC_FLAG = u8{1};
+    static auto constexpr SLEEPING_FLAG = u8{2};
     static auto constexpr MAX_N_DISPLACE_STEPS = usize{20};
+
+    /// Collider moving slower than this is considered resting.
+    static auto constexpr SLEEP_SPEED = 0.05f;
+    static auto constexpr N_REST_TICKS_TO_SLEEP = u16{30};
+
+    /// Distance around a woken region in which sleeping colliders wake up,
+    /// so that colliders lying on top of an edited voxel are woken too.
+    static auto constexpr WAKE_MARGIN = 1.0f;
+
+    static auto constexpr MIN_PARALLEL_ISLANDS = usize{64};
+    static auto constexpr MIN_PARALLEL_COLLIDERS = usize{1024};
+    static auto constexpr NO_ISLAND = ~u32{0};
 };
 
-struct BoxCollider : public Collidable {
-    using Super = Collidable;
+/// Reference to a box collider stored in `PhysicsSolver`.
+class BoxColliderRef {
+public:
+    inline BoxColliderRef(RefMut<PhysicsSolver> solver, ColliderId id) noexcept
+    : solver{solver}
+    , index{id.value} {}
+
+    inline auto get_box(this BoxColliderRef self) noexcept -> Aabb {
+        return self.solver->boxes[self.index];
+    }
+
+    inline auto set_box(this BoxColliderRef self, Aabb value) noexcept
+        -> void {
+        self.solver->wake(self.index);
+        self.solver->boxes[self.index] = value;
+    }
+
+    inline auto get_velocity(this BoxColliderRef self) noexcept -> glm::vec3 {
+        return self.solver->velocities[self.index];
+    }
+
+    inline auto set_velocity(
+        this BoxColliderRef self, glm::vec3 value
+    ) noexcept -> void {
+        if (value != self.solver->velocities[self.index]) {
+            self.solver->wake(self.index);
+        }
 
-    Aabb box;
+        self.solver->velocities[self.index] = value;
+    }
 
-    inline BoxCollider(
-        Aabb box = Aabb{}, glm::vec3 velocity = glm::vec3{0.0f},
-        glm::vec3 acceleration = glm::vec3{0.0f},
-        f32 elasticity = ABSOLUTELY_ELASTIC_ELASTICITY, bool is_dynamic = true
-    )
-    : Super{velocity, acceleration, elasticity, is_dynamic}
-    , box{box} {}
+    inline auto get_acceleration(this BoxColliderRef self) noexcept
+        -> glm::vec3 {
+        return self.solver->accelerations[self.index];
+    }
 
-    inline auto get_collidable_bounding_box() const -> Aabb override {
-        return this->box;
+    inline auto set_acceleration(
+        this BoxColliderRef self, glm::vec3 value
+    ) noexcept -> void {
+        if (value != self.solver->accelerations[self.index]) {
+            self.solver->wake(self.index);
+        }
+
+        self.solver->accelerations[self.index] = value;
     }
 
-    auto displace_collidable(glm::vec3 displacement) -> void override;
-    auto collides(Collidable const& other) const -> bool override;
-    auto collide(Collidable const& other) const -> Collision override;
+private:
+    PhysicsSolver* solver;
+    u32 index;
 };
 
 struct AnimationDynamicsParams {
@@ -167,8 +323,16 @@ struct AnimationDynamicsParams {
     ) -> void {
         auto const coefficients = self.coefficients();
 
+        // Clamping the second coefficient keeps the integration stable for
+        // time steps comparable to the period of the system.
+        auto const stable_coefficient = std::max({
+            coefficients.y,
+            0.5f * time_step * time_step + 0.5f * time_step * coefficients.x,
+            time_step * coefficients.x,
+        });
+
         *y += time_step * *dydt;
-        *dydt += time_step / coefficients.y *
+        *dydt += time_step / stable_coefficient *
                  (x + coefficients.z * dxdt - *y - coefficients.x * *dydt);
     }
 };
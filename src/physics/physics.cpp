@@ -1,5 +1,7 @@
+#include <algorithm>
+
 #include "../physics.hpp"
-#include <span>
+#include "../profiler.hpp"
 
 namespace tmine {
 
@@ -10,10 +12,169 @@ static auto project(glm::vec3 source, glm::vec3 direction) -> glm::vec3 {
     return factor * direction;
 }
 
-static auto displace(
-    RefMut<Collidable> first_collider, RefMut<Collidable> second_collider
-) -> bool {
-    auto const collision = first_collider->collide(*second_collider);
+static auto collide_dynamic_box(Aabb self, Aabb other) -> Collision {
+    auto const intersection = self.intersection(other);
+
+    if (intersection.is_empty()) {
+        return Collision{};
+    }
+
+    auto const size = intersection.hi - intersection.lo;
+    auto const self_center = self.center();
+    auto const other_center = other.center();
+    auto const to_other_center = other_center - self_center;
+    auto const self_volume = self.volume();
+    auto const other_volume = other.volume();
+    auto const total_volume = self_volume + other_volume;
+    auto const signs = glm::sign(to_other_center);
+
+    if (size.x <= size.y && size.x <= size.z) {
+        return Collision{
+            -signs.x *
+                glm::vec3(size.x * other_volume / total_volume, 0.0f, 0.0f),
+            signs.x * glm::vec3(size.x * self_volume / total_volume, 0.0f, 0.0f)
+        };
+    } else if (size.y <= size.x && size.y <= size.z) {
+        return Collision{
+            -signs.y *
+                glm::vec3(0.0f, size.y * other_volume / total_volume, 0.0f),
+            signs.y * glm::vec3(0.0f, size.y * self_volume / total_volume, 0.0f)
+        };
+    } else {
+        return Collision{
+            -signs.z *
+                glm::vec3(0.0f, 0.0f, size.z * other_volume / total_volume),
+            signs.z * glm::vec3(0.0f, 0.0f, size.z * self_volume / total_volume)
+        };
+    }
+}
+
+auto collide_static_box(Aabb static_box, Aabb dynamic_box) -> Collision {
+    auto const intersection = static_box.intersection(dynamic_box);
+
+    if (intersection.is_empty()) {
+        return Collision{};
+    }
+
+    auto const size = intersection.hi - intersection.lo;
+    auto const static_center = static_box.center();
+    auto const dynamic_center = dynamic_box.center();
+    auto const signs = glm::sign(dynamic_center - static_center);
+
+    auto displacement = glm::vec3{0.0f};
+
+    if (size.x <= size.y && size.x <= size.z) {
+        displacement.x = signs.x * size.x;
+    } else if (size.z <= size.x && size.z <= size.y) {
+        displacement.z = signs.z * size.z;
+    } else {
+        displacement.y = signs.y * size.y;
+    }
+
+    return Collision{glm::vec3{0.0f}, displacement};
+}
+
+static auto swapped(Collision collision) -> Collision {
+    std::swap(collision.self_displacement, collision.other_displacement);
+    return collision;
+}
+
+auto PhysicsSolver::push_collider(
+    this PhysicsSolver& self, ColliderKind kind, u32 kind_index, Aabb box,
+    glm::vec3 velocity, glm::vec3 acceleration, f32 elasticity,
+    bool is_dynamic
+) -> ColliderId {
+    auto const id = ColliderId{(u32) self.kinds.size()};
+
+    self.kinds.push_back(kind);
+    self.kind_indices.push_back(kind_index);
+    self.boxes.push_back(box);
+    self.velocities.push_back(velocity);
+    self.accelerations.push_back(acceleration);
+    self.elasticities.push_back(elasticity);
+    self.flags.push_back(is_dynamic ? PhysicsSolver::DYNAMIC_FLAG : u8{0});
+    self.rest_tick_counts.push_back(0);
+
+    return id;
+}
+
+auto PhysicsSolver::add(this PhysicsSolver& self, BoxCollider const& collider)
+    -> ColliderId {
+    return self.push_collider(
+        ColliderKind::Box, 0, collider.box, collider.velocity,
+        collider.acceleration, collider.elasticity, collider.is_dynamic
+    );
+}
+
+auto PhysicsSolver::add(this PhysicsSolver& self, TerrainCollider collider)
+    -> ColliderId {
+    auto const kind_index = (u32) self.terrains.size();
+    auto const box = collider.get_bounding_box();
+
+    self.terrains.emplace_back(std::move(collider));
+
+    return self.push_collider(
+        ColliderKind::Terrain, kind_index, box, glm::vec3{0.0f},
+        glm::vec3{0.0f}, ABSOLUTELY_ELASTIC_ELASTICITY, false
+    );
+}
+
+auto PhysicsSolver::get_box_collider(this PhysicsSolver& self, ColliderId id)
+    -> BoxColliderRef {
+    if (id.value >= self.kinds.size()) {
+        throw Panic("invalid collidable id {}", id.value);
+    }
+
+    if (ColliderKind::Box != self.kinds[id.value]) {
+        throw Panic("collidable with id {} is not a box", id.value);
+    }
+
+    return BoxColliderRef{&self, id};
+}
+
+auto PhysicsSolver::collide(
+    this PhysicsSolver const& self, u32 first, u32 second
+) -> Collision {
+    auto const first_kind = self.kinds[first];
+    auto const second_kind = self.kinds[second];
+    auto const first_is_dynamic = self.is_dynamic(first);
+    auto const second_is_dynamic = self.is_dynamic(second);
+
+    if (ColliderKind::Box == first_kind && ColliderKind::Box == second_kind) {
+        auto const first_box = self.boxes[first];
+        auto const second_box = self.boxes[second];
+
+        if (first_is_dynamic && second_is_dynamic) {
+            return collide_dynamic_box(first_box, second_box);
+        } else if (!first_is_dynamic && second_is_dynamic) {
+            return collide_static_box(first_box, second_box);
+        } else if (first_is_dynamic && !second_is_dynamic) {
+            return swapped(collide_static_box(second_box, first_box));
+        } else {
+            return Collision{};
+        }
+    }
+
+    if (ColliderKind::Box == first_kind &&
+        ColliderKind::Terrain == second_kind && first_is_dynamic)
+    {
+        auto const& terrain = self.terrains[self.kind_indices[second]];
+        return swapped(terrain.collide_box(self.boxes[first]));
+    }
+
+    if (ColliderKind::Terrain == first_kind &&
+        ColliderKind::Box == second_kind && second_is_dynamic)
+    {
+        auto const& terrain = self.terrains[self.kind_indices[first]];
+        return terrain.collide_box(self.boxes[second]);
+    }
+
+    return Collision{};
+}
+
+auto PhysicsSolver::displace(this PhysicsSolver& self, u32 first, u32 second)
+    -> bool {
+    auto const collision = self.collide(first, second);
 
     if (!collision.exist()) {
         return false;
@@ -22,13 +183,13 @@ static auto displace(
     auto const first_displacement = collision.self_displacement;
     auto const second_displacement = collision.other_displacement;
 
-    first_collider->displace_collidable(first_displacement);
-    second_collider->displace_collidable(second_displacement);
+    self.boxes[first].lo += first_displacement;
+    self.boxes[first].hi += first_displacement;
+    self.boxes[second].lo += second_displacement;
+    self.boxes[second].hi += second_displacement;
 
-    auto const elacticity = glm::min(
-        first_collider->collidable_elasticity(),
-        second_collider->collidable_elasticity()
-    );
+    auto const elacticity =
+        glm::min(self.elasticities[first], self.elasticities[second]);
 
     auto elastic_collision_velocity =
         [](f32 first_mass, f32 second_mass, glm::vec3 first_velocity,
@@ -38,18 +199,16 @@ static auto displace(
                (first_mass + second_mass);
     };
 
-    auto const first_velocity = first_collider->get_collider_velocity();
+    auto const first_velocity = self.velocities[first];
     auto const first_parallel_velocity =
         project(first_velocity, first_displacement);
 
-    auto const second_velocity = second_collider->get_collider_velocity();
+    auto const second_velocity = self.velocities[second];
     auto const second_parallel_velocity =
         project(second_velocity, second_displacement);
 
-    auto const first_mass =
-        first_collider->get_collidable_bounding_box().volume();
-    auto const second_mass =
-        second_collider->get_collidable_bounding_box().volume();
+    auto const first_mass = self.boxes[first].volume();
+    auto const second_mass = self.boxes[second].volume();
 
     auto const first_new_velocity =
         first_velocity + (1.0f + elacticity) * elastic_collision_velocity(
@@ -65,16 +224,16 @@ static auto displace(
                                                     first_parallel_velocity
                                                 );
 
-    first_collider->set_collider_velocity(first_new_velocity);
-    second_collider->set_collider_velocity(second_new_velocity);
+    self.velocities[first] = first_new_velocity;
+    self.velocities[second] = second_new_velocity;
 
     return true;
 }
 
-static auto static_binary_displace(
-    RefMut<Collidable> static_collider, RefMut<Collidable> dynamic_collider
+auto PhysicsSolver::static_binary_displace(
+    this PhysicsSolver& self, u32 static_index, u32 dynamic_index
 ) -> bool {
-    auto const collision = dynamic_collider->collide(*static_collider);
+    auto const collision = self.collide(dynamic_index, static_index);
 
     if (!collision.exist()) {
         return false;
@@ -82,200 +241,361 @@ static auto static_binary_displace(
 
     auto const displacement = collision.self_displacement;
 
-    dynamic_collider->displace_collidable(displacement);
+    self.boxes[dynamic_index].lo += displacement;
+    self.boxes[dynamic_index].hi += displacement;
 
     auto const elacticity = glm::min(
-        dynamic_collider->collidable_elasticity(),
-        static_collider->collidable_elasticity()
+        self.elasticities[dynamic_index], self.elasticities[static_index]
     );
-    auto const velocity = dynamic_collider->get_collider_velocity();
+    auto const velocity = self.velocities[dynamic_index];
     auto const parallel_velocity = project(velocity, displacement);
     auto const new_velocity =
         velocity - (1.0f + elacticity) * parallel_velocity;
 
-    dynamic_collider->set_collider_velocity(new_velocity);
+    self.velocities[dynamic_index] = new_velocity;
 
     return true;
 }
 
-static auto handle_collision(
-    RefMut<Collidable> first, RefMut<Collidable> second, Aabb first_box,
-    Aabb second_box
+auto PhysicsSolver::handle_collision(
+    this PhysicsSolver& self, u32 first, u32 second
 ) -> bool {
-    auto first_is_dynamic = first->is_collidable_dynamic();
-    auto second_is_dynamic = second->is_collidable_dynamic();
+    auto first_is_dynamic = self.is_dynamic(first);
+    auto second_is_dynamic = self.is_dynamic(second);
 
-    if (!first_is_dynamic && !second_is_dynamic) {
+    if (!self.is_awake(first) && !self.is_awake(second)) {
         return false;
     }
 
-    auto const intersection_box = first_box.intersection(second_box);
+    auto const intersection_box =
+        self.pass_boxes[first].intersection(self.pass_boxes[second]);
 
     if (intersection_box.is_empty()) {
         return false;
     }
 
+    // Contact with an awake collider wakes a sleeping one, but its rest
+    // counter is kept, so a resting stack falls asleep again at once instead
+    // of waking itself up forever. Static colliders are shared between
+    // islands, so they are never written to
+    if (first_is_dynamic) {
+        self.flags[first] &= (u8) ~PhysicsSolver::SLEEPING_FLAG;
+    }
+
+    if (second_is_dynamic) {
+        self.flags[second] &= (u8) ~PhysicsSolver::SLEEPING_FLAG;
+    }
+
     if (first_is_dynamic && second_is_dynamic) {
-        return displace(first, second);
+        return self.displace(first, second);
     } else if (!first_is_dynamic && second_is_dynamic) {
-        return static_binary_displace(first, second);
+        return self.static_binary_displace(first, second);
     } else if (first_is_dynamic && !second_is_dynamic) {
-        return static_binary_displace(second, first);
+        return self.static_binary_displace(second, first);
     } else {
         return false;
     }
 }
 
-static auto handle_collisions(
-    std::span<std::unique_ptr<Collidable>> collidables
-) -> bool {
+auto PhysicsSolver::find_candidate_pairs(this PhysicsSolver& self) -> void {
+    auto const n_colliders = self.kinds.size();
+
+    self.pass_boxes = self.boxes;
+
+    for (auto i = (u32) self.sweep_order.size(); i < n_colliders; ++i) {
+        self.sweep_order.push_back(i);
+    }
+
+    // Boxes barely move between passes, so insertion sort is almost linear
+    for (usize i = 1; i < self.sweep_order.size(); ++i) {
+        auto const index = self.sweep_order[i];
+        auto const lo = self.pass_boxes[index].lo.x;
+        auto j = i;
+
+        for (; j > 0 && self.pass_boxes[self.sweep_order[j - 1]].lo.x > lo;
+             --j)
+        {
+            self.sweep_order[j] = self.sweep_order[j - 1];
+        }
+
+        self.sweep_order[j] = index;
+    }
+
+    self.candidate_pairs.clear();
+
+    for (usize i = 0; i < self.sweep_order.size(); ++i) {
+        auto const first = self.sweep_order[i];
+        auto const& first_box = self.pass_boxes[first];
+        auto const first_is_awake = self.is_awake(first);
+
+        for (usize j = i + 1; j < self.sweep_order.size(); ++j) {
+            auto const second = self.sweep_order[j];
+            auto const& second_box = self.pass_boxes[second];
+
+            if (second_box.lo.x > first_box.hi.x) {
+                break;
+            }
+
+            if (!first_is_awake && !self.is_awake(second)) {
+                continue;
+            }
+
+            if (second_box.lo.y > first_box.hi.y ||
+                first_box.lo.y > second_box.hi.y ||
+                second_box.lo.z > first_box.hi.z ||
+                first_box.lo.z > second_box.hi.z)
+            {
+                continue;
+            }
+
+            self.candidate_pairs.push_back(ColliderPair{
+                .first = std::min(first, second),
+                .second = std::max(first, second),
+            });
+        }
+    }
+
+    // Keep the order in which pairs were resolved before broadphase existed
+    std::ranges::sort(self.candidate_pairs);
+}
+
+auto PhysicsSolver::handle_collisions(this PhysicsSolver& self) -> bool {
     auto do_any_collide = false;
 
-    for (usize i = 0; i < collidables.size(); ++i) {
-        auto& first_collider = collidables[i];
-        auto const first_box = first_collider->get_collidable_bounding_box();
+    self.find_candidate_pairs();
+    self.find_islands();
+
+    auto const n_islands = self.island_offsets.size() - 1;
 
-        for (usize j = i + 1; j < collidables.size(); ++j) {
-            auto& second_collider = collidables[j];
-            auto const second_box =
-                second_collider->get_collidable_bounding_box();
+#pragma omp parallel for schedule(dynamic) \
+    if (n_islands >= PhysicsSolver::MIN_PARALLEL_ISLANDS)
+    for (usize i = 0; i < n_islands; ++i) {
+        auto const start = self.island_offsets[i];
+        auto const end = self.island_offsets[i + 1];
 
-            handle_collision(
-                first_collider.get(), second_collider.get(), first_box,
-                second_box
-            );
+        for (auto j = start; j < end; ++j) {
+            auto const [first, second] = self.island_pairs[j];
+            self.handle_collision(first, second);
         }
     }
 
     return do_any_collide;
 }
 
-auto PhysicsSolver::update(this PhysicsSolver& self, f32 time_step)
-    -> void {
-    for (auto& collider : self.colliders) {
-        if (!collider->is_collidable_dynamic()) {
+auto PhysicsSolver::find_island_root(
+    this PhysicsSolver& self, u32 index
+) noexcept -> u32 {
+    auto& parents = self.island_parents;
+
+    while (parents[index] != index) {
+        parents[index] = parents[parents[index]];
+        index = parents[index];
+    }
+
+    return index;
+}
+
+auto PhysicsSolver::find_islands(this PhysicsSolver& self) -> void {
+    auto const n_colliders = (u32) self.kinds.size();
+
+    self.island_parents.resize(n_colliders);
+
+    for (u32 i = 0; i < n_colliders; ++i) {
+        self.island_parents[i] = i;
+    }
+
+    // Static colliders are only read while solving, so they do not join
+    // islands together
+    for (auto const [first, second] : self.candidate_pairs) {
+        if (!self.is_dynamic(first) || !self.is_dynamic(second)) {
             continue;
         }
 
-        auto const acceleration = collider->get_collider_acceleration();
-        auto const velocity =
-            time_step * acceleration + collider->get_collider_velocity();
-        auto const displacement = time_step * velocity;
+        auto const first_root = self.find_island_root(first);
+        auto const second_root = self.find_island_root(second);
 
-        collider->displace_collidable(displacement);
-        collider->set_collider_velocity(velocity);
+        // Lower index becomes the root to keep islands independent of the
+        // order of unions
+        self.island_parents[std::max(first_root, second_root)] =
+            std::min(first_root, second_root);
     }
 
-    for (usize i = 0; i < MAX_N_DISPLACE_STEPS; ++i) {
-        if (!handle_collisions(self.colliders)) {
-            break;
+    self.island_indices.assign(n_colliders, PhysicsSolver::NO_ISLAND);
+    self.pair_islands.resize(self.candidate_pairs.size());
+
+    auto n_islands = u32{0};
+
+    for (usize i = 0; i < self.candidate_pairs.size(); ++i) {
+        auto const [first, second] = self.candidate_pairs[i];
+        auto const owner = self.is_dynamic(first) ? first : second;
+        auto const root = self.find_island_root(owner);
+
+        if (PhysicsSolver::NO_ISLAND == self.island_indices[root]) {
+            self.island_indices[root] = n_islands++;
         }
+
+        self.pair_islands[i] = self.island_indices[root];
     }
-}
 
-auto BoxCollider::displace_collidable(glm::vec3 displacement) -> void {
-    this->box.lo += displacement;
-    this->box.hi += displacement;
-}
+    // Stable counting sort of pairs by their islands
+    self.island_offsets.assign(n_islands + 1, 0);
 
-auto BoxCollider::collides(Collidable const& other) const -> bool {
-    if (auto box_collider = dynamic_cast<BoxCollider const*>(&other)) {
-        return !this->box.intersection(box_collider->box).is_empty();
-    } else {
-        return other.collides(*this);
+    for (auto const island : self.pair_islands) {
+        ++self.island_offsets[island + 1];
+    }
+
+    for (u32 i = 0; i < n_islands; ++i) {
+        self.island_offsets[i + 1] += self.island_offsets[i];
     }
+
+    self.island_pairs.resize(self.candidate_pairs.size());
+
+    // Offsets are used as write cursors and shifted back afterwards
+    for (usize i = 0; i < self.candidate_pairs.size(); ++i) {
+        auto& offset = self.island_offsets[self.pair_islands[i]];
+        self.island_pairs[offset++] = self.candidate_pairs[i];
+    }
+
+    for (auto i = n_islands; i > 0; --i) {
+        self.island_offsets[i] = self.island_offsets[i - 1];
+    }
+
+    self.island_offsets[0] = 0;
 }
 
-static auto collide_dynamic_box(
-    BoxCollider const& self, BoxCollider const& other
-) -> Collision {
-    auto const intersection = self.box.intersection(other.box);
+auto PhysicsSolver::integrate(this PhysicsSolver& self, f32 time_step)
+    -> void {
+    auto const n_colliders = self.kinds.size();
 
-    if (intersection.is_empty()) {
-        return Collision{};
+    self.displacements.resize(n_colliders);
+
+    for (usize i = 0; i < n_colliders; ++i) {
+        auto const mask = (f32) self.is_awake((u32) i);
+
+        self.velocities[i] += mask * (time_step * self.accelerations[i]);
+        self.displacements[i] = mask * (time_step * self.velocities[i]);
     }
 
-    auto const size = intersection.hi - intersection.lo;
-    auto const self_center = self.box.center();
-    auto const other_center = other.box.center();
-    auto const to_other_center = other_center - self_center;
-    auto const self_volume = self.box.volume();
-    auto const other_volume = other.box.volume();
-    auto const total_volume = self_volume + other_volume;
-    auto const signs = glm::sign(to_other_center);
+    self.obstacles.clear();
 
-    if (size.x <= size.y && size.x <= size.z) {
-        return Collision{
-            -signs.x *
-                glm::vec3(size.x * other_volume / total_volume, 0.0f, 0.0f),
-            signs.x * glm::vec3(size.x * self_volume / total_volume, 0.0f, 0.0f)
-        };
-    } else if (size.y <= size.x && size.y <= size.z) {
-        return Collision{
-            -signs.y *
-                glm::vec3(0.0f, size.y * other_volume / total_volume, 0.0f),
-            signs.y * glm::vec3(0.0f, size.y * self_volume / total_volume, 0.0f)
-        };
-    } else {
-        return Collision{
-            -signs.z *
-                glm::vec3(0.0f, 0.0f, size.z * other_volume / total_volume),
-            signs.z * glm::vec3(0.0f, 0.0f, size.z * self_volume / total_volume)
-        };
+    for (usize i = 0; i < n_colliders; ++i) {
+        if (ColliderKind::Terrain == self.kinds[i]) {
+            self.obstacles.push_back((u32) i);
+        }
     }
-}
 
-static auto collide_static_box(
-    BoxCollider const& static_box, BoxCollider const& dynamic_box
-) -> Collision {
-    auto const intersection = static_box.box.intersection(dynamic_box.box);
+    if (!self.obstacles.empty()) {
+#pragma omp parallel for schedule(static) \
+    if (n_colliders >= PhysicsSolver::MIN_PARALLEL_COLLIDERS)
+        for (usize i = 0; i < n_colliders; ++i) {
+            if (!self.is_awake((u32) i)) {
+                continue;
+            }
+
+            for (auto const index : self.obstacles) {
+                auto const& terrain = self.terrains[self.kind_indices[index]];
+                auto const motion =
+                    terrain.sweep_box(self.boxes[i], self.displacements[i]);
+
+                if (!glm::any(motion.is_blocked)) {
+                    continue;
+                }
+
+                auto const elasticity =
+                    glm::min(self.elasticities[i], self.elasticities[index]);
+
+                for (i32 axis = 0; axis < 3; ++axis) {
+                    if (motion.is_blocked[axis]) {
+                        self.velocities[i][axis] *= -elasticity;
+                    }
+                }
+
+                self.displacements[i] = motion.displacement;
+            }
+        }
+    }
 
-    if (intersection.is_empty()) {
-        return Collision{};
+    for (usize i = 0; i < n_colliders; ++i) {
+        self.boxes[i].lo += self.displacements[i];
+        self.boxes[i].hi += self.displacements[i];
     }
+}
 
-    auto const size = intersection.hi - intersection.lo;
-    auto const static_center = static_box.box.center();
-    auto const dynamic_center = dynamic_box.box.center();
-    auto const signs = glm::sign(dynamic_center - static_center);
+auto PhysicsSolver::update_sleeping(this PhysicsSolver& self, f32 time_step)
+    -> void {
+    if (!self.allow_sleeping) {
+        return;
+    }
 
-    auto displacement = glm::vec3{0.0f};
+    auto const max_rest_distance = PhysicsSolver::SLEEP_SPEED * time_step;
 
-    if (size.x <= size.y && size.x <= size.z) {
-        displacement.x = signs.x * size.x;
-    } else if (size.z <= size.x && size.z <= size.y) {
-        displacement.z = signs.z * size.z;
-    } else {
-        displacement.y = signs.y * size.y;
+    for (usize i = 0; i < self.kinds.size(); ++i) {
+        if (!self.is_awake((u32) i)) {
+            continue;
+        }
+
+        auto const motion = self.boxes[i].lo - self.tick_start_positions[i];
+
+        if (glm::dot(motion, motion) > max_rest_distance * max_rest_distance)
+        {
+            self.rest_tick_counts[i] = 0;
+            continue;
+        }
+
+        if (self.rest_tick_counts[i] < PhysicsSolver::N_REST_TICKS_TO_SLEEP) {
+            ++self.rest_tick_counts[i];
+            continue;
+        }
+
+        self.flags[i] |= PhysicsSolver::SLEEPING_FLAG;
+        self.velocities[i] = glm::vec3{0.0f};
     }
+}
 
-    return Collision{glm::vec3{0.0f}, displacement};
+auto PhysicsSolver::wake_in(this PhysicsSolver& self, Aabb region) -> void {
+    auto const lo = region.lo - PhysicsSolver::WAKE_MARGIN;
+    auto const hi = region.hi + PhysicsSolver::WAKE_MARGIN;
+
+    for (usize i = 0; i < self.kinds.size(); ++i) {
+        auto const& box = self.boxes[i];
+
+        if (glm::all(glm::lessThanEqual(lo, box.hi)) &&
+            glm::all(glm::lessThanEqual(box.lo, hi)))
+        {
+            self.wake((u32) i);
+        }
+    }
 }
 
-auto BoxCollider::collide(Collidable const& other_collider) const -> Collision {
-    auto other = dynamic_cast<BoxCollider const*>(&other_collider);
+auto PhysicsSolver::update(this PhysicsSolver& self, f32 time_step)
+    -> void {
+    tmine_profile_zone("PhysicsSolver::update");
+
+    // Idle world of sleeping colliders costs a single scan over flags
+    auto const has_awake_colliders =
+        std::ranges::any_of(self.flags, [](u8 flags) {
+            return PhysicsSolver::DYNAMIC_FLAG == flags;
+        });
 
-    if (nullptr == other) {
-        auto collision = other_collider.collide(*this);
-        std::swap(collision.self_displacement, collision.other_displacement);
-        return collision;
+    if (!has_awake_colliders) {
+        return;
     }
 
-    auto const self_is_dynamic = this->is_collidable_dynamic();
-    auto const other_is_dynamic = other->is_collidable_dynamic();
+    self.tick_start_positions.resize(self.kinds.size());
 
-    auto collision = Collision{};
+    for (usize i = 0; i < self.kinds.size(); ++i) {
+        self.tick_start_positions[i] = self.boxes[i].lo;
+    }
+
+    self.integrate(time_step);
 
-    if (self_is_dynamic && other_is_dynamic) {
-        collision = collide_dynamic_box(*this, *other);
-    } else if (!self_is_dynamic && other_is_dynamic) {
-        collision = collide_static_box(*this, *other);
-    } else if (self_is_dynamic && !other_is_dynamic) {
-        collision = collide_static_box(*other, *this);
-        std::swap(collision.self_displacement, collision.other_displacement);
+    for (usize i = 0; i < MAX_N_DISPLACE_STEPS; ++i) {
+        if (!self.handle_collisions()) {
+            break;
+        }
     }
 
-    return collision;
+    self.update_sleeping(time_step);
 }
 
 }  // namespace tmine
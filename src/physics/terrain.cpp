@@ -0,0 +1,161 @@
+#include <optional>
+#include <tuple>
+
+#include "../physics.hpp"
+#include "../terrain.hpp"
+#include "../debug.hpp"
+
+namespace tmine {
+
+TerrainCollider::TerrainCollider(std::shared_ptr<ChunkArray> chunks)
+: chunks{std::move(chunks)} {}
+
+auto TerrainCollider::get_bounding_box(this TerrainCollider const& self)
+    -> Aabb {
+    return Aabb{
+        glm::vec3{0.0f},
+        glm::vec3{self.chunks->size() * Chunk::SIZE},
+    };
+}
+
+/// Clips motion of `box` along `axis` by `distance` so that it stops in front
+/// of the first solid voxel. Voxels already intersecting the box are ignored.
+static auto clip_axis(
+    ChunkArray const& chunks, Aabb box, i32 axis, f32 distance
+) -> f32 {
+    // Box touching a voxel face should not be blocked by that voxel
+    auto constexpr EPSILON = 1e-4f;
+
+    if (0.0f == distance) {
+        return distance;
+    }
+
+    auto const u = (axis + 1) % 3;
+    auto const v = (axis + 2) % 3;
+    auto const u_lo = (i32) std::floor(box.lo[u] + EPSILON);
+    auto const u_hi = (i32) std::ceil(box.hi[u] - EPSILON) - 1;
+    auto const v_lo = (i32) std::floor(box.lo[v] + EPSILON);
+    auto const v_hi = (i32) std::ceil(box.hi[v] - EPSILON) - 1;
+
+    auto layer_is_solid = [&](i32 layer) {
+        if (layer < 0 || u_hi < 0 || v_hi < 0) {
+            return false;
+        }
+
+        auto lo = glm::uvec3{0};
+        auto hi = glm::uvec3{0};
+
+        lo[axis] = hi[axis] = (u32) layer;
+        lo[u] = (u32) glm::max(u_lo, 0);
+        lo[v] = (u32) glm::max(v_lo, 0);
+        hi[u] = (u32) u_hi;
+        hi[v] = (u32) v_hi;
+
+        return chunks.any_solid_in(lo, hi);
+    };
+
+    if (distance > 0.0f) {
+        auto const first = (i32) std::ceil(box.hi[axis] - EPSILON);
+        auto const last = (i32) std::ceil(box.hi[axis] + distance) - 1;
+
+        for (auto layer = first; layer <= last; ++layer) {
+            if (layer_is_solid(layer)) {
+                return glm::max(0.0f, (f32) layer - box.hi[axis]);
+            }
+        }
+    } else {
+        auto const first = (i32) std::floor(box.lo[axis] + EPSILON) - 1;
+        auto const last = (i32) std::floor(box.lo[axis] + distance);
+
+        for (auto layer = first; layer >= last; --layer) {
+            if (layer_is_solid(layer)) {
+                return glm::min(0.0f, (f32) (layer + 1) - box.lo[axis]);
+            }
+        }
+    }
+
+    return distance;
+}
+
+auto TerrainCollider::sweep_box(
+    this TerrainCollider const& self, Aabb box, glm::vec3 displacement
+) -> SweptMotion {
+    auto result = SweptMotion{};
+
+    // Vertical axis goes first so that the box standing on the ground can
+    // slide along it
+    for (auto const axis : {1, 0, 2}) {
+        auto const distance =
+            clip_axis(*self.chunks, box, axis, displacement[axis]);
+
+        result.displacement[axis] = distance;
+        result.is_blocked[axis] = distance != displacement[axis];
+
+        box.lo[axis] += distance;
+        box.hi[axis] += distance;
+    }
+
+    return result;
+}
+
+auto TerrainCollider::collide_box(this TerrainCollider const& self, Aabb box)
+    -> Collision {
+    auto const position_corrected_box = Aabb{
+        box.lo - glm::vec3{0.5f},
+        box.hi - glm::vec3{0.5f},
+    };
+
+    auto const lo = glm::uvec3{
+        glm::max(glm::vec3{0.0f}, glm::round(position_corrected_box.lo))
+    };
+
+    auto const hi = glm::uvec3{
+        glm::max(glm::vec3{0.0f}, glm::round(position_corrected_box.hi))
+    };
+
+    debug::box(box, 0.8f * DebugColor::GREEN);
+
+    if (!self.chunks->any_solid_in(lo, hi)) {
+        return Collision{};
+    }
+
+    auto max_box = std::optional<Aabb>{};
+    auto max_cell = glm::uvec3{0};
+    auto max_volume = 0.0f;
+
+    // Cells are visited in place, this runs for every narrowphase pair
+    self.chunks->for_each_solid_cell(lo, hi, [&](glm::uvec3 cell) {
+        auto const voxel_lo = glm::vec3{cell};
+        auto const voxel_box = Aabb{voxel_lo, voxel_lo + glm::vec3{1.0f}};
+        auto const intersection = box.intersection(voxel_box);
+
+        if (intersection.is_empty()) {
+            return;
+        }
+
+        auto const volume = intersection.volume();
+
+        // Ties go to the voxel with the least `(x, y, z)`, the same one the
+        // plain scan over the box used to pick
+        auto const is_first = std::tie(cell.x, cell.y, cell.z) <
+                              std::tie(max_cell.x, max_cell.y, max_cell.z);
+
+        if (!max_box.has_value() || max_volume < volume ||
+            (max_volume == volume && is_first))
+        {
+            max_box.emplace(voxel_box);
+            max_cell = cell;
+            max_volume = volume;
+        }
+    });
+
+    if (!max_box.has_value()) {
+        return Collision{};
+    }
+
+    debug::box(max_box.value(), 0.8f * DebugColor::BLUE);
+
+    return collide_static_box(max_box.value(), box);
+}
+
+}  // namespace tmine
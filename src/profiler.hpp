@@ -0,0 +1,89 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <string>
+
+#include "types.hpp"
+
+#define TMINE_PROFILE_CONCAT_IMPL(left, right) left##right
+#define TMINE_PROFILE_CONCAT(left, right) TMINE_PROFILE_CONCAT_IMPL(left, right)
+
+#ifdef TMINE_PROFILE
+/// Records the time from here to the end of the scope as a zone named by
+/// string literal `name`.
+#    define tmine_profile_zone(name)                               \
+        auto const TMINE_PROFILE_CONCAT(profile_zone_, __LINE__) = \
+            ::tmine::ProfileZone{name}
+#else
+#    define tmine_profile_zone(name) ((void) 0)
+#endif
+
+namespace tmine {
+
+/// Scope measured on one thread, in nanoseconds of `profiler::now()`.
+struct ProfileEvent {
+    char const* name{""};
+    u64 start{0};
+    u64 end{0};
+};
+
+/// Events of one thread. Only the owning thread writes, so that recording
+/// takes no lock, the oldest events get overwritten when it is full.
+struct ProfileThreadBuffer {
+    static auto constexpr CAPACITY = usize{1} << 14;
+
+    std::array<ProfileEvent, CAPACITY> events{};
+    std::atomic<u64> n_written{0};
+    u32 thread_index{0};
+};
+
+/// Measures its own lifetime, use through `tmine_profile_zone`, so that
+/// builds without `TMINE_PROFILE` contain no zones at all.
+class ProfileZone {
+public:
+    explicit ProfileZone(char const* name) noexcept;
+    ~ProfileZone();
+
+    ProfileZone(ProfileZone const&) = delete;
+    auto operator=(this ProfileZone&, ProfileZone const&)
+        -> ProfileZone& = delete;
+
+private:
+    char const* name;
+    u64 start;
+};
+
+namespace profiler {
+
+    inline auto constexpr MAX_N_FRAMES = usize{256};
+    inline auto constexpr DEFAULT_N_DUMPED_FRAMES = usize{120};
+    inline char constexpr DEFAULT_TRACE_PATH[] = "trace.json";
+    /// Environment variable overriding the path traces are dumped to.
+    inline char constexpr TRACE_PATH_VARIABLE[] = "TMINE_TRACE_PATH";
+
+    /// Monotonic time in nanoseconds.
+    auto now() noexcept -> u64;
+
+    /// Appends `event` to the buffer of the calling thread.
+    auto record(ProfileEvent const& event) noexcept -> void;
+
+    /// Records the start of a frame, so that dumps of the last frames begin
+    /// at a frame boundary.
+    auto mark_frame() noexcept -> void;
+
+    /// Events of all threads since the start of the `n_frames`-th last frame,
+    /// or all kept events if `n_frames` is zero, in the Chrome trace event
+    /// format, to be opened with `chrome://tracing` or Perfetto.
+    auto to_chrome_trace(usize n_frames = DEFAULT_N_DUMPED_FRAMES)
+        -> std::string;
+
+    auto dump(char const* path, usize n_frames = DEFAULT_N_DUMPED_FRAMES)
+        -> void;
+
+    /// Dumps the trace on F10 to `TMINE_TRACE_PATH` or `trace.json`.
+    auto update() -> void;
+
+}  // namespace profiler
+
+}  // namespace tmine
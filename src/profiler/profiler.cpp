@@ -0,0 +1,226 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <fmt/format.h>
+
+#include "../profiler.hpp"
+#include "../debug.hpp"
+#include "../events.hpp"
+#include "../loaders.hpp"
+
+namespace tmine {
+
+static auto thread_buffers_mutex = std::mutex{};
+static auto thread_buffers =
+    std::vector<std::shared_ptr<ProfileThreadBuffer>>{};
+
+static std::array<std::atomic<u64>, profiler::MAX_N_FRAMES> frame_starts{};
+static auto n_marked_frames = std::atomic<u64>{0};
+
+static auto register_thread() -> std::shared_ptr<ProfileThreadBuffer> {
+    auto buffer = std::make_shared<ProfileThreadBuffer>();
+    auto lock = std::lock_guard{thread_buffers_mutex};
+
+    buffer->thread_index = (u32) thread_buffers.size();
+    thread_buffers.push_back(buffer);
+
+    return buffer;
+}
+
+/// Registers the buffer on first use only, recording never locks.
+static auto this_thread_buffer() -> ProfileThreadBuffer& {
+    thread_local auto const buffer = register_thread();
+    return *buffer;
+}
+
+ProfileZone::ProfileZone(char const* name) noexcept
+: name{name}
+, start{profiler::now()} {}
+
+ProfileZone::~ProfileZone() {
+    profiler::record(ProfileEvent{
+        .name = this->name,
+        .start = this->start,
+        .end = profiler::now(),
+    });
+}
+
+namespace profiler {
+
+    auto now() noexcept -> u64 {
+        auto const time = std::chrono::steady_clock::now().time_since_epoch();
+        return (u64) std::chrono::nanoseconds{time}.count();
+    }
+
+    auto record(ProfileEvent const& event) noexcept -> void {
+        auto& buffer = this_thread_buffer();
+        auto const index = buffer.n_written.load(std::memory_order_relaxed);
+
+        buffer.events[index % ProfileThreadBuffer::CAPACITY] = event;
+        buffer.n_written.store(index + 1, std::memory_order_release);
+    }
+
+    auto mark_frame() noexcept -> void {
+        auto const index = n_marked_frames.load(std::memory_order_relaxed);
+
+        frame_starts[index % MAX_N_FRAMES].store(
+            now(), std::memory_order_relaxed
+        );
+        n_marked_frames.store(index + 1, std::memory_order_release);
+    }
+
+    /// Start of the `n_frames`-th last frame or zero if less frames passed.
+    static auto frames_start(usize n_frames) -> u64 {
+        auto const n_marked = n_marked_frames.load(std::memory_order_acquire);
+        auto const n_kept = std::min<u64>(n_marked, MAX_N_FRAMES);
+
+        if (0 == n_frames || n_kept < n_frames) {
+            return 0;
+        }
+
+        return frame_starts[(n_marked - n_frames) % MAX_N_FRAMES].load(
+            std::memory_order_relaxed
+        );
+    }
+
+    /// Copies events of `buffer` started at `since` or later. Events the
+    /// owning thread overwrote while copying are dropped.
+    static auto read_events(ProfileThreadBuffer const& buffer, u64 since)
+        -> std::vector<ProfileEvent> {
+        auto constexpr CAPACITY = ProfileThreadBuffer::CAPACITY;
+
+        auto const end = buffer.n_written.load(std::memory_order_acquire);
+        auto const begin = end > CAPACITY ? end - CAPACITY : 0;
+
+        auto events = std::vector<ProfileEvent>{};
+        events.reserve(end - begin);
+
+        for (auto i = begin; i < end; ++i) {
+            events.push_back(buffer.events[i % CAPACITY]);
+        }
+
+        // The slot of event number `after` may be half written right now,
+        // there is no way to tell whether the owning thread is recording, so
+        // it is dropped even if it holds the oldest complete event
+        auto const after = buffer.n_written.load(std::memory_order_acquire);
+        auto const n_overwritten =
+            after >= CAPACITY ? std::min(after - CAPACITY + 1, end) : 0;
+
+        if (n_overwritten > begin) {
+            events.erase(
+                events.begin(), events.begin() + (n_overwritten - begin)
+            );
+        }
+
+        std::erase_if(events, [since](ProfileEvent const& event) {
+            return event.start < since;
+        });
+
+        return events;
+    }
+
+    static auto write_json_string(
+        RefMut<std::string> out, std::string_view string
+    ) -> void {
+        out->push_back('"');
+
+        for (auto const symbol : string) {
+            if ('"' == symbol || '\\' == symbol) {
+                out->push_back('\\');
+            }
+
+            out->push_back(symbol);
+        }
+
+        out->push_back('"');
+    }
+
+    auto to_chrome_trace(usize n_frames) -> std::string {
+        auto const since = frames_start(n_frames);
+
+        auto buffers = std::vector<std::shared_ptr<ProfileThreadBuffer>>{};
+
+        {
+            auto lock = std::lock_guard{thread_buffers_mutex};
+            buffers = thread_buffers;
+        }
+
+        auto out = std::string{};
+        auto out_iter = std::back_inserter(out);
+        auto is_first = true;
+
+        auto const separate = [&] {
+            if (!is_first) {
+                out.append(",\n");
+            }
+
+            is_first = false;
+        };
+
+        out.append("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+        for (auto const& buffer : buffers) {
+            separate();
+            fmt::format_to(
+                out_iter,
+                "{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,"
+                "\"tid\":{0},\"args\":{{\"name\":\"thread #{0}\"}}}}",
+                buffer->thread_index
+            );
+
+            for (auto const& event : read_events(*buffer, since)) {
+                auto const end = std::max(event.start, event.end);
+
+                separate();
+                out.append("{\"name\":");
+                write_json_string(&out, event.name);
+                fmt::format_to(
+                    out_iter,
+                    ",\"cat\":\"tmine\",\"ph\":\"X\",\"pid\":0,\"tid\":{},"
+                    "\"ts\":{:.3f},\"dur\":{:.3f}}}",
+                    buffer->thread_index,
+                    1e-3 * (f64) (event.start - std::min(since, event.start)),
+                    1e-3 * (f64) (end - event.start)
+                );
+            }
+        }
+
+        out.append("\n]}\n");
+
+        return out;
+    }
+
+    auto dump(char const* path, usize n_frames) -> void {
+        auto const trace = to_chrome_trace(n_frames);
+
+        write_to_file(
+            path, std::span{(u8 const*) trace.data(), trace.size()}
+        );
+    }
+
+    auto update() -> void {
+        if (!io.just_pressed(Key::F10)) {
+            return;
+        }
+
+        char const* path = std::getenv(TRACE_PATH_VARIABLE);
+
+        if (nullptr == path) {
+            path = DEFAULT_TRACE_PATH;
+        }
+
+        dump(path);
+
+        debug::text()->set_formatted(
+            "profiler", "Trace of {} frames saved to '{}'",
+            DEFAULT_N_DUMPED_FRAMES, path
+        );
+    }
+
+}  // namespace profiler
+
+}  // namespace tmine
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "controls.hpp"
+#include "terrain.hpp"
+#include "geometry.hpp"
+#include "entities.hpp"
+
+namespace tmine {
+
+/// Voxels of the box from `lo` to `hi` inclusive as they were after an edit
+/// made right before fixed update number `tick`.
+struct ReplayPatch {
+    u32 tick{0};
+    glm::uvec3 lo{0};
+    glm::uvec3 hi{0};
+    std::vector<Voxel> voxels;
+};
+
+/// Entity with a collider spawned right before fixed update number `tick`.
+struct ReplaySpawn {
+    u32 tick{0};
+    Transform transform{};
+    Velocity velocity{};
+    EntityCollider collider{};
+};
+
+/// Everything needed to repeat a sequence of player fixed updates: the world,
+/// the player and the entities at the start, inputs of every tick and terrain
+/// edits and spawns made between ticks.
+struct ReplayLog {
+    /// Captures the world, the entities and the player state to start
+    /// recording from. A log without ticks ends where it starts.
+    static auto capture(
+        f32 time_step, ChunkArray const& chunks,
+        EntityRegistry const& entities, PlayerState const& state
+    ) -> ReplayLog;
+
+    /// Appends the input of the next fixed update.
+    auto record_tick(this ReplayLog& self, PlayerTickInput const& input)
+        -> void;
+
+    /// Stores the current contents of the edited `box` of the world.
+    auto record_edit(this ReplayLog& self, ChunkArray const& chunks, Aabb box)
+        -> void;
+
+    /// Stores the components of the just spawned `entity`, entities that
+    /// `move_entities` skips are not stored.
+    auto record_spawn(
+        this ReplayLog& self, EntityRegistry const& entities, Entity entity
+    ) -> void;
+
+    /// Stores the player state the replay should end up with. Called right
+    /// after every recorded tick, so that changes made between ticks are not
+    /// included.
+    auto finish(this ReplayLog& self, PlayerState const& state) -> void;
+
+    /// Stores the positions entities should end up with. Entities move only
+    /// during ticks, so this is called once before the log is saved.
+    auto record_entity_positions(
+        this ReplayLog& self, EntityRegistry const& entities
+    ) -> void;
+
+    auto serialize(this ReplayLog const& self) -> std::vector<u8>;
+    static auto deserialize(std::span<u8 const> bytes) -> ReplayLog;
+
+    auto save(this ReplayLog const& self, char const* path) -> void;
+    static auto load(char const* path) -> ReplayLog;
+
+    inline auto tick_count(this ReplayLog const& self) noexcept -> usize {
+        return self.inputs.size();
+    }
+
+    static char constexpr MAGIC[] = "TMRP";
+    static auto constexpr VERSION = u32{2};
+
+    f32 time_step{0.0f};
+    glm::uvec3 world_size{0};
+    /// Voxels of the whole world ordered by `y`, then `z`, then `x`, so that
+    /// logs do not depend on the voxel layout.
+    std::vector<Voxel> voxels;
+    PlayerState initial_state{};
+    std::vector<PlayerTickInput> inputs;
+    std::vector<ReplayPatch> patches;
+    std::vector<ReplaySpawn> spawns;
+    std::optional<PlayerState> final_state;
+    /// Positions of the entities moved by `move_entities` in the order of
+    /// their colliders.
+    std::vector<glm::vec3> final_entity_positions;
+};
+
+struct ReplayResult {
+    PlayerState final_state{};
+    std::vector<glm::vec3> final_entity_positions;
+    usize tick_count{0};
+    f64 ticks_per_second{0.0};
+    /// Whether `final_state` and `final_entity_positions` are bit-exactly
+    /// equal to the recorded ones.
+    bool is_exact{false};
+};
+
+/// Steps the physics, the player fixed update and the entities through `log`
+/// without window or `io`.
+auto replay(ReplayLog const& log) -> ReplayResult;
+
+/// Compares states bit by bit, so that `-0.0` and `0.0` differ and `NaN`
+/// equals itself.
+auto is_bit_exact(PlayerState const& left, PlayerState const& right) -> bool;
+
+}  // namespace tmine
@@ -0,0 +1,586 @@
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
+#include "../replay.hpp"
+#include "../physics.hpp"
+#include "../loaders.hpp"
+#include "../panic.hpp"
+
+namespace tmine {
+
+class ReplayWriter {
+public:
+    explicit ReplayWriter(RefMut<std::vector<u8>> bytes)
+    : bytes{bytes} {}
+
+    template <class T>
+        requires std::is_trivially_copyable_v<T>
+    auto write(this ReplayWriter& self, T const& value) -> void {
+        auto const offset = self.bytes->size();
+        self.bytes->resize(offset + sizeof(T));
+        std::memcpy(self.bytes->data() + offset, &value, sizeof(T));
+    }
+
+    auto write(this ReplayWriter& self, PlayerState const& state) -> void {
+        self.write(state.box.lo);
+        self.write(state.box.hi);
+        self.write(state.velocity);
+        self.write(state.acceleration);
+        self.write(state.fov_dynamics.fov_velocity);
+        self.write(state.fov_dynamics.prev_target_fov);
+        self.write(state.velocity_dynamics.target_velocity_rate_of_change);
+        self.write(state.velocity_dynamics.velocity_rate_of_change);
+        self.write((u8) state.movement);
+        self.write(state.camera_angles);
+        self.write(state.fov);
+    }
+
+    auto write(this ReplayWriter& self, PlayerTickInput const& input) -> void {
+        self.write(input.pressed);
+        self.write((u8) input.movement);
+        self.write(input.camera_angles);
+    }
+
+    auto write(this ReplayWriter& self, Voxel voxel) -> void {
+        self.write(voxel.id);
+        self.write(voxel.meta);
+    }
+
+    auto write(this ReplayWriter& self, ReplaySpawn const& spawn) -> void {
+        self.write(spawn.tick);
+        self.write(spawn.transform.pos);
+        self.write(spawn.velocity.value);
+        self.write(spawn.velocity.acceleration);
+        self.write(spawn.collider.size);
+        self.write(spawn.collider.elasticity);
+    }
+
+private:
+    RefMut<std::vector<u8>> bytes;
+};
+
+class ReplayReader {
+public:
+    explicit ReplayReader(std::span<u8 const> bytes)
+    : bytes{bytes} {}
+
+    template <class T>
+        requires std::is_trivially_copyable_v<T>
+    auto read(this ReplayReader& self) -> T {
+        if (self.bytes.size() - self.offset < sizeof(T)) {
+            throw Panic(
+                "replay log is truncated at byte {} of {}", self.offset,
+                self.bytes.size()
+            );
+        }
+
+        auto value = T{};
+        std::memcpy(&value, self.bytes.data() + self.offset, sizeof(T));
+        self.offset += sizeof(T);
+
+        return value;
+    }
+
+    auto read_movement(this ReplayReader& self) -> PlayerMovement {
+        auto const movement = self.read<u8>();
+
+        if (movement > (u8) PlayerMovement::Fly) {
+            throw Panic("invalid player movement {} in replay log", movement);
+        }
+
+        return (PlayerMovement) movement;
+    }
+
+    auto read_state(this ReplayReader& self) -> PlayerState {
+        auto state = PlayerState{};
+
+        state.box.lo = self.read<glm::vec3>();
+        state.box.hi = self.read<glm::vec3>();
+        state.velocity = self.read<glm::vec3>();
+        state.acceleration = self.read<glm::vec3>();
+        state.fov_dynamics.fov_velocity = self.read<f32>();
+        state.fov_dynamics.prev_target_fov = self.read<f32>();
+        state.velocity_dynamics.target_velocity_rate_of_change =
+            self.read<glm::vec3>();
+        state.velocity_dynamics.velocity_rate_of_change =
+            self.read<glm::vec3>();
+        state.movement = self.read_movement();
+        state.camera_angles = self.read<glm::vec2>();
+        state.fov = self.read<f32>();
+
+        return state;
+    }
+
+    auto read_input(this ReplayReader& self) -> PlayerTickInput {
+        auto input = PlayerTickInput{};
+
+        input.pressed = self.read<u8>();
+        input.movement = self.read_movement();
+        input.camera_angles = self.read<glm::vec2>();
+
+        return input;
+    }
+
+    auto read_voxel(this ReplayReader& self) -> Voxel {
+        auto const id = self.read<VoxelId>();
+        auto const meta = self.read<BlockMeta>();
+
+        return Voxel{id, meta};
+    }
+
+    auto read_spawn(this ReplayReader& self) -> ReplaySpawn {
+        auto spawn = ReplaySpawn{};
+
+        spawn.tick = self.read<u32>();
+        spawn.transform.pos = self.read<glm::vec3>();
+        spawn.velocity.value = self.read<glm::vec3>();
+        spawn.velocity.acceleration = self.read<glm::vec3>();
+        spawn.collider.size = self.read<glm::vec3>();
+        spawn.collider.elasticity = self.read<f32>();
+
+        return spawn;
+    }
+
+    inline auto is_finished(this ReplayReader const& self) noexcept -> bool {
+        return self.offset == self.bytes.size();
+    }
+
+private:
+    std::span<u8 const> bytes;
+    usize offset{0};
+};
+
+/// Visits every voxel position of `[lo, hi]` in the order voxels are stored
+/// in replay logs.
+template <class F>
+static auto for_each_position(glm::uvec3 lo, glm::uvec3 hi, F&& visit)
+    -> void {
+    for (u32 y = lo.y; y <= hi.y; ++y) {
+        for (u32 z = lo.z; z <= hi.z; ++z) {
+            for (u32 x = lo.x; x <= hi.x; ++x) {
+                visit(glm::uvec3{x, y, z});
+            }
+        }
+    }
+}
+
+static auto volume_of(glm::uvec3 lo, glm::uvec3 hi) -> usize {
+    auto const size = hi - lo + 1u;
+    return (usize) size.x * (usize) size.y * (usize) size.z;
+}
+
+/// Positions of the entities `move_entities` moves in the order it does.
+static auto positions_of(EntityRegistry const& entities)
+    -> std::vector<glm::vec3> {
+    auto const& transforms = entities.storage<Transform>();
+    auto const& velocities = entities.storage<Velocity>();
+    auto positions = std::vector<glm::vec3>{};
+
+    for (auto const entity : entities.storage<EntityCollider>().entities()) {
+        if (transforms.contains(entity) && velocities.contains(entity)) {
+            positions.push_back(transforms.get(entity).pos);
+        }
+    }
+
+    return positions;
+}
+
+auto ReplayLog::capture(
+    f32 time_step, ChunkArray const& chunks, EntityRegistry const& entities,
+    PlayerState const& state
+) -> ReplayLog {
+    auto const world_size = chunks.size() * Chunk::SIZE;
+
+    auto log = ReplayLog{
+        .time_step = time_step,
+        .world_size = chunks.size(),
+        .initial_state = state,
+    };
+
+    log.voxels.reserve(volume_of(glm::uvec3{0}, world_size - 1u));
+
+    for_each_position(glm::uvec3{0}, world_size - 1u, [&](glm::uvec3 pos) {
+        log.voxels.push_back(chunks.get_voxel(pos).value());
+    });
+
+    for (auto const entity : entities.storage<EntityCollider>().entities()) {
+        log.record_spawn(entities, entity);
+    }
+
+    log.finish(state);
+    log.record_entity_positions(entities);
+
+    return log;
+}
+
+auto ReplayLog::record_tick(this ReplayLog& self, PlayerTickInput const& input)
+    -> void {
+    self.inputs.push_back(input);
+}
+
+auto ReplayLog::record_edit(
+    this ReplayLog& self, ChunkArray const& chunks, Aabb box
+) -> void {
+    // Edited boxes always cover whole voxels
+    auto patch = ReplayPatch{
+        .tick = (u32) self.inputs.size(),
+        .lo = glm::uvec3{box.lo},
+        .hi = glm::uvec3{box.hi} - 1u,
+    };
+
+    patch.voxels.reserve(volume_of(patch.lo, patch.hi));
+
+    for_each_position(patch.lo, patch.hi, [&](glm::uvec3 pos) {
+        patch.voxels.push_back(chunks.get_voxel(pos).value_or(Voxel{}));
+    });
+
+    self.patches.emplace_back(std::move(patch));
+}
+
+auto ReplayLog::record_spawn(
+    this ReplayLog& self, EntityRegistry const& entities, Entity entity
+) -> void {
+    auto const& transforms = entities.storage<Transform>();
+    auto const& velocities = entities.storage<Velocity>();
+    auto const& colliders = entities.storage<EntityCollider>();
+
+    if (!transforms.contains(entity) || !velocities.contains(entity) ||
+        !colliders.contains(entity))
+    {
+        return;
+    }
+
+    self.spawns.push_back(ReplaySpawn{
+        .tick = (u32) self.inputs.size(),
+        .transform = transforms.get(entity),
+        .velocity = velocities.get(entity),
+        .collider = colliders.get(entity),
+    });
+}
+
+auto ReplayLog::finish(this ReplayLog& self, PlayerState const& state)
+    -> void {
+    self.final_state = state;
+}
+
+auto ReplayLog::record_entity_positions(
+    this ReplayLog& self, EntityRegistry const& entities
+) -> void {
+    self.final_entity_positions = positions_of(entities);
+}
+
+auto ReplayLog::serialize(this ReplayLog const& self) -> std::vector<u8> {
+    auto bytes = std::vector<u8>{};
+    auto writer = ReplayWriter{&bytes};
+
+    for (usize i = 0; i < sizeof(ReplayLog::MAGIC) - 1; ++i) {
+        writer.write(ReplayLog::MAGIC[i]);
+    }
+
+    writer.write(ReplayLog::VERSION);
+    writer.write(self.time_step);
+    writer.write(self.world_size);
+
+    // Worlds are mostly long runs of the same voxel, so they are stored as
+    // run lengths followed by voxels
+    for (usize start = 0; start < self.voxels.size();) {
+        auto const voxel = self.voxels[start];
+        auto end = start + 1;
+
+        while (end < self.voxels.size() && end - start < ~u32{0} &&
+               self.voxels[end].id == voxel.id &&
+               self.voxels[end].meta == voxel.meta)
+        {
+            ++end;
+        }
+
+        writer.write((u32) (end - start));
+        writer.write(voxel);
+
+        start = end;
+    }
+
+    writer.write(self.initial_state);
+
+    writer.write((u32) self.inputs.size());
+
+    for (auto const& input : self.inputs) {
+        writer.write(input);
+    }
+
+    writer.write((u32) self.patches.size());
+
+    for (auto const& patch : self.patches) {
+        writer.write(patch.tick);
+        writer.write(patch.lo);
+        writer.write(patch.hi);
+
+        for (auto const voxel : patch.voxels) {
+            writer.write(voxel);
+        }
+    }
+
+    writer.write((u32) self.spawns.size());
+
+    for (auto const& spawn : self.spawns) {
+        writer.write(spawn);
+    }
+
+    writer.write((u8) self.final_state.has_value());
+
+    if (self.final_state.has_value()) {
+        writer.write(self.final_state.value());
+        writer.write((u32) self.final_entity_positions.size());
+
+        for (auto const pos : self.final_entity_positions) {
+            writer.write(pos);
+        }
+    }
+
+    return bytes;
+}
+
+auto ReplayLog::deserialize(std::span<u8 const> bytes) -> ReplayLog {
+    auto reader = ReplayReader{bytes};
+
+    for (usize i = 0; i < sizeof(ReplayLog::MAGIC) - 1; ++i) {
+        if (reader.read<char>() != ReplayLog::MAGIC[i]) {
+            throw Panic("data is not a replay log");
+        }
+    }
+
+    auto const version = reader.read<u32>();
+
+    if (ReplayLog::VERSION != version) {
+        throw Panic(
+            "unsupported replay log version {}, expected {}", version,
+            ReplayLog::VERSION
+        );
+    }
+
+    auto log = ReplayLog{};
+
+    log.time_step = reader.read<f32>();
+    log.world_size = reader.read<glm::uvec3>();
+
+    if (glm::any(glm::equal(log.world_size, glm::uvec3{0}))) {
+        throw Panic("replay log contains an empty world");
+    }
+
+    auto const world_size = log.world_size * Chunk::SIZE;
+    auto const n_voxels = volume_of(glm::uvec3{0}, world_size - 1u);
+
+    log.voxels.reserve(n_voxels);
+
+    while (log.voxels.size() < n_voxels) {
+        auto const run_length = reader.read<u32>();
+        auto const voxel = reader.read_voxel();
+
+        if (0 == run_length || n_voxels - log.voxels.size() < run_length) {
+            throw Panic("invalid voxel run of length {}", run_length);
+        }
+
+        log.voxels.insert(log.voxels.end(), run_length, voxel);
+    }
+
+    log.initial_state = reader.read_state();
+
+    auto const n_inputs = reader.read<u32>();
+    log.inputs.reserve(n_inputs);
+
+    for (u32 i = 0; i < n_inputs; ++i) {
+        log.inputs.push_back(reader.read_input());
+    }
+
+    auto const n_patches = reader.read<u32>();
+    log.patches.reserve(n_patches);
+
+    for (u32 i = 0; i < n_patches; ++i) {
+        auto patch = ReplayPatch{
+            .tick = reader.read<u32>(),
+            .lo = reader.read<glm::uvec3>(),
+            .hi = reader.read<glm::uvec3>(),
+        };
+
+        if (glm::any(glm::lessThan(patch.hi, patch.lo)) ||
+            glm::any(glm::greaterThanEqual(patch.hi, world_size)))
+        {
+            throw Panic("replay patch #{} is out of the world", i);
+        }
+
+        if (!log.patches.empty() && patch.tick < log.patches.back().tick) {
+            throw Panic("replay patch #{} is out of order", i);
+        }
+
+        auto const volume = volume_of(patch.lo, patch.hi);
+        patch.voxels.reserve(volume);
+
+        for (usize j = 0; j < volume; ++j) {
+            patch.voxels.push_back(reader.read_voxel());
+        }
+
+        log.patches.emplace_back(std::move(patch));
+    }
+
+    auto const n_spawns = reader.read<u32>();
+    log.spawns.reserve(n_spawns);
+
+    for (u32 i = 0; i < n_spawns; ++i) {
+        auto const spawn = reader.read_spawn();
+
+        if (!log.spawns.empty() && spawn.tick < log.spawns.back().tick) {
+            throw Panic("replay spawn #{} is out of order", i);
+        }
+
+        log.spawns.push_back(spawn);
+    }
+
+    if (0 != reader.read<u8>()) {
+        log.final_state = reader.read_state();
+
+        auto const n_positions = reader.read<u32>();
+
+        if (n_positions > log.spawns.size()) {
+            throw Panic(
+                "replay log ends with {} entities of {} spawned", n_positions,
+                log.spawns.size()
+            );
+        }
+
+        log.final_entity_positions.reserve(n_positions);
+
+        for (u32 i = 0; i < n_positions; ++i) {
+            log.final_entity_positions.push_back(reader.read<glm::vec3>());
+        }
+    }
+
+    if (!reader.is_finished()) {
+        throw Panic("replay log has trailing bytes");
+    }
+
+    return log;
+}
+
+auto ReplayLog::save(this ReplayLog const& self, char const* path) -> void {
+    write_to_file(path, self.serialize());
+}
+
+auto ReplayLog::load(char const* path) -> ReplayLog {
+    auto const contents = read_to_string(path);
+
+    return ReplayLog::deserialize(std::span{
+        (u8 const*) contents.data(), contents.size()
+    });
+}
+
+static auto apply_patch(
+    RefMut<ChunkArray> chunks, RefMut<PhysicsSolver> solver,
+    ReplayPatch const& patch
+) -> void {
+    auto voxel = patch.voxels.begin();
+
+    for_each_position(patch.lo, patch.hi, [&](glm::uvec3 pos) {
+        chunks->set_voxel(pos, *voxel++);
+    });
+
+    solver->wake_in(Aabb{glm::vec3{patch.lo}, glm::vec3{patch.hi + 1u}});
+}
+
+static auto apply_spawn(
+    RefMut<EntityRegistry> entities, ReplaySpawn const& spawn
+) -> void {
+    auto const entity = entities->spawn();
+
+    entities->add(entity, spawn.transform);
+    entities->add(entity, spawn.velocity);
+    entities->add(entity, spawn.collider);
+}
+
+static auto is_bit_exact(
+    std::span<glm::vec3 const> left, std::span<glm::vec3 const> right
+) -> bool {
+    return left.size() == right.size() &&
+           (left.empty() ||
+            0 == std::memcmp(left.data(), right.data(), left.size_bytes()));
+}
+
+auto replay(ReplayLog const& log) -> ReplayResult {
+    auto const world_size = log.world_size * Chunk::SIZE;
+    auto chunks = std::make_shared<ChunkArray>(log.world_size);
+    auto voxel = log.voxels.begin();
+
+    for_each_position(glm::uvec3{0}, world_size - 1u, [&](glm::uvec3 pos) {
+        chunks->set_voxel(pos, *voxel++);
+    });
+
+    // Colliders are added in the same order as `Game` does
+    auto solver = PhysicsSolver{};
+    auto player = Player{*chunks, &solver};
+    solver.register_collidable<TerrainCollider>(chunks);
+
+    player.set_state(&solver, log.initial_state);
+
+    auto entities = EntityRegistry{};
+    auto const terrain = TerrainCollider{chunks};
+
+    auto patch = log.patches.begin();
+    auto spawn = log.spawns.begin();
+    auto const start = std::chrono::steady_clock::now();
+
+    for (u32 tick = 0; tick < log.inputs.size(); ++tick) {
+        for (; patch != log.patches.end() && tick == patch->tick; ++patch) {
+            apply_patch(chunks.get(), &solver, *patch);
+        }
+
+        for (; spawn != log.spawns.end() && tick == spawn->tick; ++spawn) {
+            apply_spawn(&entities, *spawn);
+        }
+
+        // Systems run in the same order as in `Game`
+        solver.update(log.time_step);
+        player.fixed_update(
+            log.time_step, *chunks, &solver, log.inputs[tick]
+        );
+        move_entities(&entities, terrain, log.time_step);
+    }
+
+    // Entities spawned after the last tick, or in a log without ticks,
+    // stay where they were spawned
+    for (; spawn != log.spawns.end(); ++spawn) {
+        apply_spawn(&entities, *spawn);
+    }
+
+    auto const duration = std::chrono::duration<f64>(
+        std::chrono::steady_clock::now() - start
+    );
+
+    auto result = ReplayResult{
+        .final_state = player.get_state(&solver),
+        .final_entity_positions = positions_of(entities),
+        .tick_count = log.inputs.size(),
+        .ticks_per_second = (f64) log.inputs.size() / duration.count(),
+    };
+
+    result.is_exact =
+        log.final_state.has_value() &&
+        is_bit_exact(result.final_state, log.final_state.value()) &&
+        is_bit_exact(
+            result.final_entity_positions, log.final_entity_positions
+        );
+
+    return result;
+}
+
+auto is_bit_exact(PlayerState const& left, PlayerState const& right) -> bool {
+    auto left_bytes = std::vector<u8>{};
+    auto right_bytes = std::vector<u8>{};
+
+    ReplayWriter{&left_bytes}.write(left);
+    ReplayWriter{&right_bytes}.write(right);
+
+    return left_bytes == right_bytes;
+}
+
+}  // namespace tmine
@@ -1,9 +1,19 @@
 #pragma once
 
 #include <array>
+#include <bit>
 #include <optional>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
 #include <glm/glm.hpp>
 
+#if defined(__BMI2__)
+#    include <immintrin.h>
+#endif
+
 #include "types.hpp"
 #include "graphics.hpp"
 #include "data.hpp"
@@ -13,6 +23,129 @@ namespace tmine {
 
 class Camera;
 
+#if defined(TMINE_MORTON_VOXEL_LAYOUT)
+inline auto constexpr USE_MORTON_VOXEL_LAYOUT = true;
+#else
+inline auto constexpr USE_MORTON_VOXEL_LAYOUT = false;
+#endif
+
+namespace morton {
+
+    inline auto constexpr X_MASK = u32{0x09249249};
+    inline auto constexpr Z_MASK = u32{0x12492492};
+    inline auto constexpr Y_MASK = u32{0x24924924};
+
+    /// Spreads lower 10 bits of `value` so that there are two zero bits
+    /// between each pair of bits.
+    inline auto spread_bits(u32 value) noexcept -> u32 {
+#if defined(__BMI2__)
+        return _pdep_u32(value, X_MASK);
+#else
+        value &= 0x000003FF;
+        value = (value ^ (value << 16)) & 0xFF0000FF;
+        value = (value ^ (value << 8)) & 0x0300F00F;
+        value = (value ^ (value << 4)) & 0x030C30C3;
+        value = (value ^ (value << 2)) & 0x09249249;
+        return value;
+#endif
+    }
+
+    /// Inverse of `spread_bits`, takes every third bit of `value`.
+    inline auto compact_bits(u32 value) noexcept -> u32 {
+#if defined(__BMI2__)
+        return _pext_u32(value, X_MASK);
+#else
+        value &= 0x09249249;
+        value = (value ^ (value >> 2)) & 0x030C30C3;
+        value = (value ^ (value >> 4)) & 0x0300F00F;
+        value = (value ^ (value >> 8)) & 0xFF0000FF;
+        value = (value ^ (value >> 16)) & 0x000003FF;
+        return value;
+#endif
+    }
+
+    /// Interleaves bits of coordinates in `x, z, y` order, so `x` occupies
+    /// the lowest bit. Each coordinate should fit in 10 bits.
+    inline auto encode(glm::uvec3 pos) noexcept -> u32 {
+        return spread_bits(pos.x) | (spread_bits(pos.z) << 1) |
+               (spread_bits(pos.y) << 2);
+    }
+
+    inline auto decode(u32 code) noexcept -> glm::uvec3 {
+        return glm::uvec3{
+            compact_bits(code),
+            compact_bits(code >> 2),
+            compact_bits(code >> 1),
+        };
+    }
+
+}  // namespace morton
+
+/// Row-major order: `x` changes the fastest and `y` changes the slowest.
+struct LinearLayout {
+    static auto constexpr NAME = std::string_view{"linear"};
+
+    inline static auto index_of(glm::uvec3 pos, glm::uvec3 sizes) noexcept
+        -> usize {
+        return ((usize) pos.y * sizes.z + pos.z) * sizes.x + pos.x;
+    }
+
+    inline static auto pos_of(usize index, glm::uvec3 sizes) noexcept
+        -> glm::uvec3 {
+        auto const x = index % sizes.x;
+        auto const zy = index / sizes.x;
+        auto const z = zy % sizes.z;
+        auto const y = zy / sizes.z;
+
+        return glm::uvec3{x, y, z};
+    }
+
+    inline static auto is_valid_size([[maybe_unused]] glm::uvec3 sizes
+    ) noexcept -> bool {
+        return true;
+    }
+};
+
+/// Space is split into cubic tiles with the side of `1 << N_TILE_BITS`. Tiles
+/// are stored in row-major order and cells inside of a tile are stored in
+/// Morton (Z-curve) order, so neighbours along any axis are close in memory.
+///
+/// # Note
+///
+/// Sizes should be multiples of the tile side.
+template <u32 N_TILE_BITS>
+    requires(N_TILE_BITS <= 10)
+struct MortonLayout {
+    static auto constexpr NAME = std::string_view{"morton"};
+    static auto constexpr TILE_SIDE = u32{1} << N_TILE_BITS;
+    static auto constexpr TILE_VOLUME = usize{1} << (3 * N_TILE_BITS);
+
+    inline static auto index_of(glm::uvec3 pos, glm::uvec3 sizes) noexcept
+        -> usize {
+        auto const tile = pos >> N_TILE_BITS;
+        auto const local = pos & (TILE_SIDE - 1);
+        auto const n_tiles = sizes >> N_TILE_BITS;
+
+        return LinearLayout::index_of(tile, n_tiles) * TILE_VOLUME +
+               morton::encode(local);
+    }
+
+    inline static auto pos_of(usize index, glm::uvec3 sizes) noexcept
+        -> glm::uvec3 {
+        auto const n_tiles = sizes >> N_TILE_BITS;
+        auto const tile =
+            LinearLayout::pos_of(index >> (3 * N_TILE_BITS), n_tiles);
+        auto const local = morton::decode((u32) (index & (TILE_VOLUME - 1)));
+
+        return (tile << N_TILE_BITS) | local;
+    }
+
+    inline static auto is_valid_size(glm::uvec3 sizes) noexcept -> bool {
+        return 0 == sizes.x % TILE_SIDE && 0 == sizes.y % TILE_SIDE &&
+               0 == sizes.z % TILE_SIDE;
+    }
+};
+
 struct Voxel {
     VoxelId id;
     BlockMeta meta;
@@ -31,6 +164,7 @@ public:
     explicit Chunk(glm::uvec3 pos);
 
     static auto index_of(glm::uvec3 pos) noexcept -> usize;
+    static auto pos_of(usize index) noexcept -> glm::uvec3;
     static auto is_in_bounds(glm::uvec3 pos) noexcept -> bool;
 
     auto get_voxel(this Chunk const& self, glm::uvec3 pos) noexcept
@@ -46,6 +180,67 @@ public:
         return self.voxels;
     }
 
+    /// Reads a voxel without bounds checking, `pos` should be in bounds.
+    inline auto get_voxel_unchecked(
+        this Chunk const& self, glm::uvec3 pos
+    ) noexcept -> Voxel {
+        return self.voxels[Chunk::index_of(pos)];
+    }
+
+    /// Index of the bit in the brick mask of a brick containing `pos`.
+    static inline auto brick_index_of(glm::uvec3 pos) noexcept -> u32 {
+        auto const brick_pos = pos >> glm::uvec3{Chunk::N_BRICK_BITS};
+
+        return (u32) (brick_pos.x +
+                      Chunk::N_BRICKS_PER_SIDE *
+                          (brick_pos.z + Chunk::N_BRICKS_PER_SIDE * brick_pos.y)
+        );
+    }
+
+    /// Number of voxels with given `id` in the chunk.
+    inline auto count_of(this Chunk const& self, VoxelId id) noexcept
+        -> usize {
+        return self.id_counts[id];
+    }
+
+    /// Number of non-air voxels in the chunk.
+    inline auto solid_count(this Chunk const& self) noexcept -> usize {
+        return Chunk::VOLUME - self.id_counts[0];
+    }
+
+    /// Checks that chunk has no air voxels.
+    inline auto is_full(this Chunk const& self) noexcept -> bool {
+        return 0 == self.id_counts[0];
+    }
+
+    /// Checks that chunk has no non-air voxels.
+    inline auto is_empty(this Chunk const& self) noexcept -> bool {
+        return 0 == self.brick_mask;
+    }
+
+    /// Row of voxels along `x` at given `y` and `z` packed into bits, bit `x`
+    /// is set if the voxel at `x` is solid.
+    inline auto get_occupancy_row(this Chunk const& self, u32 y, u32 z) noexcept
+        -> u16 {
+        return self.occupancy[Chunk::row_index_of(y, z)];
+    }
+
+    /// Checks that a brick containing `pos` has no non-air voxels.
+    inline auto is_brick_empty(
+        this Chunk const& self, glm::uvec3 pos
+    ) noexcept -> bool {
+        return 0 == (self.brick_mask & (u64{1} << Chunk::brick_index_of(pos)));
+    }
+
+private:
+    static inline auto row_index_of(u32 y, u32 z) noexcept -> usize {
+        return z + Chunk::DEPTH * y;
+    }
+
+    auto brick_has_solid_voxels(
+        this Chunk const& self, glm::uvec3 pos
+    ) noexcept -> bool;
+
 public:
     static auto constexpr N_POSITION_BITS = usize{4};
     static auto constexpr WIDTH = usize{1 << N_POSITION_BITS};
@@ -54,9 +249,28 @@ public:
     static auto constexpr SIZE = glm::uvec3{WIDTH, HEIGHT, DEPTH};
     static auto constexpr VOLUME = WIDTH * HEIGHT * DEPTH;
 
+    /// Chunk is split into cubic bricks each tracked by a single bit of
+    /// `brick_mask`, so that empty space can be skipped without reading voxels.
+    static auto constexpr N_BRICK_BITS = usize{2};
+    static auto constexpr BRICK_SIDE = usize{1 << N_BRICK_BITS};
+    static auto constexpr N_BRICKS_PER_SIDE = WIDTH / BRICK_SIDE;
+
+    static_assert(
+        N_BRICKS_PER_SIDE * N_BRICKS_PER_SIDE * N_BRICKS_PER_SIDE ==
+        8 * sizeof(u64)
+    );
+
+    static_assert(WIDTH <= 8 * sizeof(u16));
+
+    using Layout = std::conditional_t<
+        USE_MORTON_VOXEL_LAYOUT, MortonLayout<N_POSITION_BITS>, LinearLayout>;
+
 private:
     glm::uvec3 pos;
     std::array<Voxel, VOLUME> voxels;
+    std::array<u16, 256> id_counts{};
+    std::array<u16, HEIGHT * DEPTH> occupancy{};
+    u64 brick_mask{0};
 };
 
 struct RayCastResult {
@@ -67,6 +281,48 @@ struct RayCastResult {
     bool has_hit{false};
 };
 
+struct Ray {
+    glm::vec3 origin{0.0f};
+    glm::vec3 direction{0.0f, 0.0f, 1.0f};
+    f32 max_distance{0.0f};
+};
+
+/// Box of voxels that can be pasted into the terrain. Air voxels of the
+/// structure leave the terrain untouched.
+class VoxelStructure {
+public:
+    inline explicit VoxelStructure(glm::uvec3 size)
+    : size{size}
+    , voxels(size.x * size.y * size.z) {}
+
+    inline auto index_of(
+        this VoxelStructure const& self, glm::uvec3 pos
+    ) noexcept -> usize {
+        return pos.x + self.size.x * (pos.z + self.size.z * pos.y);
+    }
+
+    inline auto get_voxel(
+        this VoxelStructure const& self, glm::uvec3 pos
+    ) noexcept -> Voxel {
+        return self.voxels[self.index_of(pos)];
+    }
+
+    inline auto set_voxel(
+        this VoxelStructure& self, glm::uvec3 pos, Voxel value
+    ) noexcept -> void {
+        self.voxels[self.index_of(pos)] = value;
+    }
+
+    inline auto get_size(this VoxelStructure const& self) noexcept
+        -> glm::uvec3 {
+        return self.size;
+    }
+
+private:
+    glm::uvec3 size;
+    std::vector<Voxel> voxels;
+};
+
 class ChunkArray {
 public:
     explicit ChunkArray(glm::uvec3 sizes);
@@ -93,11 +349,226 @@ public:
         this ChunkArray& self, glm::uvec3 voxel_pos, Voxel value
     ) noexcept -> void;
 
+    /// Checks that any voxel in the inclusive range `[lo, hi]` is solid.
+    /// Voxels outside of the array count as air.
+    auto any_solid_in(
+        this ChunkArray const& self, glm::uvec3 lo, glm::uvec3 hi
+    ) noexcept -> bool;
+
+    /// Calls `visit(row_pos, bits)` for every non-empty occupancy row
+    /// clipped to the inclusive range `[lo, hi]`, where `row_pos` is the
+    /// world position of bit 0 of the row. Stops as soon as `visit` returns
+    /// `true`.
+    template <class F>
+    auto visit_solid_rows(
+        this ChunkArray const& self, glm::uvec3 lo, glm::uvec3 hi, F&& visit
+    ) -> bool {
+        auto const world_size = self.size() * Chunk::SIZE;
+
+        if (glm::any(glm::equal(world_size, glm::uvec3{0}))) {
+            return false;
+        }
+
+        hi = glm::min(hi, world_size - 1u);
+
+        if (glm::any(glm::greaterThan(lo, hi))) {
+            return false;
+        }
+
+        auto const chunk_lo = lo / Chunk::SIZE;
+        auto const chunk_hi = hi / Chunk::SIZE;
+
+        for (u32 chunk_y = chunk_lo.y; chunk_y <= chunk_hi.y; ++chunk_y) {
+            for (u32 chunk_z = chunk_lo.z; chunk_z <= chunk_hi.z; ++chunk_z) {
+                for (u32 chunk_x = chunk_lo.x; chunk_x <= chunk_hi.x;
+                     ++chunk_x)
+                {
+                    auto const chunk_pos =
+                        glm::uvec3{chunk_x, chunk_y, chunk_z};
+                    auto const& chunk = *self.chunk(chunk_pos);
+
+                    if (chunk.is_empty()) {
+                        continue;
+                    }
+
+                    auto const base = chunk_pos * Chunk::SIZE;
+                    auto const local_lo = glm::max(lo, base) - base;
+                    auto const local_hi =
+                        glm::min(hi, base + Chunk::SIZE - 1u) - base;
+                    auto const row_mask = (u16) (
+                        ((1u << (local_hi.x - local_lo.x + 1)) - 1u)
+                        << local_lo.x
+                    );
+
+                    for (u32 y = local_lo.y; y <= local_hi.y; ++y) {
+                        for (u32 z = local_lo.z; z <= local_hi.z; ++z) {
+                            auto const bits = (u16) (
+                                chunk.get_occupancy_row(y, z) & row_mask
+                            );
+
+                            if (0 != bits &&
+                                visit(base + glm::uvec3{0, y, z}, bits))
+                            {
+                                return true;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        return false;
+    }
+
+    /// Calls `visit(cell)` for every solid voxel in the inclusive range
+    /// `[lo, hi]`. Voxels outside of the array count as air.
+    template <class F>
+    auto for_each_solid_cell(
+        this ChunkArray const& self, glm::uvec3 lo, glm::uvec3 hi, F&& visit
+    ) -> void {
+        self.visit_solid_rows(
+            lo, hi,
+            [&visit](glm::uvec3 row_pos, u16 bits) {
+                for (; 0 != bits; bits &= (u16) (bits - 1)) {
+                    auto const x = (u32) std::countr_zero(bits);
+                    visit(row_pos + glm::uvec3{x, 0, 0});
+                }
+
+                return false;
+            }
+        );
+    }
+
+    /// Appends positions of all solid voxels in the inclusive range
+    /// `[lo, hi]` to `cells`. Voxels outside of the array count as air.
+    auto solid_cells_in(
+        this ChunkArray const& self, glm::uvec3 lo, glm::uvec3 hi,
+        RefMut<std::vector<glm::uvec3>> cells
+    ) -> void;
+
+    /// Writes `voxel_at(pos)` to every voxel `pos` in the inclusive range
+    /// `[lo, hi]` chunk by chunk, skipping voxels for which it returns
+    /// `std::nullopt` and voxels outside of the array. Calls
+    /// `on_chunk_edited(chunk_pos, local_lo, local_hi)` with local bounds of
+    /// the voxels written in each chunk.
+    template <class F, class G>
+    auto edit_region(
+        this ChunkArray& self, glm::uvec3 lo, glm::uvec3 hi, F&& voxel_at,
+        G&& on_chunk_edited
+    ) -> void {
+        hi = glm::min(hi, self.sizes * Chunk::SIZE - 1u);
+
+        if (glm::any(glm::greaterThan(lo, hi))) {
+            return;
+        }
+
+        auto const chunk_lo = lo / Chunk::SIZE;
+        auto const chunk_hi = hi / Chunk::SIZE;
+
+        for (u32 chunk_y = chunk_lo.y; chunk_y <= chunk_hi.y; ++chunk_y) {
+            for (u32 chunk_z = chunk_lo.z; chunk_z <= chunk_hi.z; ++chunk_z) {
+                for (u32 chunk_x = chunk_lo.x; chunk_x <= chunk_hi.x;
+                     ++chunk_x)
+                {
+                    auto const chunk_pos =
+                        glm::uvec3{chunk_x, chunk_y, chunk_z};
+                    auto const chunk_offset = chunk_pos * Chunk::SIZE;
+                    auto& chunk = *self.chunk(chunk_pos);
+
+                    auto const local_lo =
+                        glm::max(lo, chunk_offset) - chunk_offset;
+                    auto const local_hi =
+                        glm::min(hi, chunk_offset + Chunk::SIZE - 1u) -
+                        chunk_offset;
+
+                    auto edited_lo = Chunk::SIZE;
+                    auto edited_hi = glm::uvec3{0};
+
+                    for (u32 y = local_lo.y; y <= local_hi.y; ++y) {
+                        for (u32 z = local_lo.z; z <= local_hi.z; ++z) {
+                            for (u32 x = local_lo.x; x <= local_hi.x; ++x) {
+                                auto const local_pos = glm::uvec3{x, y, z};
+                                auto const value =
+                                    voxel_at(chunk_offset + local_pos);
+
+                                if (!value.has_value()) {
+                                    continue;
+                                }
+
+                                chunk.set_voxel(local_pos, value.value());
+
+                                edited_lo = glm::min(edited_lo, local_pos);
+                                edited_hi = glm::max(edited_hi, local_pos);
+                            }
+                        }
+                    }
+
+                    if (edited_lo.x <= edited_hi.x) {
+                        on_chunk_edited(chunk_pos, edited_lo, edited_hi);
+                    }
+                }
+            }
+        }
+    }
+
+    /// Sets all voxels in the box from `lo` to `hi` inclusive to `value`,
+    /// reporting edited chunks the same way `edit_region` does.
+    template <class G>
+    auto fill_box(
+        this ChunkArray& self, glm::uvec3 lo, glm::uvec3 hi, Voxel value,
+        G&& on_chunk_edited
+    ) -> void {
+        self.edit_region(
+            lo, hi,
+            [value](glm::uvec3) { return std::optional<Voxel>{value}; },
+            std::forward<G>(on_chunk_edited)
+        );
+    }
+
+    /// Copies non-air voxels of `structure` with its corner placed at `pos`,
+    /// reporting edited chunks the same way `edit_region` does.
+    template <class G>
+    auto paste_structure(
+        this ChunkArray& self, VoxelStructure const& structure,
+        glm::uvec3 pos, G&& on_chunk_edited
+    ) -> void {
+        auto const size = structure.get_size();
+
+        // `pos + size - 1` wraps around on an empty axis
+        if (glm::any(glm::equal(size, glm::uvec3{0}))) {
+            return;
+        }
+
+        self.edit_region(
+            pos, pos + size - 1u,
+            [&structure, pos](glm::uvec3 voxel_pos) -> std::optional<Voxel> {
+                auto const voxel = structure.get_voxel(voxel_pos - pos);
+
+                if (0 == voxel.id) {
+                    return std::nullopt;
+                }
+
+                return voxel;
+            },
+            std::forward<G>(on_chunk_edited)
+        );
+    }
+
+    /// Finds the first solid voxel along the ray. Rays with a zero or
+    /// non-finite direction, origin or distance hit nothing.
     auto ray_cast(
         this ChunkArray const& self, glm::vec3 origin, glm::vec3 direction,
         f32 max_distance
     ) -> RayCastResult;
 
+    /// Casts all `rays` writing `results[i]` the same value `ray_cast` would
+    /// return for `rays[i]`. Rays are traversed in packets and large batches
+    /// are spread across threads.
+    auto ray_cast_batch(
+        this ChunkArray const& self, std::span<Ray const> rays,
+        std::span<RayCastResult> results
+    ) -> void;
+
     inline auto size(this ChunkArray const& self) noexcept -> glm::uvec3 {
         return self.sizes;
     }
@@ -123,6 +594,14 @@ public:
         return self.sizes.x * self.sizes.y * self.sizes.z;
     }
 
+public:
+    static auto constexpr N_TILE_BITS = u32{2};
+    static auto constexpr RAY_PACKET_SIZE = usize{8};
+    static auto constexpr MIN_PARALLEL_RAY_PACKETS = usize{64};
+
+    using Layout = std::conditional_t<
+        USE_MORTON_VOXEL_LAYOUT, MortonLayout<N_TILE_BITS>, LinearLayout>;
+
 private:
     std::unique_ptr<Chunk[]> chunks;
     glm::uvec3 sizes;
@@ -164,19 +643,38 @@ public:
         TerrainRenderUploadMesh upload = TerrainRenderUploadMesh::DoUpload
     ) -> void;
 
+    auto render_opaque(
+        this TerrainRenderer const& self, ChunkArray const& chunks,
+        glm::uvec3 pos, RefMut<MeshVec<Vertex>> result_buffer
+    ) -> void;
+
     auto render_transparent(
         this TerrainRenderer const& self, Chunk const& chunk,
-        ChunkArray const& array, RefMut<TransparentMesh> transparent_mesh,
+        ChunkArray const& array,
+        RefMut<ThreadsafeVec<TransparentVertex>> result_buffer,
         glm::vec3 camera_pos
     ) -> void;
 
+    /// Orders triangles of `vertices` back to front as seen from
+    /// `camera_pos`, so that they blend correctly.
+    static auto sort_transparent_triangles(
+        std::span<TransparentVertex> vertices, glm::vec3 camera_pos
+    ) -> void;
+
     static auto make_empty_mesh() -> Mesh<Vertex>;
 
+    /// Number of translucent voxels in `chunk`, takes time proportional to
+    /// the number of translucent block kinds.
+    auto count_translucent(
+        this TerrainRenderer const& self, Chunk const& chunk
+    ) -> usize;
+
 public:
     static auto constexpr DO_AMBIENT_OCCLUSION = true;
 
 private:
     GameBlocksData data;
+    std::vector<VoxelId> translucent_ids;
 };
 
 }  // namespace tmine
@@ -8,6 +8,8 @@ namespace tmine {
 Chunk::Chunk(glm::uvec3 chunk_pos)
 : pos{chunk_pos}
 , voxels{} {
+    this->id_counts[0] = Chunk::VOLUME;
+
     for (usize local_z = 0; local_z < Chunk::DEPTH; local_z++) {
         for (usize local_x = 0; local_x < Chunk::WIDTH; local_x++) {
             auto const world_x = local_x + chunk_pos.x * Chunk::WIDTH;
@@ -35,7 +37,11 @@ Chunk::Chunk(glm::uvec3 chunk_pos)
 }
 
 auto Chunk::index_of(glm::uvec3 pos) noexcept -> usize {
-    return (pos.y * Chunk::DEPTH + pos.z) * Chunk::WIDTH + pos.x;
+    return Chunk::Layout::index_of(pos, Chunk::SIZE);
+}
+
+auto Chunk::pos_of(usize index) noexcept -> glm::uvec3 {
+    return Chunk::Layout::pos_of(index, Chunk::SIZE);
 }
 
 auto Chunk::is_in_bounds(glm::uvec3 pos) noexcept -> bool {
@@ -57,7 +63,45 @@ auto Chunk::set_voxel(this Chunk& self, glm::uvec3 pos, Voxel value) noexcept ->
         return;
     }
 
-    self.voxels[Chunk::index_of(pos)] = value;
+    auto& voxel = self.voxels[Chunk::index_of(pos)];
+    auto& row = self.occupancy[Chunk::row_index_of(pos.y, pos.z)];
+    auto const was_solid = 0 != voxel.id;
+    auto const brick_bit = u64{1} << Chunk::brick_index_of(pos);
+    auto const row_bit = (u16) (1u << pos.x);
+
+    --self.id_counts[voxel.id];
+    ++self.id_counts[value.id];
+
+    voxel = value;
+
+    if (0 != value.id) {
+        row |= row_bit;
+        self.brick_mask |= brick_bit;
+    } else if (was_solid) {
+        row &= (u16) ~row_bit;
+
+        if (!self.brick_has_solid_voxels(pos)) {
+            self.brick_mask &= ~brick_bit;
+        }
+    }
+}
+
+auto Chunk::brick_has_solid_voxels(
+    this Chunk const& self, glm::uvec3 pos
+) noexcept -> bool {
+    auto const brick_lo = pos & ~glm::uvec3{Chunk::BRICK_SIDE - 1};
+    auto const brick_row_mask =
+        (u16) (((1u << Chunk::BRICK_SIDE) - 1u) << brick_lo.x);
+
+    for (u32 y = brick_lo.y; y < brick_lo.y + Chunk::BRICK_SIDE; ++y) {
+        for (u32 z = brick_lo.z; z < brick_lo.z + Chunk::BRICK_SIDE; ++z) {
+            if (0 != (self.get_occupancy_row(y, z) & brick_row_mask)) {
+                return true;
+            }
+        }
+    }
+
+    return false;
 }
 
 auto height_map_at(glm::uvec2 pos) -> f32 {
@@ -1,16 +1,37 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
 #include "../terrain.hpp"
+#include "../panic.hpp"
+#include "../profiler.hpp"
+#include "../allocations.hpp"
 
 namespace tmine {
 
+static auto allocate_chunks(usize n_chunks) -> Chunk* {
+    auto const allocation_scope = AllocationScope{AllocationTag::Chunks};
+    return (Chunk*) ::operator new[](sizeof(Chunk) * n_chunks);
+}
+
 ChunkArray::ChunkArray(glm::uvec3 sizes)
-: chunks{(Chunk*) ::operator new[](
-      sizeof(this->chunks[0]) * sizes.x * sizes.y * sizes.z
-  )}
+: chunks{allocate_chunks(sizes.x * sizes.y * sizes.z)}
 , sizes{sizes} {
+    if (!ChunkArray::Layout::is_valid_size(sizes)) {
+        throw Panic(
+            "chunk array sizes {}x{}x{} are not supported by the {} layout",
+            sizes.x, sizes.y, sizes.z, ChunkArray::Layout::NAME
+        );
+    }
+
+    tmine_profile_zone("worldgen");
+
     auto const volume = sizes.x * sizes.y * sizes.z;
 
 #pragma omp parallel for
     for (usize i = 0; i < volume; ++i) {
+        tmine_profile_zone("generate_chunk");
+
         auto const pos = this->index_to_pos(i);
 
         new (this->chunks.get() + i) Chunk{pos};
@@ -19,17 +40,12 @@ ChunkArray::ChunkArray(glm::uvec3 sizes)
 
 auto ChunkArray::index_of(this ChunkArray const& self, glm::uvec3 pos) noexcept
     -> usize {
-    return (pos.y * self.sizes.z + pos.z) * self.sizes.x + pos.x;
+    return ChunkArray::Layout::index_of(pos, self.sizes);
 }
 
 auto ChunkArray::index_to_pos(this ChunkArray const& self, usize index) noexcept
     -> glm::uvec3 {
-    usize x = index % self.sizes.x;
-    usize zy = index / self.sizes.x;
-    usize z = zy % self.sizes.z;
-    usize y = zy / self.sizes.z;
-
-    return glm::uvec3{x, y, z};
+    return ChunkArray::Layout::pos_of(index, self.sizes);
 }
 
 auto ChunkArray::is_in_bounds(
@@ -87,104 +103,439 @@ auto ChunkArray::set_voxel(
     chunk->set_voxel(local_pos, value);
 }
 
-auto ChunkArray::ray_cast(
-    this ChunkArray const& self, glm::vec3 origin, glm::vec3 direction,
-    f32 max_distance
-) -> RayCastResult {
-    f32 px = origin.x;
-    f32 py = origin.y;
-    f32 pz = origin.z;
+auto ChunkArray::any_solid_in(
+    this ChunkArray const& self, glm::uvec3 lo, glm::uvec3 hi
+) noexcept -> bool {
+    return self.visit_solid_rows(lo, hi, [](glm::uvec3, u16) {
+        return true;
+    });
+}
+
+auto ChunkArray::solid_cells_in(
+    this ChunkArray const& self, glm::uvec3 lo, glm::uvec3 hi,
+    RefMut<std::vector<glm::uvec3>> cells
+) -> void {
+    self.for_each_solid_cell(lo, hi, [cells](glm::uvec3 cell) {
+        cells->push_back(cell);
+    });
+}
+
+struct RayBoxEntry {
+    f32 distance;
+    i32 axis;
+};
+
+/// Finds a point where ray enters the box `[lo, hi)` not earlier than
+/// `min_distance`.
+static auto ray_enter_box(
+    glm::vec3 origin, glm::vec3 direction, glm::vec3 inv_direction,
+    glm::vec3 lo, glm::vec3 hi, f32 min_distance
+) noexcept -> std::optional<RayBoxEntry> {
+    auto const infinity = std::numeric_limits<f32>::infinity();
+
+    auto enter = -infinity;
+    auto exit = infinity;
+    auto axis = i32{-1};
+    auto exit_axis = i32{-1};
+
+    for (i32 i = 0; i < 3; ++i) {
+        if (0.0f == direction[i]) {
+            if (origin[i] < lo[i] || origin[i] >= hi[i]) {
+                return std::nullopt;
+            }
+
+            continue;
+        }
+
+        auto near = (lo[i] - origin[i]) * inv_direction[i];
+        auto far = (hi[i] - origin[i]) * inv_direction[i];
+
+        if (near > far) {
+            std::swap(near, far);
+        }
+
+        if (near > enter) {
+            enter = near;
+            axis = i;
+        }
+
+        if (far <= exit) {
+            exit = far;
+            exit_axis = i;
+        }
+    }
+
+    // On a tie DDA crosses higher axes first, so the ray still passes
+    // through a cell if it leaves along a lower axis than it enters.
+    if (exit < enter || (exit == enter && exit_axis > axis) ||
+        exit <= min_distance)
+    {
+        return std::nullopt;
+    }
+
+    return RayBoxEntry{
+        .distance = std::max(enter, min_distance),
+        .axis = axis,
+    };
+}
+
+/// Selects an axis with the least distance the same way voxel DDA does.
+static auto min_distance_axis(glm::vec3 distances) noexcept -> i32 {
+    if (distances.x < distances.y) {
+        return distances.x < distances.z ? 0 : 2;
+    } else {
+        return distances.y < distances.z ? 1 : 2;
+    }
+}
+
+/// Cell along one axis that voxel DDA is in at `distance`. Boundaries are
+/// crossed at distances computed the same way as during the traversal, the
+/// one exactly at `distance` is crossed if `is_tie_crossed`. Expects a
+/// non-zero `direction`.
+static auto cell_at_distance(
+    f32 origin, f32 direction, f32 inv_direction, f32 distance,
+    bool is_tie_crossed
+) noexcept -> i32 {
+    auto const is_crossed = [=](i32 boundary) {
+        auto const boundary_distance =
+            ((f32) boundary - origin) * inv_direction;
+
+        return boundary_distance < distance ||
+               (is_tie_crossed && boundary_distance == distance);
+    };
 
-    f32 dx = direction.x;
-    f32 dy = direction.y;
-    f32 dz = direction.z;
+    auto const start = (i32) std::floor(origin);
 
-    f32 t = 0.0f;
-    i32 ix = floor(px);
-    i32 iy = floor(py);
-    i32 iz = floor(pz);
+    // Rounded position is off by at most one cell near boundaries
+    auto cell = (i32) std::floor(origin + distance * direction);
 
-    i32 stepx = (dx > 0.0f) ? 1 : -1;
-    i32 stepy = (dy > 0.0f) ? 1 : -1;
-    i32 stepz = (dz > 0.0f) ? 1 : -1;
+    if (direction > 0.0f) {
+        cell = std::max(cell, start);
 
-    f32 infinity = std::numeric_limits<f32>::infinity();
+        for (; is_crossed(cell + 1); ++cell) {}
+        for (; cell > start && !is_crossed(cell); --cell) {}
+    } else {
+        cell = std::min(cell, start);
 
-    f32 tx_delta = (dx == 0.0f) ? infinity : std::abs(1.0f / dx);
-    f32 ty_delta = (dy == 0.0f) ? infinity : std::abs(1.0f / dy);
-    f32 tz_delta = (dz == 0.0f) ? infinity : std::abs(1.0f / dz);
+        for (; is_crossed(cell); --cell) {}
+        for (; cell < start && !is_crossed(cell + 1); ++cell) {}
+    }
 
-    f32 xdist = (stepx > 0) ? (ix + 1 - px) : (px - ix);
-    f32 ydist = (stepy > 0) ? (iy + 1 - py) : (py - iy);
-    f32 zdist = (stepz > 0) ? (iz + 1 - pz) : (pz - iz);
+    return cell;
+}
 
-    f32 tx_max = (tx_delta < infinity) ? tx_delta * xdist : infinity;
-    f32 ty_max = (ty_delta < infinity) ? ty_delta * ydist : infinity;
-    f32 tz_max = (tz_delta < infinity) ? tz_delta * zdist : infinity;
+/// Largest coordinate that still converts to a cell index without overflow.
+static auto constexpr MAX_RAY_COORDINATE = f32{1 << 24};
+
+/// Rays with a zero or non-finite direction, a non-finite distance or an
+/// origin too far away to index cells can not be traversed and hit nothing.
+static auto is_traversable(Ray const& ray) noexcept -> bool {
+    for (i32 i = 0; i < 3; ++i) {
+        if (!(std::abs(ray.origin[i]) < MAX_RAY_COORDINATE) ||
+            !std::isfinite(ray.direction[i]))
+        {
+            return false;
+        }
+    }
 
-    i32 stepped_index = -1;
+    return std::isfinite(ray.max_distance) &&
+           glm::any(glm::notEqual(ray.direction, glm::vec3{0.0f}));
+}
+
+/// State of `N` rays traversing chunk array simultaneously. Lanes are stored
+/// component-wise so the setup of a packet is done for all lanes at once and
+/// memory latency of one lane is hidden behind steps of others.
+template <usize N>
+struct RayPacket {
+    template <class T>
+    using Lanes = std::array<T, N>;
+
+    std::array<Lanes<f32>, 3> origin;
+    std::array<Lanes<f32>, 3> direction;
+    std::array<Lanes<f32>, 3> inv_direction;
+    std::array<Lanes<i32>, 3> step;
+    std::array<Lanes<i32>, 3> cell;
+    Lanes<f32> max_distance;
+    Lanes<f32> distance;
+    Lanes<i32> stepped_axis;
+    Lanes<Chunk const*> chunk;
+    Lanes<glm::uvec3> chunk_pos;
+    Lanes<bool> is_done;
+    Lanes<RayCastResult> result;
+
+    explicit RayPacket(std::span<Ray const> rays) noexcept {
+        auto const infinity = std::numeric_limits<f32>::infinity();
+
+        for (usize lane = 0; lane < N; ++lane) {
+            auto const is_valid =
+                lane < rays.size() && is_traversable(rays[lane]);
+
+            // Invalid lanes hold a default ray so that no lane converts
+            // non-finite values to integers
+            auto const ray = is_valid ? rays[lane] : Ray{};
+
+            for (usize i = 0; i < 3; ++i) {
+                this->origin[i][lane] = ray.origin[i];
+                this->direction[i][lane] = ray.direction[i];
+            }
 
-    while (t <= max_distance) {
-        auto voxel = self.get_voxel({ix, iy, iz});
+            this->max_distance[lane] = ray.max_distance;
+            this->is_done[lane] = !is_valid;
+            this->result[lane] = RayCastResult{
+                .hit_pos = lane < rays.size() ? rays[lane].origin : ray.origin,
+            };
+        }
+
+        for (usize i = 0; i < 3; ++i) {
+            for (usize lane = 0; lane < N; ++lane) {
+                auto const direction = this->direction[i][lane];
+
+                this->step[i][lane] = direction > 0.0f ? 1 : -1;
+                this->inv_direction[i][lane] =
+                    0.0f == direction ? infinity : 1.0f / direction;
+                this->cell[i][lane] = (i32) std::floor(this->origin[i][lane]);
+            }
+        }
 
-        if (voxel.has_value() && 0 != voxel.value().id) {
+        this->distance.fill(0.0f);
+        this->stepped_axis.fill(-1);
+        this->chunk.fill(nullptr);
+        this->chunk_pos.fill(glm::uvec3{std::numeric_limits<u32>::max()});
+    }
+
+    /// Traverses all lanes until each of them either hits or misses.
+    auto cast(this RayPacket& self, ChunkArray const& chunks) noexcept
+        -> void {
+        auto n_active =
+            std::count(self.is_done.begin(), self.is_done.end(), false);
+
+        while (0 != n_active) {
+            for (usize lane = 0; lane < N; ++lane) {
+                if (!self.is_done[lane]) {
+                    self.step_lane(chunks, lane);
+                    n_active -= self.is_done[lane];
+                }
+            }
+        }
+    }
+
+    /// Performs one step of hierarchical DDA: checks the current cell and
+    /// jumps over the largest empty cube containing it.
+    auto step_lane(
+        this RayPacket& self, ChunkArray const& chunks, usize lane
+    ) noexcept -> void {
+        auto const infinity = std::numeric_limits<f32>::infinity();
+
+        auto const origin = self.get(self.origin, lane);
+        auto const direction = self.get(self.direction, lane);
+        auto const inv_direction = self.get(self.inv_direction, lane);
+        auto const step = self.get(self.step, lane);
+        auto const world_size = glm::ivec3{chunks.size() * Chunk::SIZE};
+
+        auto cell = self.get(self.cell, lane);
+        auto& distance = self.distance[lane];
+        auto& stepped_axis = self.stepped_axis[lane];
+
+        if (distance > self.max_distance[lane]) {
+            self.miss(lane);
+            return;
+        }
+
+        auto const is_in_world =
+            glm::all(glm::greaterThanEqual(cell, glm::ivec3{0})) &&
+            glm::all(glm::lessThan(cell, world_size));
+
+        // Whole space outside of the world is empty, so jump directly to the
+        // point where the ray enters the world, if it does so.
+        if (!is_in_world) {
+            auto const entry = ray_enter_box(
+                origin, direction, inv_direction, glm::vec3{0.0f},
+                glm::vec3{world_size}, distance
+            );
+
+            if (!entry.has_value()) {
+                self.miss(lane);
+                return;
+            }
+
+            distance = entry->distance;
+            stepped_axis = entry->axis;
+
+            // Ties go to the lowest axis, the last one DDA would cross
+            for (i32 i = 0; i < 3; ++i) {
+                if (0.0f != direction[i]) {
+                    cell[i] = cell_at_distance(
+                        origin[i], direction[i], inv_direction[i], distance,
+                        i >= stepped_axis
+                    );
+                }
+            }
+
+            cell = glm::clamp(cell, glm::ivec3{0}, world_size - 1);
+            self.set(&self.cell, lane, cell);
+
+            return;
+        }
+
+        auto const voxel_pos = glm::uvec3{cell};
+        auto& chunk = self.chunk[lane];
+
+        if (voxel_pos / Chunk::SIZE != self.chunk_pos[lane]) {
+            self.chunk_pos[lane] = voxel_pos / Chunk::SIZE;
+            chunk = &chunks.as_span()[chunks.index_of(self.chunk_pos[lane])];
+        }
+
+        auto const local_pos = voxel_pos % Chunk::SIZE;
+
+        // Size of an empty cube containing the current cell
+        auto block_size = i32{1};
+
+        if (chunk->is_empty()) {
+            block_size = Chunk::WIDTH;
+        } else if (chunk->is_brick_empty(local_pos)) {
+            block_size = Chunk::BRICK_SIDE;
+        } else if (auto const voxel = chunk->get_voxel_unchecked(local_pos);
+                   0 != voxel.id)
+        {
             auto normal = glm::vec3{0.0f};
 
-            switch (stepped_index) {
-            case 0:
-                normal.x = -stepx;
-                break;
-            case 1:
-                normal.y = -stepy;
-                break;
-            case 2:
-                normal.z = -stepz;
-                break;
-            default:
-                break;
+            if (-1 != stepped_axis) {
+                normal[stepped_axis] = (f32) -step[stepped_axis];
             }
 
-            return RayCastResult{
-                .voxel = voxel.value(),
-                .voxel_pos = {ix, iy, iz},
-                .hit_pos = glm::vec3{px + t * dx, py + t * dy, pz + t * dz},
+            self.is_done[lane] = true;
+            self.result[lane] = RayCastResult{
+                .voxel = voxel,
+                .voxel_pos = voxel_pos,
+                .hit_pos = origin + distance * direction,
                 .normal = normal,
                 .has_hit = true,
             };
+
+            return;
         }
 
-        if (tx_max < ty_max) {
-            if (tx_max < tz_max) {
-                ix += stepx;
-                t = tx_max;
-                tx_max += tx_delta;
-                stepped_index = 0;
-            } else {
-                iz += stepz;
-                t = tz_max;
-                tz_max += tz_delta;
-                stepped_index = 2;
+        auto const block_lo = (cell / block_size) * block_size;
+        auto const block_hi = block_lo + block_size - 1;
+
+        auto exit_distances = glm::vec3{infinity};
+
+        for (i32 i = 0; i < 3; ++i) {
+            if (0.0f == direction[i]) {
+                continue;
             }
-        } else {
-            if (ty_max < tz_max) {
-                iy += stepy;
-                t = ty_max;
-                ty_max += ty_delta;
-                stepped_index = 1;
-            } else {
-                iz += stepz;
-                t = tz_max;
-                tz_max += tz_delta;
-                stepped_index = 2;
+
+            auto const boundary = step[i] > 0 ? block_hi[i] + 1 : block_lo[i];
+
+            exit_distances[i] =
+                ((f32) boundary - origin[i]) * inv_direction[i];
+        }
+
+        stepped_axis = min_distance_axis(exit_distances);
+        distance = exit_distances[stepped_axis];
+
+        // Lands in the same cell as stepping voxel by voxel would, ties go to
+        // higher axes as in `min_distance_axis`
+        if (block_size > 1) {
+            for (i32 i = 0; i < 3; ++i) {
+                if (i != stepped_axis && 0.0f != direction[i]) {
+                    cell[i] = std::clamp(
+                        cell_at_distance(
+                            origin[i], direction[i], inv_direction[i],
+                            distance, i > stepped_axis
+                        ),
+                        block_lo[i], block_hi[i]
+                    );
+                }
             }
         }
+
+        cell[stepped_axis] = step[stepped_axis] > 0 ? block_hi[stepped_axis] + 1
+                                                    : block_lo[stepped_axis] - 1;
+
+        self.set(&self.cell, lane, cell);
+    }
+
+    auto miss(this RayPacket& self, usize lane) noexcept -> void {
+        auto const end_pos = self.get(self.origin, lane) +
+                             self.max_distance[lane] *
+                                 self.get(self.direction, lane);
+
+        auto const end_cell = glm::clamp(
+            glm::floor(end_pos), glm::vec3{-MAX_RAY_COORDINATE},
+            glm::vec3{MAX_RAY_COORDINATE}
+        );
+
+        self.is_done[lane] = true;
+        self.result[lane] = RayCastResult{
+            .voxel_pos = glm::uvec3{glm::ivec3{end_cell}},
+            .hit_pos = end_pos,
+            .has_hit = false,
+        };
+    }
+
+    template <class T>
+    static auto get(std::array<Lanes<T>, 3> const& lanes, usize lane) noexcept
+        -> glm::vec<3, T> {
+        return glm::vec<3, T>{lanes[0][lane], lanes[1][lane], lanes[2][lane]};
     }
 
-    return RayCastResult{
-        .voxel_pos = glm::ivec3{ix, iy, iz},
-        .hit_pos = glm::vec3{px + t * dx, py + t * dy, pz + t * dz},
-        .has_hit = false,
+    template <class T>
+    static auto set(
+        RefMut<std::array<Lanes<T>, 3>> lanes, usize lane, glm::vec<3, T> value
+    ) noexcept -> void {
+        for (usize i = 0; i < 3; ++i) {
+            (*lanes)[i][lane] = value[i];
+        }
+    }
+};
+
+auto ChunkArray::ray_cast(
+    this ChunkArray const& self, glm::vec3 origin, glm::vec3 direction,
+    f32 max_distance
+) -> RayCastResult {
+    auto const ray = Ray{
+        .origin = origin,
+        .direction = direction,
+        .max_distance = max_distance,
     };
+
+    auto packet = RayPacket<1>{std::span{&ray, 1}};
+    packet.cast(self);
+
+    return packet.result[0];
+}
+
+auto ChunkArray::ray_cast_batch(
+    this ChunkArray const& self, std::span<Ray const> rays,
+    std::span<RayCastResult> results
+) -> void {
+    if (rays.size() != results.size()) {
+        throw Panic(
+            "ray cast batch got {} rays but {} result slots", rays.size(),
+            results.size()
+        );
+    }
+
+    auto const n_packets =
+        (rays.size() + ChunkArray::RAY_PACKET_SIZE - 1) /
+        ChunkArray::RAY_PACKET_SIZE;
+
+#pragma omp parallel for schedule(dynamic, 4) \
+    if (n_packets >= ChunkArray::MIN_PARALLEL_RAY_PACKETS)
+    for (usize i = 0; i < n_packets; ++i) {
+        auto const start = i * ChunkArray::RAY_PACKET_SIZE;
+        auto const count =
+            std::min(ChunkArray::RAY_PACKET_SIZE, rays.size() - start);
+
+        auto packet = RayPacket<ChunkArray::RAY_PACKET_SIZE>{
+            rays.subspan(start, count)
+        };
+
+        packet.cast(self);
+
+        std::copy_n(packet.result.begin(), count, results.begin() + start);
+    }
 }
 
 }  // namespace tmine
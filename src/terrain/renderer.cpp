@@ -1,4 +1,7 @@
+#include <algorithm>
+
 #include "../terrain.hpp"
+#include "../panic.hpp"
 
 namespace tmine {
 
@@ -253,12 +256,68 @@ static auto is_opaque(
 }
 
 TerrainRenderer::TerrainRenderer(GameBlocksData data) noexcept
-: data{std::move(data)} {}
+: data{std::move(data)} {
+    for (usize id = 1; id < this->data.blocks.size(); ++id) {
+        if (this->data.blocks[id][0].is_translucent()) {
+            this->translucent_ids.push_back((VoxelId) id);
+        }
+    }
+}
+
+auto TerrainRenderer::count_translucent(
+    this TerrainRenderer const& self, Chunk const& chunk
+) -> usize {
+    auto result = usize{0};
+
+    for (auto const id : self.translucent_ids) {
+        result += chunk.count_of(id);
+    }
+
+    return result;
+}
+
+/// Checks that no face of a chunk at `pos` can be seen: the chunk and all
+/// of its neighbours are completely filled with opaque voxels.
+static auto is_fully_occluded(
+    TerrainRenderer const& renderer, ChunkArray const& chunks, glm::uvec3 pos
+) -> bool {
+    auto is_opaque_chunk = [&](glm::ivec3 pos) {
+        auto const chunk = chunks.chunk(glm::uvec3{pos});
+
+        return nullptr != chunk && chunk->is_full() &&
+               0 == renderer.count_translucent(*chunk);
+    };
+
+    auto const center = glm::ivec3{pos};
+
+    return is_opaque_chunk(center) &&
+           is_opaque_chunk(center + glm::ivec3{1, 0, 0}) &&
+           is_opaque_chunk(center - glm::ivec3{1, 0, 0}) &&
+           is_opaque_chunk(center + glm::ivec3{0, 1, 0}) &&
+           is_opaque_chunk(center - glm::ivec3{0, 1, 0}) &&
+           is_opaque_chunk(center + glm::ivec3{0, 0, 1}) &&
+           is_opaque_chunk(center - glm::ivec3{0, 0, 1});
+}
 
 auto TerrainRenderer::render_opaque(
     this TerrainRenderer const& self, ChunkArray const& chunks, glm::uvec3 pos,
     RefMut<Mesh<TerrainRenderer::Vertex>> result_mesh,
     TerrainRenderUploadMesh upload
+) -> void {
+    if (!chunks.is_in_bounds(pos)) {
+        return;
+    }
+
+    self.render_opaque(chunks, pos, &result_mesh->get_buffer());
+
+    if (TerrainRenderUploadMesh::DoUpload == upload) {
+        result_mesh->reload_buffer();
+    }
+}
+
+auto TerrainRenderer::render_opaque(
+    this TerrainRenderer const& self, ChunkArray const& chunks, glm::uvec3 pos,
+    RefMut<MeshVec<TerrainRenderer::Vertex>> result_buffer
 ) -> void {
     auto chunk = chunks.chunk(pos);
 
@@ -268,9 +327,13 @@ auto TerrainRenderer::render_opaque(
 
     f32 ao_factor = 0.15f;
 
-    auto& buffer = result_mesh->get_buffer();
+    auto& buffer = *result_buffer;
     buffer.clear();
 
+    if (chunk->is_empty() || is_fully_occluded(self, chunks, pos)) {
+        return;
+    }
+
     for (u32 y = 0; y < Chunk::HEIGHT; y++) {
         for (u32 z = 0; z < Chunk::DEPTH; z++) {
             for (u32 x = 0; x < Chunk::WIDTH; x++) {
@@ -776,17 +839,18 @@ auto TerrainRenderer::render_opaque(
             }
         }
     }
-
-    if (TerrainRenderUploadMesh::DoUpload == upload) {
-        result_mesh->reload_buffer();
-    }
 }
 
 auto TerrainRenderer::render_transparent(
     this TerrainRenderer const& self, Chunk const& chunk,
-    ChunkArray const& array, RefMut<TransparentMesh> transparent_mesh, glm::vec3 camera_pos
+    ChunkArray const& array,
+    RefMut<ThreadsafeVec<TransparentVertex>> result_buffer, glm::vec3 camera_pos
 ) -> void {
-    auto& buffer = transparent_mesh->get_buffer();
+    if (0 == self.count_translucent(chunk)) {
+        return;
+    }
+
+    auto& buffer = *result_buffer;
 
     for (u32 y = 0; y < Chunk::HEIGHT; y++) {
         for (u32 z = 0; z < Chunk::DEPTH; z++) {
@@ -819,4 +883,42 @@ auto TerrainRenderer::render_transparent(
     }
 }
 
+auto TerrainRenderer::sort_transparent_triangles(
+    std::span<TransparentVertex> vertices, glm::vec3 camera_pos
+) -> void {
+    if (vertices.size() % 3 != 0) {
+        throw Panic("transparent mesh size should be divisible by 3");
+    }
+
+    struct Triangle {
+        std::array<TerrainRenderer::TransparentVertex, 3> vertices;
+    };
+
+    auto triangles = std::span<Triangle>{
+        reinterpret_cast<Triangle*>(vertices.data()),
+        reinterpret_cast<Triangle*>(vertices.data() + vertices.size())
+    };
+
+    auto manhattan_comparator =
+        [camera_pos](auto const& left, auto const& right) {
+            auto pos = 3.0f * camera_pos;
+
+            auto left_center = left.vertices[0].pos + left.vertices[1].pos +
+                               left.vertices[2].pos;
+            auto left_distance = glm::abs(pos.x - left_center.x) +
+                                 glm::abs(pos.y - left_center.y) +
+                                 glm::abs(pos.z - left_center.z);
+
+            auto right_center = right.vertices[0].pos + right.vertices[1].pos +
+                                right.vertices[2].pos;
+            auto right_distance = glm::abs(pos.x - right_center.x) +
+                                  glm::abs(pos.y - right_center.y) +
+                                  glm::abs(pos.z - right_center.z);
+
+            return left_distance > right_distance;
+        };
+
+    std::ranges::sort(triangles, manhattan_comparator);
+}
+
 }  // namespace tmine
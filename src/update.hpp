@@ -2,42 +2,78 @@
 
 #include <concepts>
 #include <chrono>
+#include <functional>
+#include <utility>
+#include <vector>
 
 #include "types.hpp"
 
 namespace tmine {
 
+/// Runs registered systems at a fixed tick rate, independent of the frame
+/// rate.
 class FixedUpdater {
 public:
-    explicit FixedUpdater(f32 time_step = DEFAULT_TIME_STEP);
+    using System = std::function<void(f32)>;
 
-    auto fixed_update(this FixedUpdater& self, std::invocable<f32> auto update)
+    explicit FixedUpdater(
+        f32 tick_rate = DEFAULT_TICK_RATE,
+        u32 max_ticks_per_frame = DEFAULT_MAX_TICKS_PER_FRAME
+    );
+
+    /// Registers `system` to run every tick after all systems registered
+    /// before it.
+    auto add_system(this FixedUpdater& self, std::invocable<f32> auto system)
         -> void {
-        auto duration = self.previous_frame_reminder + self.frame_duration;
+        self.systems.emplace_back(std::move(system));
+    }
+
+    auto start_new_frame(this FixedUpdater& self) -> void;
+
+    /// Runs the systems once for every whole tick of time passed in frames
+    /// since the previous call. At most `max_ticks_per_frame` ticks are run,
+    /// time beyond that is dropped, so that slow machines run the game
+    /// slower instead of stalling on ever more ticks. Returns the number of
+    /// ticks run.
+    auto run_ticks(this FixedUpdater& self) -> u32;
 
-        while (self.time_step < duration) {
-            duration -= self.time_step;
-            update(self.time_step);
-        }
+    /// Runs the systems once, regardless of the time passed.
+    auto tick(this FixedUpdater& self) -> void;
 
-        self.current_frame_reminder = duration;
+    /// Fraction of the next tick already passed, used to interpolate render
+    /// state between the last two ticks.
+    inline auto get_interpolation_alpha(this FixedUpdater const& self) noexcept
+        -> f32 {
+        return self.accumulated_time / self.time_step;
     }
 
     inline auto get_time_step(this FixedUpdater const& self) noexcept -> f32 {
         return self.time_step;
     }
 
-    auto start_new_frame(this FixedUpdater& self) -> void;
+    inline auto set_tick_rate(this FixedUpdater& self, f32 tick_rate) noexcept
+        -> void {
+        self.time_step = 1.0f / tick_rate;
+    }
+
+    inline auto set_max_ticks_per_frame(
+        this FixedUpdater& self, u32 max_ticks_per_frame
+    ) noexcept -> void {
+        self.max_ticks_per_frame = max_ticks_per_frame;
+    }
 
 public:
-    static auto constexpr DEFAULT_UPDATE_COUNT = 20.0f;
-    static auto constexpr DEFAULT_TIME_STEP = 1.0f / 60.0f / DEFAULT_UPDATE_COUNT;
+    static auto constexpr DEFAULT_TICK_RATE = 120.0f;
+    static auto constexpr DEFAULT_TIME_STEP = 1.0f / DEFAULT_TICK_RATE;
+    static auto constexpr DEFAULT_MAX_TICKS_PER_FRAME = u32{8};
 
 private:
-    f32 time_step{DEFAULT_TIME_STEP};
-    f32 previous_frame_reminder{0.0f};
-    f32 current_frame_reminder{0.0f};
-    f32 frame_duration{DEFAULT_UPDATE_COUNT * DEFAULT_TIME_STEP};
+    std::vector<System> systems;
+    f32 time_step;
+    u32 max_ticks_per_frame;
+    f32 accumulated_time{0.0f};
+    f32 frame_duration{0.0f};
+    u32 n_dropped_ticks{0};
     std::chrono::time_point<std::chrono::high_resolution_clock> prev_time;
 };
 
@@ -5,20 +5,55 @@
 
 namespace tmine {
 
-FixedUpdater::FixedUpdater(f32 time_step)
-: time_step{time_step}
+FixedUpdater::FixedUpdater(f32 tick_rate, u32 max_ticks_per_frame)
+: time_step{1.0f / tick_rate}
+, max_ticks_per_frame{max_ticks_per_frame}
 , prev_time{std::chrono::high_resolution_clock::now()} {}
 
 auto FixedUpdater::start_new_frame(this FixedUpdater& self) -> void {
-    self.previous_frame_reminder = self.current_frame_reminder;
-
     auto const now = std::chrono::high_resolution_clock::now();
     self.frame_duration =
         std::chrono::duration<f32>{now - self.prev_time}.count();
     self.prev_time = now;
 
-    debug::text()->set(
-        "fps", fmt::format("FPS: {:.1f}", 1.0f / self.frame_duration)
+    debug::text()->set_formatted(
+        "fps", "FPS: {:.1f}", 1.0f / self.frame_duration
+    );
+}
+
+auto FixedUpdater::run_ticks(this FixedUpdater& self) -> u32 {
+    self.accumulated_time += self.frame_duration;
+
+    auto n_ticks = (u32) (self.accumulated_time / self.time_step);
+
+    if (n_ticks > self.max_ticks_per_frame) {
+        self.n_dropped_ticks += n_ticks - self.max_ticks_per_frame;
+        self.accumulated_time -=
+            (f32) (n_ticks - self.max_ticks_per_frame) * self.time_step;
+        n_ticks = self.max_ticks_per_frame;
+    }
+
+    for (u32 i = 0; i < n_ticks; ++i) {
+        self.tick();
+    }
+
+    self.accumulated_time = glm::clamp(
+        self.accumulated_time - (f32) n_ticks * self.time_step, 0.0f,
+        self.time_step
+    );
+
+    debug::text()->set_formatted(
+        "ticks", "Ticks: {} per frame, {} dropped", n_ticks,
+        self.n_dropped_ticks
     );
+
+    return n_ticks;
 }
+
+auto FixedUpdater::tick(this FixedUpdater& self) -> void {
+    for (auto& system : self.systems) {
+        system(self.time_step);
+    }
+}
+
 }  // namespace tmine
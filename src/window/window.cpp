@@ -2,6 +2,7 @@
 
 #include "../window.hpp"
 #include "../events.hpp"
+#include "../metrics.hpp"
 #include "../panic.hpp"
 
 namespace tmine {
@@ -122,6 +123,8 @@ auto Window::toggle_cursor_visibility(this Window& self) -> void {
 auto Window::finish_frame(this Window& self) noexcept -> void {
     io.update();
     self.swap_buffers();
+
+    auto const timing = ScopedTiming{Timing::Input};
     self.poll_events();
 }
 
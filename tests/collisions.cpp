@@ -0,0 +1,433 @@
+#include <memory>
+#include <random>
+#include <vector>
+
+#ifdef _OPENMP
+#    include <omp.h>
+#endif
+
+#include "terrain.hpp"
+#include "physics.hpp"
+#include "collisions.hpp"
+#include "assert.hpp"
+
+namespace tmine_test {
+
+using namespace tmine;
+
+auto constexpr TIME_STEP = 1.0f / 60.0f;
+auto constexpr FLOOR_HEIGHT = u32{10};
+auto constexpr BOX_SIZE = glm::vec3{0.6f, 1.8f, 0.6f};
+auto constexpr GRAVITY = glm::vec3{0.0f, -30.0f, 0.0f};
+
+/// Makes a world with a single solid floor layer on `FLOOR_HEIGHT`.
+static auto make_flat_world() -> std::shared_ptr<ChunkArray> {
+    auto chunks = std::make_shared<ChunkArray>(glm::uvec3{4, 4, 4});
+    auto const world_size = chunks->size() * Chunk::SIZE;
+
+    for (u32 y = 0; y < world_size.y; ++y) {
+        for (u32 z = 0; z < world_size.z; ++z) {
+            for (u32 x = 0; x < world_size.x; ++x) {
+                auto const id = VoxelId{y == FLOOR_HEIGHT ? u8{1} : u8{0}};
+                chunks->set_voxel({x, y, z}, Voxel{id, 0});
+            }
+        }
+    }
+
+    return chunks;
+}
+
+static auto spawn_box(
+    RefMut<PhysicsSolver> solver, glm::vec3 pos, glm::vec3 velocity
+) -> ColliderId {
+    return solver->add(BoxCollider{
+        .box = Aabb{pos, pos + BOX_SIZE},
+        .velocity = velocity,
+        .acceleration = GRAVITY,
+        .elasticity = ABSOLUTELY_INELASTIC_ELASTICITY,
+    });
+}
+
+auto test_high_speed_fall() -> void {
+    auto const chunks = make_flat_world();
+    auto solver = PhysicsSolver{};
+
+    solver.register_collidable<TerrainCollider>(chunks);
+
+    // Box falls 5 voxels per tick, far more than its own height
+    auto const id = spawn_box(
+        &solver, glm::vec3{20.2f, 50.0f, 30.7f},
+        glm::vec3{0.0f, -300.0f, 0.0f}
+    );
+
+    for (usize i = 0; i < 120; ++i) {
+        solver.update(TIME_STEP);
+
+        auto const box = solver.get_box_collider(id).get_box();
+        tmine_assert(box.lo.y >= (f32) FLOOR_HEIGHT + 0.999f, "tick {}", i);
+    }
+
+    auto const collider = solver.get_box_collider(id);
+
+    tmine_assert(
+        glm::abs(collider.get_box().lo.y - (f32) (FLOOR_HEIGHT + 1)) < 1e-3f
+    );
+    tmine_assert(glm::abs(collider.get_velocity().y) < 1.0f);
+}
+
+auto test_wall_slide() -> void {
+    auto constexpr WALL_X = u32{30};
+
+    auto const chunks = make_flat_world();
+
+    for (u32 y = FLOOR_HEIGHT + 1; y < FLOOR_HEIGHT + 6; ++y) {
+        for (u32 z = 0; z < Chunk::DEPTH * chunks->size().z; ++z) {
+            chunks->set_voxel({WALL_X, y, z}, Voxel{1, 0});
+        }
+    }
+
+    auto solver = PhysicsSolver{};
+    solver.register_collidable<TerrainCollider>(chunks);
+
+    auto const start = glm::vec3{25.2f, (f32) FLOOR_HEIGHT + 1.0f, 10.3f};
+    auto const id =
+        spawn_box(&solver, start, glm::vec3{120.0f, 0.0f, 6.0f});
+
+    for (usize i = 0; i < 60; ++i) {
+        solver.update(TIME_STEP);
+
+        auto const box = solver.get_box_collider(id).get_box();
+        tmine_assert(box.hi.x <= (f32) WALL_X + 1e-3f, "tick {}", i);
+    }
+
+    auto const box = solver.get_box_collider(id).get_box();
+
+    tmine_assert(glm::abs(box.hi.x - (f32) WALL_X) < 1e-3f);
+    tmine_assert(glm::abs(box.lo.y - start.y) < 1e-3f);
+    tmine_assert(box.lo.z - start.z > 5.0f);
+}
+
+auto test_resting_box_sleeps_and_wakes() -> void {
+    auto const chunks = make_flat_world();
+    auto solver = PhysicsSolver{};
+
+    solver.register_collidable<TerrainCollider>(chunks);
+
+    auto const start = glm::vec3{20.2f, (f32) FLOOR_HEIGHT + 1.0f, 30.7f};
+    auto const id = spawn_box(&solver, start, glm::vec3{0.0f});
+
+    for (usize i = 0; i < 60; ++i) {
+        solver.update(TIME_STEP);
+    }
+
+    tmine_assert(solver.is_sleeping(id));
+    tmine_assert(solver.get_box_collider(id).get_box().lo == start);
+
+    // Dig a hole under the box, it should wake up and fall into it
+    auto const hole_lo = glm::uvec3{19, FLOOR_HEIGHT, 29};
+    auto const hole_hi = glm::uvec3{22, FLOOR_HEIGHT, 32};
+
+    for (u32 z = hole_lo.z; z <= hole_hi.z; ++z) {
+        for (u32 x = hole_lo.x; x <= hole_hi.x; ++x) {
+            chunks->set_voxel({x, FLOOR_HEIGHT, z}, Voxel{});
+        }
+    }
+
+    solver.wake_in(Aabb{glm::vec3{hole_lo}, glm::vec3{hole_hi + 1u}});
+    tmine_assert(!solver.is_sleeping(id));
+
+    for (usize i = 0; i < 10; ++i) {
+        solver.update(TIME_STEP);
+    }
+
+    tmine_assert(solver.get_box_collider(id).get_box().lo.y < start.y - 0.1f);
+}
+
+auto test_falling_box_wakes_sleeping_one() -> void {
+    auto const chunks = make_flat_world();
+    auto solver = PhysicsSolver{};
+
+    solver.register_collidable<TerrainCollider>(chunks);
+
+    auto const bottom_pos = glm::vec3{20.2f, (f32) FLOOR_HEIGHT + 1.0f, 30.7f};
+    auto const bottom = spawn_box(&solver, bottom_pos, glm::vec3{0.0f});
+
+    for (usize i = 0; i < 60; ++i) {
+        solver.update(TIME_STEP);
+    }
+
+    tmine_assert(solver.is_sleeping(bottom));
+
+    auto const top = spawn_box(
+        &solver, bottom_pos + glm::vec3{0.1f, 5.0f, 0.1f}, glm::vec3{0.0f}
+    );
+
+    auto was_woken = false;
+
+    for (usize i = 0; i < 120; ++i) {
+        solver.update(TIME_STEP);
+        was_woken |= !solver.is_sleeping(bottom);
+    }
+
+    tmine_assert(was_woken);
+
+    auto const top_box = solver.get_box_collider(top).get_box();
+    tmine_assert(top_box.lo.y > bottom_pos.y + BOX_SIZE.y - 0.1f);
+}
+
+static auto project(glm::vec3 source, glm::vec3 direction) -> glm::vec3 {
+    return glm::dot(source, direction) / glm::dot(direction, direction) *
+           direction;
+}
+
+/// Straightforward all-pairs solver over an array of boxes, mirrors the
+/// behaviour `PhysicsSolver` had when colliders were virtual objects.
+static auto reference_update(
+    RefMut<std::vector<BoxCollider>> colliders, f32 time_step
+) -> void {
+    for (auto& collider : *colliders) {
+        if (!collider.is_dynamic) {
+            continue;
+        }
+
+        collider.velocity =
+            time_step * collider.acceleration + collider.velocity;
+        collider.box.lo += time_step * collider.velocity;
+        collider.box.hi += time_step * collider.velocity;
+    }
+
+    auto const boxes = [&] {
+        auto result = std::vector<Aabb>{};
+
+        for (auto const& collider : *colliders) {
+            result.push_back(collider.box);
+        }
+
+        return result;
+    }();
+
+    for (usize i = 0; i < colliders->size(); ++i) {
+        for (usize j = i + 1; j < colliders->size(); ++j) {
+            auto& first = (*colliders)[i];
+            auto& second = (*colliders)[j];
+
+            if (!first.is_dynamic && !second.is_dynamic) {
+                continue;
+            }
+
+            if (boxes[i].intersection(boxes[j]).is_empty()) {
+                continue;
+            }
+
+            auto const elasticity =
+                glm::min(first.elasticity, second.elasticity);
+
+            if (!first.is_dynamic || !second.is_dynamic) {
+                auto& dynamic = first.is_dynamic ? first : second;
+                auto const& fixed = first.is_dynamic ? second : first;
+                auto const displacement =
+                    collide_static_box(fixed.box, dynamic.box)
+                        .other_displacement;
+
+                if (glm::vec3{0.0f} == displacement) {
+                    continue;
+                }
+
+                dynamic.box.lo += displacement;
+                dynamic.box.hi += displacement;
+                dynamic.velocity -= (1.0f + elasticity) *
+                                    project(dynamic.velocity, displacement);
+
+                continue;
+            }
+
+            auto const intersection = first.box.intersection(second.box);
+
+            if (intersection.is_empty()) {
+                continue;
+            }
+
+            auto const size = intersection.size();
+            auto const signs =
+                glm::sign(second.box.center() - first.box.center());
+            auto const first_mass = first.box.volume();
+            auto const second_mass = second.box.volume();
+            auto const total_mass = first_mass + second_mass;
+
+            auto axis = 2;
+
+            if (size.x <= size.y && size.x <= size.z) {
+                axis = 0;
+            } else if (size.y <= size.x && size.y <= size.z) {
+                axis = 1;
+            }
+
+            auto first_displacement = glm::vec3{0.0f};
+            auto second_displacement = glm::vec3{0.0f};
+            first_displacement[axis] =
+                -signs[axis] * size[axis] * second_mass / total_mass;
+            second_displacement[axis] =
+                signs[axis] * size[axis] * first_mass / total_mass;
+
+            if (glm::vec3{0.0f} == first_displacement &&
+                glm::vec3{0.0f} == second_displacement)
+            {
+                continue;
+            }
+
+            first.box.lo += first_displacement;
+            first.box.hi += first_displacement;
+            second.box.lo += second_displacement;
+            second.box.hi += second_displacement;
+
+            auto const first_parallel =
+                project(first.velocity, first_displacement);
+            auto const second_parallel =
+                project(second.velocity, second_displacement);
+
+            auto elastic_velocity = [](f32 m1, f32 m2, glm::vec3 v1,
+                                       glm::vec3 v2) -> glm::vec3 {
+                return ((m1 - m2) * v1 + 2.0f * m2 * v2) / (m1 + m2);
+            };
+
+            first.velocity += (1.0f + elasticity) *
+                              elastic_velocity(
+                                  first_mass, second_mass, first_parallel,
+                                  second_parallel
+                              );
+            second.velocity += (1.0f + elasticity) *
+                               elastic_velocity(
+                                   second_mass, first_mass, second_parallel,
+                                   first_parallel
+                               );
+        }
+    }
+}
+
+auto test_solver_matches_reference() -> void {
+    auto constexpr N_TICKS = usize{200};
+    auto constexpr TOLERANCE = 1e-4f;
+
+    auto colliders = std::vector<BoxCollider>{
+        BoxCollider{
+            .box = Aabb{glm::vec3{-20.0f, 0.0f, -20.0f},
+                        glm::vec3{20.0f, 1.0f, 20.0f}},
+            .elasticity = 0.5f,
+            .is_dynamic = false,
+        },
+    };
+
+    for (u32 i = 0; i < 6; ++i) {
+        auto const lo = glm::vec3{
+            1.3f * (f32) i - 3.1f, 2.0f + 0.7f * (f32) i, 0.25f * (f32) (i % 3)
+        };
+        auto const size = glm::vec3{1.0f + 0.1f * (f32) i, 1.0f, 0.8f};
+
+        colliders.push_back(BoxCollider{
+            .box = Aabb{lo, lo + size},
+            .velocity = glm::vec3{(i % 2 == 0 ? 3.0f : -3.0f), 0.0f, 0.5f},
+            .acceleration = GRAVITY,
+            .elasticity = 0.3f,
+        });
+    }
+
+    auto solver = PhysicsSolver{};
+    auto ids = std::vector<ColliderId>{};
+
+    // Reference keeps integrating resting boxes
+    solver.set_allow_sleeping(false);
+
+    for (auto const& collider : colliders) {
+        ids.push_back(solver.add(collider));
+    }
+
+    for (usize tick = 0; tick < N_TICKS; ++tick) {
+        solver.update(TIME_STEP);
+        reference_update(&colliders, TIME_STEP);
+
+        for (usize i = 1; i < colliders.size(); ++i) {
+            auto const collider = solver.get_box_collider(ids[i]);
+            auto const box = collider.get_box();
+            auto const& expected = colliders[i];
+
+            auto const error = glm::max(
+                glm::max(
+                    glm::abs(box.lo - expected.box.lo),
+                    glm::abs(box.hi - expected.box.hi)
+                ),
+                glm::abs(collider.get_velocity() - expected.velocity)
+            );
+
+            tmine_assert(
+                glm::all(glm::lessThan(error, glm::vec3{TOLERANCE})),
+                "collider {} diverged on tick {}", i, tick
+            );
+        }
+    }
+}
+
+/// Runs a pile of boxes falling onto the floor with `n_threads` threads and
+/// returns their boxes.
+static auto simulate_pile(i32 n_threads) -> std::vector<Aabb> {
+    auto constexpr N_BOXES = usize{2048};
+    auto constexpr N_TICKS = usize{60};
+
+#ifdef _OPENMP
+    auto const prev_n_threads = omp_get_max_threads();
+    omp_set_num_threads(n_threads);
+#else
+    (void) n_threads;
+#endif
+
+    auto const chunks = make_flat_world();
+    auto solver = PhysicsSolver{};
+    auto rng = std::mt19937{2024};
+    auto horizontal = std::uniform_real_distribution<f32>{0.0f, 60.0f};
+    auto vertical = std::uniform_real_distribution<f32>{12.0f, 30.0f};
+    auto speed = std::uniform_real_distribution<f32>{-4.0f, 4.0f};
+
+    solver.register_collidable<TerrainCollider>(chunks);
+
+    auto ids = std::vector<ColliderId>{};
+
+    for (usize i = 0; i < N_BOXES; ++i) {
+        auto const pos =
+            glm::vec3{horizontal(rng), vertical(rng), horizontal(rng)};
+        ids.push_back(spawn_box(
+            &solver, pos, glm::vec3{speed(rng), speed(rng), speed(rng)}
+        ));
+    }
+
+    for (usize i = 0; i < N_TICKS; ++i) {
+        solver.update(TIME_STEP);
+    }
+
+#ifdef _OPENMP
+    omp_set_num_threads(prev_n_threads);
+#endif
+
+    auto boxes = std::vector<Aabb>{};
+
+    for (auto const id : ids) {
+        boxes.push_back(solver.get_box_collider(id).get_box());
+    }
+
+    return boxes;
+}
+
+auto test_islands_are_deterministic() -> void {
+    auto const expected = simulate_pile(1);
+
+    for (auto const n_threads : {2, 4, 8}) {
+        auto const boxes = simulate_pile(n_threads);
+
+        for (usize i = 0; i < boxes.size(); ++i) {
+            tmine_assert(
+                boxes[i] == expected[i], "box #{} with {} threads", i,
+                n_threads
+            );
+        }
+    }
+}
+
+}  // namespace tmine_test
@@ -0,0 +1,12 @@
+#pragma once
+
+namespace tmine_test {
+
+auto test_high_speed_fall() -> void;
+auto test_wall_slide() -> void;
+auto test_solver_matches_reference() -> void;
+auto test_resting_box_sleeps_and_wakes() -> void;
+auto test_falling_box_wakes_sleeping_one() -> void;
+auto test_islands_are_deterministic() -> void;
+
+}
@@ -0,0 +1,107 @@
+#include <array>
+#include <memory>
+#include <vector>
+
+#include "terrain.hpp"
+#include "entities.hpp"
+#include "ecs.hpp"
+#include "assert.hpp"
+
+namespace tmine_test {
+
+using namespace tmine;
+
+auto test_entity_handles_are_reused() -> void {
+    auto registry = EntityRegistry{};
+    auto entities = std::array<Entity, 4>{};
+
+    for (usize i = 0; i < entities.size(); ++i) {
+        entities[i] = registry.spawn();
+        registry.add(entities[i], Transform{.pos = glm::vec3{(f32) i}});
+    }
+
+    registry.despawn(entities[1]);
+
+    tmine_assert(!registry.is_alive(entities[1]));
+    tmine_assert_eq(registry.size(), 3);
+    tmine_assert_eq(registry.storage<Transform>().size(), 3);
+
+    for (auto const i : {0, 2, 3}) {
+        tmine_assert(registry.get<Transform>(entities[i]).pos == glm::vec3{i});
+    }
+
+    auto const reused = registry.spawn();
+
+    tmine_assert_eq(reused.index, entities[1].index);
+    tmine_assert_ne(reused.generation, entities[1].generation);
+    tmine_assert(!registry.storage<Transform>().contains(reused));
+    tmine_assert(!registry.storage<Transform>().contains(entities[1]));
+
+    // Despawning a stale handle must not touch the new entity
+    registry.add(reused, Transform{.pos = glm::vec3{7.0f}});
+    registry.despawn(entities[1]);
+
+    tmine_assert(registry.is_alive(reused));
+    tmine_assert(registry.get<Transform>(reused).pos == glm::vec3{7.0f});
+}
+
+auto test_entities_land_on_terrain() -> void {
+    auto constexpr FLOOR_HEIGHT = u32{10};
+    auto constexpr TIME_STEP = 1.0f / 60.0f;
+
+    auto chunks = std::make_shared<ChunkArray>(glm::uvec3{4, 4, 4});
+    auto const world_size = chunks->size() * Chunk::SIZE;
+
+    for (u32 y = 0; y < world_size.y; ++y) {
+        for (u32 z = 0; z < world_size.z; ++z) {
+            for (u32 x = 0; x < world_size.x; ++x) {
+                auto const id = VoxelId{y <= FLOOR_HEIGHT ? u8{1} : u8{0}};
+                chunks->set_voxel({x, y, z}, Voxel{id, 0});
+            }
+        }
+    }
+
+    auto const terrain = TerrainCollider{chunks};
+    auto registry = EntityRegistry{};
+    auto entities = std::vector<Entity>{};
+
+    for (u32 i = 0; i < 64; ++i) {
+        auto const entity = registry.spawn();
+        auto const pos = glm::vec3{
+            (f32) (i % 8) * 4.0f + 2.3f,
+            30.0f + (f32) i,
+            (f32) (i / 8) * 4.0f + 2.7f,
+        };
+
+        registry.add(entity, Transform{.pos = pos});
+        registry.add(
+            entity, Velocity{
+                        .value = {0.0f, -5.0f, 0.0f},
+                        .acceleration = {0.0f, -30.0f, 0.0f},
+                    }
+        );
+        registry.add(entity, EntityCollider{.size = glm::vec3{0.5f}});
+
+        entities.push_back(entity);
+    }
+
+    // Entities without a transform are skipped
+    registry.add(registry.spawn(), EntityCollider{});
+
+    for (usize tick = 0; tick < 600; ++tick) {
+        move_entities(&registry, terrain, TIME_STEP);
+    }
+
+    for (auto const entity : entities) {
+        auto const pos = registry.get<Transform>(entity).pos;
+        auto const velocity = registry.get<Velocity>(entity).value;
+
+        tmine_assert(
+            glm::abs(pos.y - (f32) (FLOOR_HEIGHT + 1)) < 1e-3f,
+            "entity #{} is at height {}", entity.index, pos.y
+        );
+        tmine_assert_eq(velocity.y, 0.0f, "entity #{}", entity.index);
+    }
+}
+
+}  // namespace tmine_test
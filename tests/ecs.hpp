@@ -0,0 +1,8 @@
+#pragma once
+
+namespace tmine_test {
+
+auto test_entity_handles_are_reused() -> void;
+auto test_entities_land_on_terrain() -> void;
+
+}
@@ -0,0 +1,91 @@
+#include <vector>
+
+#include "loaders.hpp"
+#include "fonts.hpp"
+#include "assert.hpp"
+
+namespace tmine_test {
+
+using namespace tmine;
+
+static auto constexpr FONT_PATH = "assets/fonts/font.fnt";
+
+auto test_font_glyph_lookup() -> void {
+    auto const font = parse_font_file(FONT_PATH);
+
+    tmine_assert_eq(font.glyph_of('A').id, u32{'A'});
+    tmine_assert_eq(font.glyph_of(' ').id, u32{' '});
+
+    // Bytes without glyphs, negative chars included, fall back to id zero
+    tmine_assert_eq(font.glyph_of((char) 200).id, u32{0});
+    tmine_assert_eq(font.glyph_of('\x01').id, u32{0});
+
+    // From the file: kerning first=70 second=46 amount=-7
+    tmine_assert_eq(font.kerning_of('F', '.'), i32{-7});
+    tmine_assert_eq(font.kerning_of('.', 'F'), i32{0});
+
+    tmine_assert_eq(
+        font.advance_of("F.", 0),
+        (i32) font.glyph_of('F').horizontal_advance - 7
+    );
+    tmine_assert_eq(
+        font.advance_of("F.", 1), (i32) font.glyph_of('.').horizontal_advance
+    );
+}
+
+auto test_font_cache_round_trip() -> void {
+    auto const font = parse_font_file(FONT_PATH);
+    auto const stamp = FontSourceStamp{.size = 42, .modification_time = 7};
+    auto const bytes = serialize_font(font, stamp);
+    auto const cached = deserialize_font(bytes, stamp);
+
+    tmine_assert(cached.has_value());
+    tmine_assert_eq(cached->info.face, font.info.face);
+    tmine_assert_eq(cached->common.line_height, font.common.line_height);
+    tmine_assert_eq(cached->pages.size(), font.pages.size());
+    tmine_assert_eq(
+        cached->pages[0].kernings.size(), font.pages[0].kernings.size()
+    );
+
+    for (usize i = 0; i < Font::N_GLYPHS; ++i) {
+        auto const symbol = (char) i;
+
+        tmine_assert_eq(
+            cached->glyph_of(symbol).id, font.glyph_of(symbol).id, "#{}", i
+        );
+        tmine_assert_eq(
+            cached->glyph_of(symbol).horizontal_advance,
+            font.glyph_of(symbol).horizontal_advance, "#{}", i
+        );
+    }
+
+    for (auto const& kerning : font.pages[0].kernings) {
+        tmine_assert_eq(
+            cached->kerning_of((char) kerning.first, (char) kerning.second),
+            font.kerning_of((char) kerning.first, (char) kerning.second)
+        );
+    }
+
+    // Serializing is deterministic, so that caches can be compared
+    tmine_assert(serialize_font(cached.value(), stamp) == bytes);
+}
+
+auto test_font_cache_rejects_stale() -> void {
+    auto const font = parse_font_file(FONT_PATH);
+    auto const stamp = FontSourceStamp{.size = 42, .modification_time = 7};
+    auto const bytes = serialize_font(font, stamp);
+
+    auto const modified = FontSourceStamp{.size = 42, .modification_time = 8};
+    tmine_assert(!deserialize_font(bytes, modified).has_value());
+
+    auto const truncated = std::span{bytes}.first(bytes.size() - 1);
+    tmine_assert(!deserialize_font(truncated, stamp).has_value());
+
+    auto corrupted = bytes;
+    corrupted[0] = 'X';
+    tmine_assert(!deserialize_font(corrupted, stamp).has_value());
+
+    tmine_assert(!deserialize_font({}, stamp).has_value());
+}
+
+}  // namespace tmine_test
@@ -0,0 +1,9 @@
+#pragma once
+
+namespace tmine_test {
+
+auto test_font_glyph_lookup() -> void;
+auto test_font_cache_round_trip() -> void;
+auto test_font_cache_rejects_stale() -> void;
+
+}
@@ -0,0 +1,35 @@
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "geometry.hpp"
+#include "frustum.hpp"
+#include "assert.hpp"
+
+namespace tmine_test {
+
+using namespace tmine;
+
+auto test_frustum_culls_boxes() -> void {
+    auto const projection =
+        glm::perspective(glm::radians(60.0f), 1.0f, 0.1f, 100.0f);
+    auto const view = glm::lookAt(
+        glm::vec3{0.0f}, glm::vec3{0.0f, 0.0f, -1.0f},
+        glm::vec3{0.0f, 1.0f, 0.0f}
+    );
+    auto const frustum = Frustum::from_projection_view(projection * view);
+
+    auto const unit_box_at = [](glm::vec3 pos) {
+        return Aabb{pos - 0.5f, pos + 0.5f};
+    };
+
+    tmine_assert(frustum.intersects(unit_box_at({0.0f, 0.0f, -10.0f})));
+    tmine_assert(!frustum.intersects(unit_box_at({0.0f, 0.0f, 10.0f})));
+    tmine_assert(!frustum.intersects(unit_box_at({30.0f, 0.0f, -10.0f})));
+    tmine_assert(!frustum.intersects(unit_box_at({0.0f, 0.0f, -200.0f})));
+
+    // Boxes crossing a plane are kept
+    tmine_assert(frustum.intersects(Aabb{
+        glm::vec3{-50.0f, -1.0f, -11.0f}, glm::vec3{-5.0f, 1.0f, -9.0f}
+    }));
+}
+
+}  // namespace tmine_test
@@ -0,0 +1,7 @@
+#pragma once
+
+namespace tmine_test {
+
+auto test_frustum_culls_boxes() -> void;
+
+}
@@ -0,0 +1,73 @@
+#include <memory>
+
+#include "game.hpp"
+#include "headless.hpp"
+#include "assert.hpp"
+
+namespace tmine_test {
+
+using namespace tmine;
+
+auto constexpr WORLD_SIZE = glm::uvec3{4, 4, 4};
+auto constexpr N_SETTLE_TICKS = u32{120};
+
+static auto idle(u32, Game&) -> PlayerTickInput { return PlayerTickInput{}; }
+
+auto test_headless_player_walks() -> void {
+    auto game =
+        std::make_unique<Game>(HeadlessConfig{.world_size = WORLD_SIZE});
+
+    tmine_assert(game->is_headless());
+
+    game->run_headless(N_SETTLE_TICKS, idle);
+
+    auto const start = game->get_player_state().box.lo;
+    auto n_calls = u32{0};
+
+    auto const stats = game->run_headless(240, [&n_calls](u32 tick, Game&) {
+        tmine_assert_eq(tick, n_calls);
+        n_calls += 1;
+
+        return PlayerTickInput{.pressed = PlayerTickInput::FORWARD};
+    });
+
+    auto const end = game->get_player_state().box.lo;
+    auto const distance =
+        glm::length(glm::vec2{end.x, end.z} - glm::vec2{start.x, start.z});
+
+    tmine_assert_eq(n_calls, u32{240});
+    tmine_assert_eq(stats.n_ticks, u32{240});
+    tmine_assert(stats.ticks_per_second > 0.0);
+    tmine_assert(distance > 5.0f, "walked {} voxels", distance);
+}
+
+auto test_headless_edits_wake_player() -> void {
+    auto game =
+        std::make_unique<Game>(HeadlessConfig{.world_size = WORLD_SIZE});
+
+    // Long enough for the resting player to fall asleep
+    game->run_headless(4 * N_SETTLE_TICKS, idle);
+
+    auto const start = game->get_player_state().box.lo;
+
+    game->run_headless(N_SETTLE_TICKS, [](u32 tick, Game& game) {
+        if (0 == tick) {
+            auto const feet = glm::uvec3{game.get_player_state().box.lo};
+
+            game.fill_box(
+                glm::uvec3{feet.x - 2, feet.y - 10, feet.z - 2},
+                glm::uvec3{feet.x + 2, feet.y - 1, feet.z + 2}, Voxel{0, 0}
+            );
+        }
+
+        return PlayerTickInput{};
+    });
+
+    auto const end = game->get_player_state().box.lo;
+
+    tmine_assert(
+        end.y < start.y - 5.0f, "fell from {} to {}", start.y, end.y
+    );
+}
+
+}  // namespace tmine_test
@@ -0,0 +1,8 @@
+#pragma once
+
+namespace tmine_test {
+
+auto test_headless_player_walks() -> void;
+auto test_headless_edits_wake_player() -> void;
+
+}
@@ -0,0 +1,87 @@
+#include <new>
+#include <vector>
+
+#include "allocations.hpp"
+#include "collections.hpp"
+#include "heap.hpp"
+#include "assert.hpp"
+
+namespace tmine_test {
+
+using namespace tmine;
+
+auto test_allocations_counted_per_frame() -> void {
+    if constexpr (!ALLOCATION_TRACKING_IS_ENABLED) {
+        return;
+    }
+
+    auto& registry = allocations::REGISTRY;
+    registry.finish_frame();
+
+    // Direct calls, so that the compiler can not elide them
+    for (usize i = 0; i < 3; ++i) {
+        ::operator delete(::operator new(64));
+    }
+
+    registry.finish_frame();
+
+    tmine_assert_eq(registry.get_n_frame_allocations(), u64{3});
+
+    registry.finish_frame();
+
+    tmine_assert_eq(registry.get_n_frame_allocations(), u64{0});
+}
+
+auto test_allocations_are_tagged() -> void {
+    if constexpr (!ALLOCATION_TRACKING_IS_ENABLED) {
+        return;
+    }
+
+    auto const live_bytes = [](AllocationTag tag) {
+        return allocations::REGISTRY.get_stats(tag).live_bytes;
+    };
+
+    auto const fonts_before = live_bytes(AllocationTag::Fonts);
+    auto ptr = (void*) nullptr;
+
+    {
+        auto const scope = AllocationScope{AllocationTag::Fonts};
+        ptr = ::operator new(100);
+    }
+
+    tmine_assert_eq(live_bytes(AllocationTag::Fonts), fonts_before + 100);
+
+    // The tag is remembered by the allocation, not the scope
+    ::operator delete(ptr);
+
+    tmine_assert_eq(live_bytes(AllocationTag::Fonts), fonts_before);
+
+    auto const meshes_before = live_bytes(AllocationTag::MeshBuffers);
+
+    {
+        using Allocator = TrackingAllocator<u32, AllocationTag::MeshBuffers>;
+
+        auto vertices = std::vector<u32, Allocator>{};
+        vertices.reserve(10);
+
+        tmine_assert_eq(
+            live_bytes(AllocationTag::MeshBuffers),
+            meshes_before + 10 * sizeof(u32)
+        );
+    }
+
+    tmine_assert_eq(live_bytes(AllocationTag::MeshBuffers), meshes_before);
+
+    auto const vecs_before = live_bytes(AllocationTag::ThreadsafeVec);
+
+    {
+        auto vec = ThreadsafeVec<u32>{};
+        vec.push(1);
+
+        tmine_assert(live_bytes(AllocationTag::ThreadsafeVec) > vecs_before);
+    }
+
+    tmine_assert_eq(live_bytes(AllocationTag::ThreadsafeVec), vecs_before);
+}
+
+}  // namespace tmine_test
@@ -0,0 +1,8 @@
+#pragma once
+
+namespace tmine_test {
+
+auto test_allocations_counted_per_frame() -> void;
+auto test_allocations_are_tagged() -> void;
+
+}
@@ -0,0 +1,93 @@
+#include <random>
+#include <vector>
+
+#include "instancing.hpp"
+#include "instances.hpp"
+#include "assert.hpp"
+
+namespace tmine_test {
+
+using namespace tmine;
+
+auto test_instance_batches_are_sorted() -> void {
+    auto rng = std::mt19937{5};
+    auto batcher = InstanceBatcher{};
+    auto keys = std::vector<InstanceKey>{};
+
+    // Materials use both bytes of their half of the key, so that more
+    // than one radix pass is needed
+    for (usize i = 0; i < 10'000; ++i) {
+        auto const key = InstanceKey{
+            .mesh = (MeshId) (rng() % 5),
+            .material = (MaterialId) (rng() % 3 * 300),
+        };
+
+        keys.push_back(key);
+        batcher.push(key, InstanceData{.offset = glm::vec3{(f32) i}});
+    }
+
+    batcher.build();
+
+    auto const instances = batcher.get_instances();
+    auto const batches = batcher.get_batches();
+
+    tmine_assert_eq(instances.size(), keys.size());
+    tmine_assert_eq(batches.size(), usize{15});
+
+    auto next_first = u32{0};
+
+    for (usize i = 0; i < batches.size(); ++i) {
+        auto const& batch = batches[i];
+
+        tmine_assert_eq(batch.first, next_first, "batch #{}", i);
+        tmine_assert_ne(batch.count, u32{0}, "batch #{}", i);
+
+        if (i > 0) {
+            tmine_assert(
+                batches[i - 1].key.packed() < batch.key.packed(), "batch #{}",
+                i
+            );
+        }
+
+        for (u32 j = batch.first; j < batch.first + batch.count; ++j) {
+            auto const index = (usize) instances[j].offset.x;
+
+            tmine_assert(keys[index] == batch.key, "instance #{}", j);
+
+            // Push order is kept within a batch
+            if (j > batch.first) {
+                tmine_assert(
+                    instances[j - 1].offset.x < instances[j].offset.x,
+                    "instance #{}", j
+                );
+            }
+        }
+
+        next_first += batch.count;
+    }
+
+    tmine_assert_eq((usize) next_first, instances.size());
+}
+
+auto test_instance_batcher_is_reusable() -> void {
+    auto batcher = InstanceBatcher{};
+
+    batcher.build();
+    tmine_assert(batcher.get_batches().empty());
+
+    batcher.push(InstanceKey{.mesh = 1}, InstanceData{});
+    batcher.push(InstanceKey{.mesh = 0}, InstanceData{});
+    batcher.build();
+    tmine_assert_eq(batcher.get_batches().size(), usize{2});
+
+    batcher.clear();
+    batcher.push(InstanceKey{.mesh = 3, .material = 2}, InstanceData{});
+    batcher.build();
+
+    tmine_assert_eq(batcher.get_instances().size(), usize{1});
+    tmine_assert_eq(batcher.get_batches().size(), usize{1});
+    tmine_assert_eq(batcher.get_batches()[0].key.mesh, MeshId{3});
+    tmine_assert_eq(batcher.get_batches()[0].key.material, MaterialId{2});
+}
+
+}  // namespace tmine_test
@@ -0,0 +1,8 @@
+#pragma once
+
+namespace tmine_test {
+
+auto test_instance_batches_are_sorted() -> void;
+auto test_instance_batcher_is_reusable() -> void;
+
+}
@@ -1,6 +1,19 @@
 #include "util.hpp"
 #include "parse.hpp"
 #include "vec.hpp"
+#include "voxels.hpp"
+#include "collisions.hpp"
+#include "frustum.hpp"
+#include "replays.hpp"
+#include "ecs.hpp"
+#include "instances.hpp"
+#include "profiling.hpp"
+#include "timings.hpp"
+#include "headless.hpp"
+#include "heap.hpp"
+#include "overlay.hpp"
+#include "widgets.hpp"
+#include "fonts.hpp"
 #include "other.hpp"
 
 using namespace tmine_test;
@@ -18,4 +31,47 @@ auto main() -> int {
     perform_test(test_vec_erase);
     perform_test(test_smallvec_push);
     perform_test(test_dynamic_cast_if_init);
+    perform_test(test_chunk_brick_mask);
+    perform_test(test_morton_layout_round_trips);
+    perform_test(test_morton_chunk_tiles_round_trip);
+    perform_test(test_chunk_voxel_counts);
+    perform_test(test_ray_cast_axis_aligned);
+    perform_test(test_ray_cast_matches_reference);
+    perform_test(test_ray_cast_passes_through_edges);
+    perform_test(test_ray_cast_rejects_degenerate_rays);
+    perform_test(test_ray_cast_batch_matches_single);
+    perform_test(test_solid_cells_match_scan);
+    perform_test(test_paste_structure_marks_chunks);
+    perform_test(test_high_speed_fall);
+    perform_test(test_wall_slide);
+    perform_test(test_solver_matches_reference);
+    perform_test(test_resting_box_sleeps_and_wakes);
+    perform_test(test_falling_box_wakes_sleeping_one);
+    perform_test(test_islands_are_deterministic);
+    perform_test(test_frustum_culls_boxes);
+    perform_test(test_replay_is_bit_exact);
+    perform_test(test_replay_ignores_look_between_ticks);
+    perform_test(test_replay_rejects_truncated_log);
+    perform_test(test_entity_handles_are_reused);
+    perform_test(test_entities_land_on_terrain);
+    perform_test(test_instance_batches_are_sorted);
+    perform_test(test_instance_batcher_is_reusable);
+    perform_test(test_profiler_exports_zones);
+    perform_test(test_profiler_keeps_latest_events);
+    perform_test(test_metrics_rolling_stats);
+    perform_test(test_metrics_counters_reset_every_frame);
+    perform_test(test_headless_player_walks);
+    perform_test(test_headless_edits_wake_player);
+    perform_test(test_allocations_counted_per_frame);
+    perform_test(test_allocations_are_tagged);
+    perform_test(test_debug_lines_merge_threads);
+    perform_test(test_debug_lines_disabled_are_dropped);
+    perform_test(test_debug_lines_are_discarded_while_disabled);
+    perform_test(test_debug_text_rewrites_changed_glyphs);
+    perform_test(test_debug_text_updates_do_not_allocate);
+    perform_test(test_gui_batches_are_sorted);
+    perform_test(test_gui_text_is_tessellated_once);
+    perform_test(test_font_glyph_lookup);
+    perform_test(test_font_cache_round_trip);
+    perform_test(test_font_cache_rejects_stale);
 }
@@ -0,0 +1,199 @@
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "debug.hpp"
+#include "loaders.hpp"
+#include "allocations.hpp"
+#include "overlay.hpp"
+#include "assert.hpp"
+
+namespace tmine_test {
+
+using namespace tmine;
+
+auto test_debug_lines_merge_threads() -> void {
+    auto constexpr N_THREADS = usize{4};
+    auto constexpr N_BOXES = usize{100};
+
+    auto const was_enabled = DEBUG_IS_ENABLED.exchange(true);
+    auto vertices = MeshVec<DebugLineVertex>{};
+
+    // Drops leftovers of other tests
+    debug::take_lines(&vertices);
+    vertices.clear();
+
+    {
+        auto threads = std::vector<std::jthread>{};
+
+        for (usize i = 0; i < N_THREADS; ++i) {
+            threads.emplace_back([] {
+                for (usize j = 0; j < N_BOXES; ++j) {
+                    debug::box(Aabb{glm::vec3{0.0f}, glm::vec3{1.0f}});
+                }
+            });
+        }
+    }
+
+    debug::line(glm::vec3{0.0f}, glm::vec3{1.0f}, DebugColor::RED);
+    debug::take_lines(&vertices);
+
+    tmine_assert_eq(vertices.size(), N_THREADS * N_BOXES * 24 + 2);
+
+    // Buffers are emptied by taking
+    vertices.clear();
+    debug::take_lines(&vertices);
+
+    tmine_assert_eq(vertices.size(), usize{0});
+
+    DEBUG_IS_ENABLED = was_enabled;
+}
+
+auto test_debug_lines_disabled_are_dropped() -> void {
+    auto const was_enabled = DEBUG_IS_ENABLED.exchange(false);
+    auto vertices = MeshVec<DebugLineVertex>{};
+
+    debug::take_lines(&vertices);
+    vertices.clear();
+
+    debug::box(glm::vec3{0.0f}, glm::vec3{1.0f});
+    debug::take_lines(&vertices);
+
+    tmine_assert_eq(vertices.size(), usize{0});
+
+    DEBUG_IS_ENABLED = was_enabled;
+}
+
+auto test_debug_lines_are_discarded_while_disabled() -> void {
+    auto const was_enabled = DEBUG_IS_ENABLED.exchange(true);
+    auto vertices = MeshVec<DebugLineVertex>{};
+
+    debug::take_lines(&vertices);
+    vertices.clear();
+
+    // Submitted by a thread that exits before the lines are dropped
+    std::jthread{[] {
+        debug::box(glm::vec3{0.0f}, glm::vec3{1.0f});
+    }}.join();
+
+    debug::box(glm::vec3{0.0f}, glm::vec3{1.0f});
+
+    DEBUG_IS_ENABLED = false;
+    debug::discard_lines();
+    DEBUG_IS_ENABLED = true;
+
+    debug::take_lines(&vertices);
+    tmine_assert_eq(vertices.size(), usize{0});
+
+    DEBUG_IS_ENABLED = was_enabled;
+}
+
+auto constexpr TEXT_VIEWPORT_SIZE = glm::uvec2{1920, 1080};
+
+/// The debug font has no kerning pairs, this one does.
+static auto kerned_font() -> std::shared_ptr<Font> {
+    static auto const font =
+        std::make_shared<Font>(parse_font_file("assets/fonts/font.fnt"));
+
+    return font;
+}
+
+/// Lines around the edited one, so that it starts in the middle of the mesh.
+static auto laid_out_text(std::string_view value) -> DebugTextLayout {
+    auto glyphs = DebugTextLayout{kerned_font()};
+
+    glyphs.set("a", "line before");
+    glyphs.set("b", value);
+    glyphs.set("c", "line after");
+    glyphs.layout(TEXT_VIEWPORT_SIZE);
+
+    return glyphs;
+}
+
+/// Changes the middle line from `from` to `to` and checks that exactly glyphs
+/// `[first_glyph, last_glyph)` are rewritten and the result is the same as
+/// laying `to` out from scratch.
+static auto check_glyph_update(
+    std::string_view from, std::string_view to, usize first_glyph,
+    usize last_glyph
+) -> void {
+    auto constexpr N_VERTICES = DebugTextLayout::N_GLYPH_VERTICES;
+    auto constexpr LINE_START = DebugTextLayout::MIN_LINE_CAPACITY;
+
+    auto glyphs = laid_out_text(from);
+    glyphs.set("b", to);
+
+    auto const [first, last] = glyphs.take_dirty_range();
+    auto const reference = laid_out_text(to);
+
+    tmine_assert(!glyphs.needs_layout());
+    tmine_assert_eq(
+        first, first_glyph == last_glyph
+                   ? usize{0}
+                   : N_VERTICES * (LINE_START + first_glyph)
+    );
+    tmine_assert_eq(
+        last, first_glyph == last_glyph
+                  ? usize{0}
+                  : N_VERTICES * (LINE_START + last_glyph)
+    );
+
+    auto const& vertices = glyphs.get_vertices();
+    auto const& expected = reference.get_vertices();
+
+    tmine_assert_eq(vertices.size(), expected.size());
+    tmine_assert(
+        0 == std::memcmp(
+                 vertices.data(), expected.data(),
+                 vertices.size() * sizeof(vertices[0])
+             ),
+        "glyphs of '{}' differ from a fresh layout", to
+    );
+}
+
+auto test_debug_text_rewrites_changed_glyphs() -> void {
+    check_glyph_update("hello", "hello", 0, 0);
+    check_glyph_update("hello world", "hello", 5, 11);
+    check_glyph_update("hello", "hello world", 5, 11);
+
+    // `W` is wider than `1`, so all glyphs after it move
+    check_glyph_update("i1iii", "iWiii", 1, 5);
+
+    // `y` and `k` are equally wide, but only `Ty` is kerned, so `T` moves
+    // glyphs after it without changing itself
+    check_glyph_update("aTyxyz", "aTkxyz", 2, 6);
+}
+
+auto test_debug_text_updates_do_not_allocate() -> void {
+    if constexpr (!ALLOCATION_TRACKING_IS_ENABLED) {
+        return;
+    }
+
+    auto glyphs = DebugTextLayout{kerned_font()};
+
+    // The longest values come first, so that strings have their capacity
+    glyphs.set_formatted(
+        "camera", "x: {:.2f}, y: {:.2f}", -1000.0f, -1000.0f
+    );
+    glyphs.set_formatted("fps", "FPS: {}", 1000);
+    glyphs.layout(TEXT_VIEWPORT_SIZE);
+
+    auto const n_allocations = allocations::REGISTRY.get_n_allocations();
+
+    for (u32 i = 0; i < 100; ++i) {
+        glyphs.set_formatted(
+            "camera", "x: {:.2f}, y: {:.2f}", 0.5f * (f32) i, -(f32) i
+        );
+        glyphs.set_formatted("fps", "FPS: {}", i);
+        glyphs.set("fps", "FPS: idle");
+
+        [[maybe_unused]] auto const range = glyphs.take_dirty_range();
+    }
+
+    tmine_assert_eq(allocations::REGISTRY.get_n_allocations(), n_allocations);
+    tmine_assert(!glyphs.needs_layout());
+}
+
+}  // namespace tmine_test
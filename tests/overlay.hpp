@@ -0,0 +1,11 @@
+#pragma once
+
+namespace tmine_test {
+
+auto test_debug_lines_merge_threads() -> void;
+auto test_debug_lines_disabled_are_dropped() -> void;
+auto test_debug_lines_are_discarded_while_disabled() -> void;
+auto test_debug_text_rewrites_changed_glyphs() -> void;
+auto test_debug_text_updates_do_not_allocate() -> void;
+
+}
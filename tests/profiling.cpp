@@ -0,0 +1,75 @@
+#include <string>
+#include <thread>
+
+#include "profiler.hpp"
+#include "profiling.hpp"
+#include "assert.hpp"
+
+namespace tmine_test {
+
+using namespace tmine;
+
+static auto count_occurrences(std::string_view text, std::string_view pattern)
+    -> usize {
+    auto count = usize{0};
+
+    for (auto pos = text.find(pattern); std::string_view::npos != pos;
+         pos = text.find(pattern, pos + pattern.size()))
+    {
+        ++count;
+    }
+
+    return count;
+}
+
+auto test_profiler_exports_zones() -> void {
+    {
+        auto const outer = ProfileZone{"test_outer_zone"};
+        auto const inner = ProfileZone{"test_inner_zone"};
+    }
+
+    std::thread{[] { auto const zone = ProfileZone{"test_thread_zone"}; }}
+        .join();
+
+    auto const trace = profiler::to_chrome_trace(0);
+
+    tmine_assert(trace.starts_with("{"));
+    tmine_assert(trace.contains("\"name\":\"test_outer_zone\""));
+    tmine_assert(trace.contains("\"name\":\"test_inner_zone\""));
+    tmine_assert(trace.contains("\"name\":\"test_thread_zone\""));
+    tmine_assert(trace.contains("\"ph\":\"X\""));
+}
+
+auto test_profiler_keeps_latest_events() -> void {
+    auto constexpr CAPACITY = ProfileThreadBuffer::CAPACITY;
+
+    // Runs on a fresh thread, so that its buffer holds no other events
+    std::thread{[] {
+        for (usize i = 0; i < CAPACITY + 100; ++i) {
+            profiler::record(ProfileEvent{
+                .name = "test_old_event",
+                .start = profiler::now(),
+                .end = profiler::now(),
+            });
+        }
+
+        for (usize i = 0; i < 10; ++i) {
+            profiler::record(ProfileEvent{
+                .name = "test_new_event",
+                .start = profiler::now(),
+                .end = profiler::now(),
+            });
+        }
+    }}.join();
+
+    auto const trace = profiler::to_chrome_trace(0);
+
+    // The oldest kept slot is also the next one to be written, so readers
+    // drop it even when the writing thread is done
+    tmine_assert_eq(count_occurrences(trace, "\"test_new_event\""), usize{10});
+    tmine_assert_eq(
+        count_occurrences(trace, "\"test_old_event\""), CAPACITY - 11
+    );
+}
+
+}  // namespace tmine_test
@@ -0,0 +1,8 @@
+#pragma once
+
+namespace tmine_test {
+
+auto test_profiler_exports_zones() -> void;
+auto test_profiler_keeps_latest_events() -> void;
+
+}
@@ -0,0 +1,205 @@
+#include <memory>
+#include <vector>
+
+#include "terrain.hpp"
+#include "physics.hpp"
+#include "entities.hpp"
+#include "replay.hpp"
+#include "replays.hpp"
+#include "assert.hpp"
+
+namespace tmine_test {
+
+using namespace tmine;
+
+auto constexpr TIME_STEP = 1.0f / 120.0f;
+auto constexpr N_TICKS = u32{600};
+auto constexpr DIG_TICK = u32{240};
+auto constexpr THROW_TICK = u32{120};
+auto constexpr VIEWPORT_SIZE = glm::uvec2{1280, 720};
+
+/// Input of a scripted session: walking around, jumping, flying up and
+/// coming down into a pit dug under the player.
+static auto scripted_input(u32 tick) -> PlayerTickInput {
+    auto input = PlayerTickInput{
+        .movement = tick < 360 || tick >= 480 ? PlayerMovement::Walk
+                                              : PlayerMovement::Fly,
+        .camera_angles = glm::vec2{0.01f * (f32) tick, -0.2f},
+    };
+
+    if (tick < 200) {
+        input.pressed |= PlayerTickInput::FORWARD;
+    }
+
+    if (tick % 90 < 10) {
+        input.pressed |= PlayerTickInput::JUMP;
+    }
+
+    if (tick >= 100 && tick < 160) {
+        input.pressed |= PlayerTickInput::LEFT | PlayerTickInput::SPRINT;
+    }
+
+    return input;
+}
+
+struct RecordedSession {
+    ReplayLog log;
+    /// State of the player at the end of the session, after the last tick.
+    PlayerState last_state;
+};
+
+/// Records `N_TICKS` ticks of the scripted session the way `Game` does. With
+/// `looks_between_ticks` the camera is turned and the movement switched
+/// between ticks like `Player::update` does.
+static auto record_session(bool looks_between_ticks) -> RecordedSession {
+    auto chunks = std::make_shared<ChunkArray>(glm::uvec3{4, 4, 4});
+    auto solver = PhysicsSolver{};
+    auto player = Player{*chunks, &solver};
+    solver.register_collidable<TerrainCollider>(chunks);
+
+    auto entities = EntityRegistry{};
+    auto const terrain = TerrainCollider{chunks};
+
+    auto const initial_state = player.get_state(&solver);
+    player.set_state(&solver, initial_state);
+
+    auto log = ReplayLog::capture(TIME_STEP, *chunks, entities, initial_state);
+
+    for (u32 tick = 0; tick < N_TICKS; ++tick) {
+        if (DIG_TICK == tick) {
+            auto const feet = glm::uvec3{player.get_state(&solver).box.lo};
+            auto const lo = glm::uvec3{feet.x - 1, feet.y - 6, feet.z - 1};
+            auto const hi = glm::uvec3{feet.x + 1, feet.y - 1, feet.z + 1};
+
+            for (u32 y = lo.y; y <= hi.y; ++y) {
+                for (u32 z = lo.z; z <= hi.z; ++z) {
+                    for (u32 x = lo.x; x <= hi.x; ++x) {
+                        chunks->set_voxel({x, y, z}, Voxel{});
+                    }
+                }
+            }
+
+            auto const box = Aabb{glm::vec3{lo}, glm::vec3{hi + 1u}};
+
+            solver.wake_in(box);
+            log.record_edit(*chunks, box);
+        }
+
+        if (THROW_TICK == tick) {
+            auto const head = player.get_state(&solver).box.hi;
+            auto const item = entities.spawn();
+
+            entities.add(
+                item, Transform{.pos = head + glm::vec3{0.0f, 1.0f, 0.0f}}
+            );
+            entities.add(
+                item, Velocity{
+                          .value = glm::vec3{5.0f, 5.0f, 0.0f},
+                          .acceleration = glm::vec3{0.0f, -20.0f, 0.0f},
+                      }
+            );
+            entities.add(
+                item,
+                EntityCollider{.size = glm::vec3{0.25f}, .elasticity = 0.3f}
+            );
+
+            log.record_spawn(entities, item);
+        }
+
+        auto const input = scripted_input(tick);
+        log.record_tick(input);
+
+        solver.update(TIME_STEP);
+        player.fixed_update(TIME_STEP, *chunks, &solver, input);
+        move_entities(&entities, terrain, TIME_STEP);
+
+        log.finish(player.get_state(&solver));
+
+        if (looks_between_ticks) {
+            player.look(glm::vec2{7.0f, -3.0f}, VIEWPORT_SIZE);
+            player.toggle_movement();
+        }
+    }
+
+    log.record_entity_positions(entities);
+
+    return RecordedSession{
+        .log = std::move(log),
+        .last_state = player.get_state(&solver),
+    };
+}
+
+auto test_replay_is_bit_exact() -> void {
+    auto const recorded = record_session(false).log;
+    auto const log = ReplayLog::deserialize(recorded.serialize());
+
+    tmine_assert_eq(log.tick_count(), N_TICKS);
+    tmine_assert_eq(log.patches.size(), 1);
+    tmine_assert_eq(log.spawns.size(), 1);
+    tmine_assert_eq(log.final_entity_positions.size(), 1);
+    tmine_assert(
+        log.final_entity_positions[0] != log.spawns[0].transform.pos,
+        "thrown item should move"
+    );
+    tmine_assert(log.serialize() == recorded.serialize());
+    tmine_assert(log.final_state.has_value());
+    tmine_assert(is_bit_exact(log.initial_state, recorded.initial_state));
+    tmine_assert(
+        log.final_state->box != log.initial_state.box,
+        "scripted session should move the player"
+    );
+
+    auto const result = replay(log);
+
+    tmine_assert_eq(result.tick_count, N_TICKS);
+    tmine_assert(result.is_exact);
+    tmine_assert(is_bit_exact(result.final_state, *recorded.final_state));
+    tmine_assert(
+        result.final_entity_positions == recorded.final_entity_positions
+    );
+}
+
+auto test_replay_ignores_look_between_ticks() -> void {
+    auto const session = record_session(true);
+    auto const log = ReplayLog::deserialize(session.log.serialize());
+
+    tmine_assert(log.final_state.has_value());
+    tmine_assert(
+        session.last_state.camera_angles != log.final_state->camera_angles,
+        "camera should turn after the last tick"
+    );
+    tmine_assert(
+        session.last_state.movement != log.final_state->movement,
+        "movement should switch after the last tick"
+    );
+
+    auto const result = replay(log);
+
+    tmine_assert_eq(result.tick_count, N_TICKS);
+    tmine_assert(result.is_exact);
+}
+
+auto test_replay_rejects_truncated_log() -> void {
+    auto const chunks = ChunkArray{{4, 4, 4}};
+    auto const entities = EntityRegistry{};
+    auto log = ReplayLog::capture(TIME_STEP, chunks, entities, PlayerState{});
+
+    log.record_tick(PlayerTickInput{});
+    log.finish(PlayerState{});
+    log.record_entity_positions(entities);
+
+    auto bytes = log.serialize();
+    bytes.pop_back();
+
+    auto has_failed = false;
+
+    try {
+        [[maybe_unused]] auto const corrupted = ReplayLog::deserialize(bytes);
+    } catch (PanicException const&) {
+        has_failed = true;
+    }
+
+    tmine_assert(has_failed);
+}
+
+}  // namespace tmine_test
@@ -0,0 +1,9 @@
+#pragma once
+
+namespace tmine_test {
+
+auto test_replay_is_bit_exact() -> void;
+auto test_replay_ignores_look_between_ticks() -> void;
+auto test_replay_rejects_truncated_log() -> void;
+
+}
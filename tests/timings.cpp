@@ -0,0 +1,76 @@
+#include <cmath>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "metrics.hpp"
+#include "timings.hpp"
+#include "assert.hpp"
+
+namespace tmine_test {
+
+using namespace tmine;
+
+auto test_metrics_rolling_stats() -> void {
+    auto registry = std::make_unique<MetricsRegistry>();
+
+    // Frames of 1 to 100 ms, out of order
+    for (u64 i = 0; i < 100; ++i) {
+        auto const milliseconds = (i * 37) % 100 + 1;
+
+        registry->add_time(Timing::Meshing, milliseconds * 500'000);
+        registry->add_time(Timing::Meshing, milliseconds * 500'000);
+        registry->finish_frame();
+    }
+
+    auto const stats = registry->get_stats(Timing::Meshing);
+
+    tmine_assert(std::abs(stats.min - 0.001) < 1e-6, "min = {}", stats.min);
+    tmine_assert(std::abs(stats.avg - 0.0505) < 1e-6, "avg = {}", stats.avg);
+    tmine_assert(std::abs(stats.p99 - 0.099) < 1e-6, "p99 = {}", stats.p99);
+
+    auto const idle = registry->get_stats(Timing::Uploads);
+
+    tmine_assert_eq(idle.min, 0.0);
+    tmine_assert_eq(idle.p99, 0.0);
+
+    // Old frames leave the window
+    for (usize i = 0; i < MetricsRegistry::WINDOW_SIZE; ++i) {
+        registry->add_time(Timing::Meshing, 2'000'000);
+        registry->finish_frame();
+    }
+
+    auto const recent = registry->get_stats(Timing::Meshing);
+
+    tmine_assert(std::abs(recent.min - 0.002) < 1e-6);
+    tmine_assert(std::abs(recent.p99 - 0.002) < 1e-6);
+}
+
+auto test_metrics_counters_reset_every_frame() -> void {
+    auto registry = std::make_unique<MetricsRegistry>();
+
+    {
+        auto threads = std::vector<std::jthread>{};
+
+        for (usize i = 0; i < 4; ++i) {
+            threads.emplace_back([&registry] {
+                for (usize j = 0; j < 1000; ++j) {
+                    registry->add(Counter::DrawCalls);
+                }
+            });
+        }
+    }
+
+    registry->add(Counter::CulledChunks, 7);
+    registry->finish_frame();
+
+    tmine_assert_eq(registry->get_count(Counter::DrawCalls), u64{4000});
+    tmine_assert_eq(registry->get_count(Counter::CulledChunks), u64{7});
+    tmine_assert_eq(registry->get_count(Counter::ChunksRemeshed), u64{0});
+
+    registry->finish_frame();
+
+    tmine_assert_eq(registry->get_count(Counter::DrawCalls), u64{0});
+}
+
+}  // namespace tmine_test
@@ -0,0 +1,8 @@
+#pragma once
+
+namespace tmine_test {
+
+auto test_metrics_rolling_stats() -> void;
+auto test_metrics_counters_reset_every_frame() -> void;
+
+}
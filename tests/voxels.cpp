@@ -0,0 +1,569 @@
+#include <algorithm>
+#include <random>
+#include <tuple>
+#include <vector>
+#include <limits>
+#include <fmt/ranges.h>
+
+#include "terrain.hpp"
+#include "voxels.hpp"
+#include "assert.hpp"
+
+namespace tmine_test {
+
+using namespace tmine;
+
+/// Plain voxel-by-voxel DDA, the way `ChunkArray::ray_cast` used to work.
+/// Boundary distances are computed from the origin rather than accumulated,
+/// the same way `ChunkArray::ray_cast` does, so both visit the same cells.
+static auto reference_ray_cast(
+    ChunkArray const& chunks, glm::vec3 origin, glm::vec3 direction,
+    f32 max_distance
+) -> RayCastResult {
+    auto const infinity = std::numeric_limits<f32>::infinity();
+
+    auto const step = glm::ivec3{
+        direction.x > 0.0f ? 1 : -1,
+        direction.y > 0.0f ? 1 : -1,
+        direction.z > 0.0f ? 1 : -1,
+    };
+
+    auto cell = glm::ivec3{glm::floor(origin)};
+
+    auto const next_distance = [&](i32 axis) {
+        if (0.0f == direction[axis]) {
+            return infinity;
+        }
+
+        auto const boundary = step[axis] > 0 ? cell[axis] + 1 : cell[axis];
+
+        return ((f32) boundary - origin[axis]) * (1.0f / direction[axis]);
+    };
+
+    auto next = glm::vec3{next_distance(0), next_distance(1), next_distance(2)};
+
+    auto distance = 0.0f;
+    auto stepped_axis = i32{-1};
+
+    while (distance <= max_distance) {
+        auto const voxel = chunks.get_voxel(glm::uvec3{cell});
+
+        if (voxel.has_value() && 0 != voxel->id) {
+            auto normal = glm::vec3{0.0f};
+
+            if (-1 != stepped_axis) {
+                normal[stepped_axis] = (f32) -step[stepped_axis];
+            }
+
+            return RayCastResult{
+                .voxel = voxel.value(),
+                .voxel_pos = glm::uvec3{cell},
+                .hit_pos = origin + distance * direction,
+                .normal = normal,
+                .has_hit = true,
+            };
+        }
+
+        if (next.x < next.y) {
+            stepped_axis = next.x < next.z ? 0 : 2;
+        } else {
+            stepped_axis = next.y < next.z ? 1 : 2;
+        }
+
+        cell[stepped_axis] += step[stepped_axis];
+        distance = next[stepped_axis];
+        next[stepped_axis] = next_distance(stepped_axis);
+    }
+
+    return RayCastResult{.has_hit = false};
+}
+
+/// Small world with some voxels carved out and some floating in the air, so
+/// that bricks of every kind are present.
+static auto make_test_world() -> ChunkArray {
+    auto chunks = ChunkArray{{4, 4, 4}};
+    auto rng = std::mt19937{1337};
+    auto const world_size = chunks.size() * Chunk::SIZE;
+
+    for (usize i = 0; i < 2048; ++i) {
+        auto const pos = glm::uvec3{
+            rng() % world_size.x, rng() % world_size.y, rng() % world_size.z
+        };
+
+        chunks.set_voxel(pos, Voxel{(VoxelId) (rng() % 2 * 4), 0});
+    }
+
+    return chunks;
+}
+
+/// Fills the box `[lo, hi]` with `voxel`.
+static auto fill(
+    RefMut<ChunkArray> chunks, glm::uvec3 lo, glm::uvec3 hi, Voxel voxel
+) -> void {
+    for (u32 y = lo.y; y <= hi.y; ++y) {
+        for (u32 z = lo.z; z <= hi.z; ++z) {
+            for (u32 x = lo.x; x <= hi.x; ++x) {
+                chunks->set_voxel({x, y, z}, voxel);
+            }
+        }
+    }
+}
+
+auto test_chunk_brick_mask() -> void {
+    auto chunks = ChunkArray{{4, 4, 4}};
+
+    auto const pos = glm::uvec3{5, 2, 9};
+    auto const neighbour = glm::uvec3{6, 1, 10};
+    auto const chunk = chunks.chunk(pos / Chunk::SIZE);
+    auto const local_pos = pos % Chunk::SIZE;
+
+    fill(&chunks, {0, 0, 0}, Chunk::SIZE - 1u, Voxel{});
+    tmine_assert(chunk->is_empty());
+
+    chunks.set_voxel(pos, Voxel{1, 0});
+    chunks.set_voxel(neighbour, Voxel{1, 0});
+    tmine_assert(!chunk->is_empty());
+    tmine_assert(!chunk->is_brick_empty(local_pos));
+
+    chunks.set_voxel(pos, Voxel{});
+    tmine_assert(!chunk->is_brick_empty(local_pos));
+
+    chunks.set_voxel(neighbour, Voxel{});
+    tmine_assert(chunk->is_brick_empty(local_pos));
+    tmine_assert(chunk->is_empty());
+}
+
+auto test_morton_layout_round_trips() -> void {
+    using Layout = MortonLayout<Chunk::N_POSITION_BITS>;
+
+    auto constexpr BRICK_VOLUME =
+        Chunk::BRICK_SIDE * Chunk::BRICK_SIDE * Chunk::BRICK_SIDE;
+
+    auto is_visited = std::vector<bool>(Chunk::VOLUME, false);
+
+    for (u32 y = 0; y < Chunk::HEIGHT; ++y) {
+        for (u32 z = 0; z < Chunk::DEPTH; ++z) {
+            for (u32 x = 0; x < Chunk::WIDTH; ++x) {
+                auto const pos = glm::uvec3{x, y, z};
+                auto const index = Layout::index_of(pos, Chunk::SIZE);
+
+                tmine_assert(index < Chunk::VOLUME, "{}", index);
+                tmine_assert(!is_visited[index], "{}", index);
+                tmine_assert(Layout::pos_of(index, Chunk::SIZE) == pos);
+
+                is_visited[index] = true;
+
+                // Every brick is a contiguous aligned run of indices, so
+                // brick masks stay valid whichever layout stores voxels
+                auto const brick_start = index / BRICK_VOLUME * BRICK_VOLUME;
+                auto const brick_corner =
+                    Layout::pos_of(brick_start, Chunk::SIZE);
+
+                tmine_assert_eq(
+                    Chunk::brick_index_of(brick_corner),
+                    Chunk::brick_index_of(pos), "{}", index
+                );
+            }
+        }
+    }
+
+    for (usize index = 0; index < Chunk::VOLUME; ++index) {
+        auto const pos = Chunk::pos_of(index);
+
+        tmine_assert_eq(Chunk::index_of(pos), index);
+    }
+
+    // Generated terrain is solid near the ground, so the chunk is cleared
+    auto chunks = ChunkArray{{4, 4, 4}};
+    auto const chunk = chunks.chunk({0, 0, 0});
+    auto const n_bricks = glm::uvec3{Chunk::N_BRICKS_PER_SIDE};
+
+    fill(&chunks, {0, 0, 0}, Chunk::SIZE - 1u, Voxel{});
+    tmine_assert(chunk->is_empty());
+
+    // A voxel set through the active layout marks exactly its own brick
+    for (usize index = 0; index < Chunk::VOLUME; index += 7) {
+        auto const pos = Chunk::pos_of(index);
+
+        chunk->set_voxel(pos, Voxel{3, 0});
+        tmine_assert_eq(chunk->get_voxels()[index].id, 3);
+
+        auto const brick_lo = pos & ~glm::uvec3{Chunk::BRICK_SIDE - 1};
+
+        // Brick indices are row-major, see `Chunk::brick_index_of`
+        for (usize brick = 0; brick < 8 * sizeof(u64); ++brick) {
+            auto const brick_pos =
+                LinearLayout::pos_of(brick, n_bricks) * (u32) Chunk::BRICK_SIDE;
+
+            tmine_assert_eq(
+                chunk->is_brick_empty(brick_pos), brick_pos != brick_lo,
+                "{}", index
+            );
+        }
+
+        chunk->set_voxel(pos, Voxel{});
+        tmine_assert(chunk->is_empty());
+    }
+}
+
+auto test_morton_chunk_tiles_round_trip() -> void {
+    using Layout = MortonLayout<ChunkArray::N_TILE_BITS>;
+
+    auto constexpr TILE_SIDE = u32{1} << ChunkArray::N_TILE_BITS;
+    auto constexpr TILE_VOLUME = usize{TILE_SIDE * TILE_SIDE * TILE_SIDE};
+
+    auto const sizes = glm::uvec3{8, 4, 12};
+    auto const volume = (usize) sizes.x * sizes.y * sizes.z;
+    auto is_visited = std::vector<bool>(volume, false);
+
+    for (u32 y = 0; y < sizes.y; ++y) {
+        for (u32 z = 0; z < sizes.z; ++z) {
+            for (u32 x = 0; x < sizes.x; ++x) {
+                auto const pos = glm::uvec3{x, y, z};
+                auto const index = Layout::index_of(pos, sizes);
+
+                tmine_assert(index < volume, "{}", index);
+                tmine_assert(!is_visited[index], "{}", index);
+                tmine_assert(Layout::pos_of(index, sizes) == pos);
+
+                is_visited[index] = true;
+
+                // Chunks of one tile form a contiguous aligned run
+                auto const tile_corner =
+                    Layout::pos_of(index / TILE_VOLUME * TILE_VOLUME, sizes);
+
+                tmine_assert(tile_corner == (pos & ~(TILE_SIDE - 1)));
+            }
+        }
+    }
+
+    // The layout the build selects finds every chunk where it was placed
+    auto const chunks = ChunkArray{{4, 4, 8}};
+    auto const chunk_sizes = chunks.size();
+
+    for (usize index = 0; index < chunks.chunk_count(); ++index) {
+        auto const pos = chunks.index_to_pos(index);
+
+        tmine_assert(glm::all(glm::lessThan(pos, chunk_sizes)), "{}", index);
+        tmine_assert_eq(chunks.index_of(pos), index);
+        tmine_assert(chunks.chunk(pos)->get_pos() == pos, "{}", index);
+    }
+}
+
+auto test_chunk_voxel_counts() -> void {
+    auto chunks = ChunkArray{{4, 4, 4}};
+    auto const chunk = chunks.chunk({1, 2, 3});
+    auto const offset = chunk->get_pos() * Chunk::SIZE;
+
+    fill(&chunks, offset, offset + Chunk::SIZE - 1u, Voxel{2, 0});
+    tmine_assert(chunk->is_full());
+    tmine_assert_eq(chunk->count_of(2), Chunk::VOLUME);
+
+    chunks.set_voxel(offset + glm::uvec3{3, 4, 5}, Voxel{5, 0});
+    chunks.set_voxel(offset + glm::uvec3{6, 7, 8}, Voxel{});
+    tmine_assert(!chunk->is_full());
+    tmine_assert_eq(chunk->count_of(2), Chunk::VOLUME - 2);
+    tmine_assert_eq(chunk->count_of(5), 1);
+    tmine_assert_eq(chunk->solid_count(), Chunk::VOLUME - 1);
+
+    fill(&chunks, offset, offset + Chunk::SIZE - 1u, Voxel{});
+    tmine_assert_eq(chunk->solid_count(), 0);
+    tmine_assert(chunk->is_empty());
+}
+
+auto test_ray_cast_axis_aligned() -> void {
+    auto chunks = ChunkArray{{4, 4, 4}};
+    auto const target = glm::uvec3{20, 62, 33};
+
+    fill(&chunks, {0, 62, 33}, {20, 63, 33}, Voxel{});
+    chunks.set_voxel(target, Voxel{4, 0});
+
+    auto const down = chunks.ray_cast(
+        glm::vec3{20.5f, 63.5f, 33.5f}, glm::vec3{0.0f, -1.0f, 0.0f}, 8.0f
+    );
+
+    tmine_assert(down.has_hit);
+    tmine_assert_eq(down.voxel.id, 4);
+    tmine_assert(down.voxel_pos == target);
+    tmine_assert(down.normal == glm::vec3(0.0f, 1.0f, 0.0f));
+
+    auto const from_outside = chunks.ray_cast(
+        glm::vec3{-100.5f, 62.5f, 33.5f}, glm::vec3{1.0f, 0.0f, 0.0f}, 512.0f
+    );
+
+    tmine_assert(from_outside.has_hit);
+    tmine_assert(from_outside.voxel_pos == target);
+    tmine_assert(from_outside.normal == glm::vec3(-1.0f, 0.0f, 0.0f));
+
+    auto const too_short = chunks.ray_cast(
+        glm::vec3{-100.5f, 62.5f, 33.5f}, glm::vec3{1.0f, 0.0f, 0.0f}, 64.0f
+    );
+
+    tmine_assert(!too_short.has_hit);
+}
+
+auto test_ray_cast_matches_reference() -> void {
+    auto const chunks = make_test_world();
+    auto const world_size = glm::vec3{chunks.size() * Chunk::SIZE};
+
+    auto rng = std::mt19937{42};
+    auto position = std::uniform_real_distribution<f32>{-0.25f, 1.25f};
+    auto direction = std::normal_distribution<f32>{0.0f, 1.0f};
+
+    for (usize i = 0; i < 4096; ++i) {
+        auto const origin =
+            world_size *
+            glm::vec3{position(rng), position(rng), position(rng)};
+
+        auto const dir = glm::normalize(
+            glm::vec3{direction(rng), direction(rng), direction(rng)}
+        );
+
+        auto const max_distance = std::array{8.0f, 64.0f, 512.0f}[i % 3];
+
+        auto const expected =
+            reference_ray_cast(chunks, origin, dir, max_distance);
+        auto const result = chunks.ray_cast(origin, dir, max_distance);
+
+        tmine_assert_eq(result.has_hit, expected.has_hit, "ray #{}", i);
+
+        if (!result.has_hit) {
+            continue;
+        }
+
+        tmine_assert(result.voxel_pos == expected.voxel_pos, "ray #{}", i);
+        tmine_assert(result.hit_pos == expected.hit_pos, "ray #{}", i);
+        tmine_assert(result.normal == expected.normal, "ray #{}", i);
+        tmine_assert_eq(result.voxel.id, expected.voxel.id, "ray #{}", i);
+        tmine_assert_ne(result.voxel.id, 0);
+    }
+}
+
+auto test_ray_cast_passes_through_edges() -> void {
+    auto const chunks = make_test_world();
+    auto const world_size = glm::ivec3{chunks.size() * Chunk::SIZE};
+
+    auto rng = std::mt19937{5};
+    auto position = std::uniform_int_distribution<i32>{-16, world_size.x + 16};
+    auto component = std::uniform_int_distribution<i32>{-2, 2};
+
+    // Rays from voxel corners along lattice directions cross several
+    // boundaries at once, which is where rounding used to pick other voxels
+    for (usize i = 0; i < 4096; ++i) {
+        auto const origin =
+            glm::vec3{position(rng), position(rng), position(rng)} +
+            0.5f * glm::vec3{(f32) (i % 2), (f32) (i / 2 % 2), 0.0f};
+
+        auto direction = glm::vec3{component(rng), component(rng), 1.0f};
+        direction = glm::normalize(direction);
+
+        auto const expected =
+            reference_ray_cast(chunks, origin, direction, 128.0f);
+        auto const result = chunks.ray_cast(origin, direction, 128.0f);
+
+        tmine_assert_eq(result.has_hit, expected.has_hit, "ray #{}", i);
+
+        if (result.has_hit) {
+            tmine_assert(result.voxel_pos == expected.voxel_pos, "ray #{}", i);
+            tmine_assert(result.normal == expected.normal, "ray #{}", i);
+        }
+    }
+}
+
+auto test_ray_cast_rejects_degenerate_rays() -> void {
+    auto chunks = ChunkArray{{2, 2, 2}};
+    fill(&chunks, {0, 0, 0}, {31, 31, 31}, Voxel{4, 0});
+
+    auto const nan = std::numeric_limits<f32>::quiet_NaN();
+    auto const infinity = std::numeric_limits<f32>::infinity();
+    auto const inside = glm::vec3{8.5f, 8.5f, 8.5f};
+
+    auto const rays = std::array{
+        Ray{inside, glm::vec3{0.0f}, 16.0f},
+        Ray{inside, glm::vec3{nan, 1.0f, 0.0f}, 16.0f},
+        Ray{inside, glm::vec3{0.0f, infinity, 0.0f}, 16.0f},
+        Ray{inside, glm::vec3{0.0f, 0.0f, -infinity}, 16.0f},
+        Ray{glm::vec3{nan, 8.5f, 8.5f}, glm::vec3{1.0f, 0.0f, 0.0f}, 16.0f},
+        Ray{glm::vec3{1e30f}, glm::vec3{-1.0f, 0.0f, 0.0f}, 16.0f},
+        Ray{inside, glm::vec3{1.0f, 0.0f, 0.0f}, nan},
+        Ray{inside, glm::vec3{1.0f, 0.0f, 0.0f}, infinity},
+    };
+
+    for (usize i = 0; i < rays.size(); ++i) {
+        auto const result = chunks.ray_cast(
+            rays[i].origin, rays[i].direction, rays[i].max_distance
+        );
+
+        tmine_assert(!result.has_hit, "ray #{}", i);
+    }
+
+    // A valid ray sharing a packet with degenerate ones still hits
+    auto batch = std::vector<Ray>{Ray{inside, glm::vec3{0.0f, 0.0f, 1.0f}}};
+    batch.insert(batch.end(), rays.begin(), rays.end());
+
+    auto results = std::vector<RayCastResult>(batch.size());
+    chunks.ray_cast_batch(batch, results);
+
+    tmine_assert(results[0].has_hit);
+    tmine_assert(results[0].voxel_pos == glm::uvec3{8, 8, 8});
+
+    for (usize i = 1; i < batch.size(); ++i) {
+        tmine_assert(!results[i].has_hit, "ray #{}", i - 1);
+    }
+}
+
+auto test_ray_cast_batch_matches_single() -> void {
+    auto const chunks = make_test_world();
+    auto const world_size = glm::vec3{chunks.size() * Chunk::SIZE};
+
+    auto rng = std::mt19937{7};
+    auto position = std::uniform_real_distribution<f32>{-0.25f, 1.25f};
+    auto direction = std::normal_distribution<f32>{0.0f, 1.0f};
+
+    // Not a multiple of the packet size, so the last packet is partial
+    auto rays = std::vector<Ray>(1021);
+
+    for (auto& ray : rays) {
+        ray = Ray{
+            .origin = world_size *
+                      glm::vec3{position(rng), position(rng), position(rng)},
+            .direction = glm::normalize(
+                glm::vec3{direction(rng), direction(rng), direction(rng)}
+            ),
+            .max_distance = 96.0f,
+        };
+    }
+
+    auto results = std::vector<RayCastResult>(rays.size());
+    chunks.ray_cast_batch(rays, results);
+
+    for (usize i = 0; i < rays.size(); ++i) {
+        auto const expected = chunks.ray_cast(
+            rays[i].origin, rays[i].direction, rays[i].max_distance
+        );
+
+        tmine_assert_eq(results[i].has_hit, expected.has_hit, "ray #{}", i);
+        tmine_assert_eq(results[i].voxel.id, expected.voxel.id, "ray #{}", i);
+        tmine_assert(results[i].voxel_pos == expected.voxel_pos, "ray #{}", i);
+        tmine_assert(results[i].hit_pos == expected.hit_pos, "ray #{}", i);
+        tmine_assert(results[i].normal == expected.normal, "ray #{}", i);
+    }
+}
+
+auto test_solid_cells_match_scan() -> void {
+    auto const chunks = make_test_world();
+    auto const world_size = chunks.size() * Chunk::SIZE;
+
+    auto rng = std::mt19937{99};
+
+    for (usize i = 0; i < 256; ++i) {
+        // Boxes may stick out of the world, those voxels count as air
+        auto const lo = glm::uvec3{
+            rng() % world_size.x, rng() % world_size.y, rng() % world_size.z
+        };
+        auto const hi = lo + glm::uvec3{rng() % 20, rng() % 20, rng() % 20};
+
+        auto expected = std::vector<glm::uvec3>{};
+
+        for (u32 y = lo.y; y <= hi.y; ++y) {
+            for (u32 z = lo.z; z <= hi.z; ++z) {
+                for (u32 x = lo.x; x <= hi.x; ++x) {
+                    auto const voxel = chunks.get_voxel({x, y, z});
+
+                    if (voxel.has_value() && 0 != voxel->id) {
+                        expected.push_back({x, y, z});
+                    }
+                }
+            }
+        }
+
+        auto cells = std::vector<glm::uvec3>{};
+        chunks.solid_cells_in(lo, hi, &cells);
+
+        auto const by_position = [](glm::uvec3 left, glm::uvec3 right) {
+            return std::tie(left.y, left.z, left.x) <
+                   std::tie(right.y, right.z, right.x);
+        };
+
+        std::ranges::sort(cells, by_position);
+
+        tmine_assert_eq(cells.size(), expected.size(), "box #{}", i);
+        tmine_assert(cells == expected, "box #{}", i);
+        tmine_assert_eq(
+            chunks.any_solid_in(lo, hi), !expected.empty(), "box #{}", i
+        );
+    }
+}
+
+auto test_paste_structure_marks_chunks() -> void {
+    auto chunks = ChunkArray{{4, 4, 4}};
+    auto structure = VoxelStructure{{20, 3, 5}};
+    auto const lo = glm::uvec3{10, 30, 14};
+    auto const hi = lo + structure.get_size() - 1u;
+    auto const background = Voxel{7, 0};
+
+    // A wall of air keeps the terrain behind it
+    for (u32 y = 0; y < 3; ++y) {
+        for (u32 z = 0; z < 5; ++z) {
+            for (u32 x = 0; x < 20; ++x) {
+                if (5 != x) {
+                    auto const id = (VoxelId) (1 + (x + y + z) % 3);
+                    structure.set_voxel({x, y, z}, Voxel{id, 0});
+                }
+            }
+        }
+    }
+
+    fill(&chunks, lo, hi, background);
+
+    auto edits = std::vector<std::tuple<glm::uvec3, glm::uvec3, glm::uvec3>>{};
+
+    chunks.paste_structure(
+        structure, lo,
+        [&](glm::uvec3 chunk_pos, glm::uvec3 local_lo, glm::uvec3 local_hi) {
+            edits.emplace_back(chunk_pos, local_lo, local_hi);
+        }
+    );
+
+    for (u32 y = lo.y; y <= hi.y; ++y) {
+        for (u32 z = lo.z; z <= hi.z; ++z) {
+            for (u32 x = lo.x; x <= hi.x; ++x) {
+                auto const pos = glm::uvec3{x, y, z};
+                auto const expected = 5 == x - lo.x
+                                          ? background
+                                          : structure.get_voxel(pos - lo);
+
+                tmine_assert_eq(chunks.get_voxel(pos)->id, expected.id);
+            }
+        }
+    }
+
+    // The structure spans two chunks along every axis
+    tmine_assert_eq(edits.size(), usize{8});
+
+    for (usize i = 0; i < edits.size(); ++i) {
+        auto const [chunk_pos, local_lo, local_hi] = edits[i];
+        auto const offset = chunk_pos * Chunk::SIZE;
+
+        tmine_assert(glm::max(lo, offset) - offset == local_lo);
+        tmine_assert(
+            glm::min(hi, offset + Chunk::SIZE - 1u) - offset == local_hi
+        );
+
+        for (usize j = 0; j < i; ++j) {
+            tmine_assert(std::get<0>(edits[j]) != chunk_pos);
+        }
+    }
+
+    // Empty structures must not wrap around to the far end of the world
+    auto n_empty_edits = usize{0};
+
+    chunks.paste_structure(
+        VoxelStructure{{0, 3, 5}}, lo,
+        [&](glm::uvec3, glm::uvec3, glm::uvec3) { ++n_empty_edits; }
+    );
+
+    tmine_assert_eq(n_empty_edits, usize{0});
+}
+
+}  // namespace tmine_test
@@ -0,0 +1,17 @@
+#pragma once
+
+namespace tmine_test {
+
+auto test_chunk_brick_mask() -> void;
+auto test_morton_layout_round_trips() -> void;
+auto test_morton_chunk_tiles_round_trip() -> void;
+auto test_chunk_voxel_counts() -> void;
+auto test_ray_cast_axis_aligned() -> void;
+auto test_ray_cast_matches_reference() -> void;
+auto test_ray_cast_passes_through_edges() -> void;
+auto test_ray_cast_rejects_degenerate_rays() -> void;
+auto test_ray_cast_batch_matches_single() -> void;
+auto test_solid_cells_match_scan() -> void;
+auto test_paste_structure_marks_chunks() -> void;
+
+}
@@ -0,0 +1,120 @@
+#include <array>
+#include <vector>
+
+#include "gui.hpp"
+#include "loaders.hpp"
+#include "widgets.hpp"
+#include "assert.hpp"
+
+namespace tmine_test {
+
+using namespace tmine;
+
+/// Quad with every vertex at `marker`, so that it can be found after
+/// sorting.
+static auto marked_quad(f32 marker) -> std::array<GuiObject::Vertex, 6> {
+    auto result = std::array<GuiObject::Vertex, 6>{};
+
+    for (auto& vertex : result) {
+        vertex.pos = glm::vec2{marker};
+    }
+
+    return result;
+}
+
+auto test_gui_batches_are_sorted() -> void {
+    auto batcher = GuiBatcher{};
+
+    auto const keys = std::array{
+        GuiBatchKey{.layer = GuiLayer::Labels, .texture_id = 7},
+        GuiBatchKey{.layer = GuiLayer::Widgets, .texture_id = 2},
+        GuiBatchKey{.layer = GuiLayer::Background, .texture_id = 9},
+        GuiBatchKey{.layer = GuiLayer::Widgets, .texture_id = 1},
+        GuiBatchKey{.layer = GuiLayer::Widgets, .texture_id = 2},
+        GuiBatchKey{.layer = GuiLayer::Labels, .texture_id = 7},
+    };
+
+    for (usize i = 0; i < keys.size(); ++i) {
+        batcher.push(keys[i], marked_quad((f32) i));
+    }
+
+    batcher.build();
+
+    auto const vertices = batcher.get_vertices();
+    auto const batches = batcher.get_batches();
+
+    tmine_assert_eq(vertices.size(), 6 * keys.size());
+    tmine_assert_eq(batches.size(), usize{4});
+
+    // Layers go in order, equal keys are merged keeping the push order
+    auto const expected_markers =
+        std::array{2.0f, 3.0f, 1.0f, 4.0f, 0.0f, 5.0f};
+    auto const expected_counts = std::array{u32{6}, u32{6}, u32{12}, u32{12}};
+
+    for (usize i = 0; i < expected_markers.size(); ++i) {
+        tmine_assert_eq(vertices[6 * i].pos.x, expected_markers[i], "#{}", i);
+    }
+
+    auto next_first = u32{0};
+
+    for (usize i = 0; i < batches.size(); ++i) {
+        tmine_assert_eq(batches[i].first, next_first, "batch #{}", i);
+        tmine_assert_eq(batches[i].count, expected_counts[i], "batch #{}", i);
+
+        if (i > 0) {
+            tmine_assert(
+                batches[i - 1].key.packed() < batches[i].key.packed(),
+                "batch #{}", i
+            );
+        }
+
+        next_first += batches[i].count;
+    }
+
+    batcher.clear();
+    batcher.build();
+
+    tmine_assert(batcher.get_vertices().empty());
+    tmine_assert(batcher.get_batches().empty());
+}
+
+auto test_gui_text_is_tessellated_once() -> void {
+    auto const font =
+        std::make_shared<Font>(parse_font_file("assets/fonts/font.fnt"));
+    auto text = Text{font, Texture{}, "Start", glm::vec2{0.0f}, 1.0f};
+    auto batcher = GuiBatcher{};
+
+    text.submit(&batcher);
+    batcher.build();
+
+    auto const before = std::vector<GuiObject::Vertex>(
+        batcher.get_vertices().begin(), batcher.get_vertices().end()
+    );
+
+    tmine_assert_eq(before.size(), usize{6 * 5});
+    tmine_assert_eq(batcher.get_batches().size(), usize{1});
+    tmine_assert(
+        GuiLayer::Labels == batcher.get_batches()[0].key.layer,
+        "labels are drawn over widgets"
+    );
+
+    // Moving only shifts the glyphs, their width stays
+    auto const width = text.get_width();
+    text.set_position(glm::vec2{0.5f, -0.25f});
+
+    batcher.clear();
+    text.submit(&batcher);
+    batcher.build();
+
+    auto const after = batcher.get_vertices();
+
+    tmine_assert_eq(text.get_width(), width);
+
+    for (usize i = 0; i < before.size(); ++i) {
+        tmine_assert_eq(after[i].pos.x, before[i].pos.x + 0.5f, "#{}", i);
+        tmine_assert_eq(after[i].pos.y, before[i].pos.y - 0.25f, "#{}", i);
+        tmine_assert_eq(after[i].uv.x, before[i].uv.x, "#{}", i);
+    }
+}
+
+}  // namespace tmine_test
@@ -0,0 +1,8 @@
+#pragma once
+
+namespace tmine_test {
+
+auto test_gui_batches_are_sorted() -> void;
+auto test_gui_text_is_tessellated_once() -> void;
+
+}